@@ -0,0 +1,90 @@
+/**
+ *  @file
+ *
+ *  Accuracy of CBusyDelay across delay sizes, on the TSC and on 
+ *  CLOCK_MONOTONIC_RAW, against nanosleep(). Every delay is timed 
+ *  on its own with the TSC into a CLatencyHistogram; the counters are
+ *  how far past the requested delay the mean and the 99th percentile
+ *  landed, in ns, including the ~20ns of the timing reads.
+ *
+ *  To run:
+ *  ./benchmark_busy_delay
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdint>
+#include <ctime>
+#include <benchmark/benchmark.h>
+
+#include "time_utilities.hpp"
+#include "tsc_clock.hpp"
+#include "latency_histogram.hpp"
+#include "busy_delay.hpp"
+
+
+template <typename Delay>
+static void MeasureDelays(benchmark::State& state, Delay delay)
+{
+    const CTscClock &tsc = CTscClock::Instance();
+    CLatencyHistogram histogram;
+    uint64_t ns = (uint64_t)state.range(0);
+
+    for (auto _ : state) {
+        uint64_t start = CTscClock::Read();
+        delay(ns);
+        uint64_t end = CTscClock::Read();
+        histogram.Record(tsc.TicksToDuration(end - start));
+    }
+
+    state.counters["mean_over_ns"] = (double)histogram.Mean() - (double)ns;
+    state.counters["p99_over_ns"] = (double)histogram.Percentile(99) - (double)ns;
+}
+
+
+static void BM_CBusyDelay_Tsc(benchmark::State& state)
+{
+    const CBusyDelay &delay = CBusyDelay::Instance();
+    MeasureDelays(state, [&delay](uint64_t ns) { delay.DelayNs(ns); });
+}
+BENCHMARK(BM_CBusyDelay_Tsc)->Arg(50)->Arg(100)->Arg(300)->Arg(1000)->Arg(3000)->Arg(10000)->Arg(100000);
+
+
+static void BM_CBusyDelay_MonotonicRaw(benchmark::State& state)
+{
+    static const CBusyDelay delay(false);
+    MeasureDelays(state, [](uint64_t ns) { delay.DelayNs(ns); });
+}
+BENCHMARK(BM_CBusyDelay_MonotonicRaw)->Arg(50)->Arg(100)->Arg(300)->Arg(1000)->Arg(3000)->Arg(10000)->Arg(100000);
+
+
+static void BM_nanosleep(benchmark::State& state)
+{
+    MeasureDelays(state, [](uint64_t ns) {
+        struct timespec ts = {(time_t)(ns / NS_IN_SECOND), (long)(ns % NS_IN_SECOND)};
+        nanosleep(&ts, NULL);
+    });
+}
+BENCHMARK(BM_nanosleep)->Arg(300)->Arg(1000)->Arg(10000)->Arg(100000);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,125 @@
+/**
+ *  @file
+ *
+ *  Benchmarks of the CPU time clocks and CCpuStopwatch against
+ *  getrusage(), the usual alternative for CPU accounting.
+ *
+ *  To run:
+ *  ./benchmark_cpu_clocks
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <sys/resource.h>
+#include <benchmark/benchmark.h>
+
+#define USING_TIMEVAL
+#include "time_utilities.hpp"
+#include "cpu_stopwatch.hpp"
+
+
+static void BM_CTimeSpec_NowThreadCpu(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CTimeSpec::NowThreadCpu());
+    }
+}
+BENCHMARK(BM_CTimeSpec_NowThreadCpu);
+
+
+static void BM_CTimeSpec_NowProcessCpu(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CTimeSpec::NowProcessCpu());
+    }
+}
+BENCHMARK(BM_CTimeSpec_NowProcessCpu);
+
+
+static void BM_CTimeSpec_NowForClock(benchmark::State& state)
+{
+    clockid_t clock = static_cast<clockid_t>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CTimeSpec::NowForClock(clock));
+    }
+}
+BENCHMARK(BM_CTimeSpec_NowForClock)
+    ->Arg(CLOCK_MONOTONIC)->Arg(CLOCK_MONOTONIC_COARSE)->Arg(CLOCK_BOOTTIME);
+
+
+static void BM_getrusage_thread(benchmark::State& state)
+{
+    struct rusage usage;
+    for (auto _ : state) {
+        getrusage(RUSAGE_THREAD, &usage);
+        benchmark::DoNotOptimize(usage);
+    }
+}
+BENCHMARK(BM_getrusage_thread);
+
+
+static void BM_getrusage_self(benchmark::State& state)
+{
+    struct rusage usage;
+    for (auto _ : state) {
+        getrusage(RUSAGE_SELF, &usage);
+        benchmark::DoNotOptimize(usage);
+    }
+}
+BENCHMARK(BM_getrusage_self);
+
+
+/**
+ *  Start and read a stopwatch, i.e. the full cost of measuring 
+ *  one scope.
+ */
+static void BM_CCpuStopwatch_Scope(benchmark::State& state)
+{
+    for (auto _ : state) {
+        CCpuStopwatch stopwatch;
+        benchmark::DoNotOptimize(stopwatch.Elapsed());
+    }
+}
+BENCHMARK(BM_CCpuStopwatch_Scope);
+
+
+/**
+ *  The same measurement done with getrusage and the monotonic clock.
+ */
+static void BM_getrusage_Scope(benchmark::State& state)
+{
+    struct rusage start, end;
+    for (auto _ : state) {
+        CTimeSpec wall_start = CTimeSpec::NowMonotonic();
+        getrusage(RUSAGE_THREAD, &start);
+        getrusage(RUSAGE_THREAD, &end);
+        CTimeSpec wall = CTimeSpec::NowMonotonic() - wall_start;
+        CTimeVal cpu = CTimeVal(end.ru_utime) + CTimeVal(end.ru_stime) 
+                     - CTimeVal(start.ru_utime) - CTimeVal(start.ru_stime);
+        benchmark::DoNotOptimize(wall);
+        benchmark::DoNotOptimize(cpu);
+    }
+}
+BENCHMARK(BM_getrusage_Scope);
+
+
+BENCHMARK_MAIN();
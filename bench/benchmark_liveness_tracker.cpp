@@ -0,0 +1,172 @@
+/**
+ *  @file
+ *
+ *  Touch rate and sweep cost of CLivenessTracker, against the array 
+ *  of last seen times that is scanned whole every second. Time is 
+ *  simulated, so clock reads are not part of the numbers.
+ *
+ *  The sweep benchmarks run one simulated second per iteration: a 
+ *  tenth of the entities heartbeat (each once every 10s), about 1% of
+ *  those skip it, and a 15s timeout expires the ones that skipped.
+ *
+ *  To run:
+ *  ./benchmark_liveness_tracker
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdint>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "time_utilities.hpp"
+#include "liveness_tracker.hpp"
+
+
+#define TIMEOUT_S       (15)
+#define HEARTBEAT_S     (10)
+
+
+static CTimeSpec Seconds(int64_t s)
+{
+    return CTimeSpec((time_t)s, 0);
+}
+
+
+/**
+ *  Whether an entity skips its heartbeat in a round.
+ */
+static bool Skips(uint32_t id, int64_t round)
+{
+    return ((id * 2654435761u) >> 7) % 100 == (uint32_t)(round % 100);
+}
+
+
+struct CountExpired
+{
+    size_t *count;
+
+    void operator()(uint32_t)
+    {
+        (*count)++;
+    }
+};
+
+
+static void BM_Touch_LastSeenArray(benchmark::State& state)
+{
+    uint32_t n = (uint32_t)state.range(0);
+    std::vector<int64_t> last(n, -1);
+    uint64_t rng = 88172645463325252ULL;
+    int64_t now = 1000000000;
+
+    for (auto _ : state) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        last[rng % n] = now++;
+    }
+    benchmark::DoNotOptimize(last.data());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Touch_LastSeenArray)->Arg(1 << 20)->Arg(5000000);
+
+
+static void BM_Touch_CLivenessTracker(benchmark::State& state)
+{
+    uint32_t n = (uint32_t)state.range(0);
+    CLivenessTracker tracker(n, Seconds(TIMEOUT_S), CTimeSpec(0, 100000000));
+    uint64_t rng = 88172645463325252ULL;
+    CTimeSpec now = Seconds(1000);
+
+    for (auto _ : state) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        tracker.Touch((uint32_t)(rng % n), now);
+        now += CTimeSpec(0, 1000);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes_per_entity"] = (double)tracker.MemoryUsage() / n;
+}
+BENCHMARK(BM_Touch_CLivenessTracker)->Arg(1 << 20)->Arg(5000000);
+
+
+static void BM_Sweep_LastSeenArray(benchmark::State& state)
+{
+    uint32_t n = (uint32_t)state.range(0);
+    std::vector<int64_t> last(n);
+    int64_t second = 0;
+    size_t expired = 0;
+
+    for (uint32_t id = 0; id < n; id++)
+        last[id] = id % HEARTBEAT_S;
+    second = HEARTBEAT_S;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (uint32_t id = (uint32_t)(second % HEARTBEAT_S); id < n; id += HEARTBEAT_S)
+            if (!Skips(id, second / HEARTBEAT_S))
+                last[id] = second;
+        state.ResumeTiming();
+
+        for (uint32_t id = 0; id < n; id++) {
+            if (last[id] >= 0 && last[id] + TIMEOUT_S <= second) {
+                last[id] = -1;
+                expired++;
+            }
+        }
+        second++;
+    }
+    state.counters["expired_per_sweep"] = (double)expired / state.iterations();
+}
+BENCHMARK(BM_Sweep_LastSeenArray)->Arg(1 << 20)->Arg(5000000);
+
+
+static void BM_Sweep_CLivenessTracker(benchmark::State& state)
+{
+    uint32_t n = (uint32_t)state.range(0);
+    CLivenessTracker tracker(n, Seconds(TIMEOUT_S), CTimeSpec(0, 100000000));
+    int64_t second = 0;
+    size_t expired = 0;
+    CountExpired count {&expired};
+
+    for (uint32_t id = 0; id < n; id++)
+        tracker.Touch(id, Seconds(id % HEARTBEAT_S));
+    second = HEARTBEAT_S;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (uint32_t id = (uint32_t)(second % HEARTBEAT_S); id < n; id += HEARTBEAT_S)
+            if (!Skips(id, second / HEARTBEAT_S))
+                tracker.Touch(id, Seconds(second));
+        state.ResumeTiming();
+
+        tracker.Expire(Seconds(second), count);
+        second++;
+    }
+    state.counters["expired_per_sweep"] = (double)expired / state.iterations();
+}
+BENCHMARK(BM_Sweep_CLivenessTracker)->Arg(1 << 20)->Arg(5000000);
+
+
+BENCHMARK_MAIN();
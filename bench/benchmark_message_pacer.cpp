@@ -0,0 +1,107 @@
+/**
+ *  @file
+ *
+ *  Achieved rate and departure jitter of CMessagePacer against the 
+ *  pacer it replaces, one nanosleep() of the rounded interval per
+ *  message. Each run sends 100ms worth of messages at the rate given
+ *  as the argument. Counters: the rate achieved, and the standard
+ *  deviation and 99th percentile of how late each departure was
+ *  against its exact due time, in ns.
+ *
+ *  To run:
+ *  ./benchmark_message_pacer
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <benchmark/benchmark.h>
+
+#include "time_utilities.hpp"
+#include "latency_histogram.hpp"
+#include "message_pacer.hpp"
+
+
+static int64_t NowNs()
+{
+    struct timespec ts = CTimeSpec::NowMonotonic().c_timespec();
+    return (int64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+}
+
+
+static void BM_nanosleep_Pacer(benchmark::State& state)
+{
+    uint64_t rate = (uint64_t)state.range(0);
+    uint64_t count = rate / 10;
+    struct timespec interval = {0, (long)(NS_IN_SECOND / rate)};
+    CLatencyHistogram lateness;
+    double sum = 0, sum_squares = 0, achieved = 0;
+
+    for (auto _ : state) {
+        int64_t start = NowNs();
+        int64_t now = start;
+        for (uint64_t n = 0; n < count; n++) {
+            if (n > 0)
+                nanosleep(&interval, NULL);
+            now = NowNs();
+            int64_t due = start + (int64_t)((unsigned __int128)n * NS_IN_SECOND / rate);
+            double late = (double)(now - due);
+            lateness.Record((uint64_t)(late > 0 ? late : 0));
+            sum += late;
+            sum_squares += late * late;
+        }
+        achieved = (double)count * NS_IN_SECOND / (double)(now - start);
+    }
+
+    double n = (double)lateness.Count();
+    state.counters["rate"] = achieved;
+    state.counters["jitter_ns"] = std::sqrt(sum_squares / n - (sum / n) * (sum / n));
+    state.counters["p99_late_ns"] = (double)lateness.Percentile(99);
+}
+BENCHMARK(BM_nanosleep_Pacer)->Arg(10000)->Arg(100000)->Arg(1000000)
+    ->Iterations(1)->Unit(benchmark::kMillisecond);
+
+
+static void BM_CMessagePacer(benchmark::State& state)
+{
+    uint64_t rate = (uint64_t)state.range(0);
+    uint64_t count = rate / 10;
+    CMessagePacer pacer(rate);
+
+    for (auto _ : state) {
+        pacer.Start();
+        for (uint64_t sent = 0; sent < count; )
+            sent += pacer.Wait(64);
+    }
+
+    state.counters["rate"] = pacer.AchievedRate();
+    state.counters["jitter_ns"] = pacer.JitterNs();
+    state.counters["p99_late_ns"] = (double)pacer.Lateness().Percentile(99);
+    state.counters["batched"] = (double)pacer.Batched();
+}
+BENCHMARK(BM_CMessagePacer)->Arg(10000)->Arg(100000)->Arg(1000000)
+    ->Iterations(1)->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
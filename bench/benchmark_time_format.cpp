@@ -0,0 +1,289 @@
+/**
+ *  @file
+ *
+ *  Benchmarks of the formatters in time_format.hpp against the 
+ *  usual alternatives (printf of a double, iostreams, strftime), 
+ *  and of the fmt formatters when fmt is installed.
+ *
+ *  To run:
+ *  ./benchmark_time_format
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#ifdef TIME_UTILITIES_HAVE_FMT
+#include <fmt/format.h>
+#endif
+
+#include "time_utilities.hpp"
+#include "time_format.hpp"
+
+
+/**
+ *  Size of the value arrays. Bulk benchmarks report items/s, 
+ *  the target being the tens of millions per second that 
+ *  shortest-double printers like Ryu reach.
+ */
+#define VALUES  (1024)
+
+
+static std::vector<CTimeSpec> MakeDurations()
+{
+    std::vector<CTimeSpec> v;
+    uint64_t state = 88172645463325252ULL;
+
+    for (int i = 0; i < VALUES; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        //
+        //  Latency like values, from nanoseconds up to minutes.
+        //
+        uint64_t ns = state >> (state % 32 + 24);
+        v.push_back(CTimeSpec((time_t)(ns / NS_IN_SECOND), (long)(ns % NS_IN_SECOND)));
+    }
+    return v;
+}
+
+
+static void BM_FormatSeconds(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeDurations();
+    int digits = (int)state.range(0);
+    char buffer[SECONDS_FORMAT_MAX];
+
+    for (auto _ : state) {
+        for (const CTimeSpec &value : values) {
+            benchmark::DoNotOptimize(FormatSeconds(buffer, sizeof(buffer), value, digits));
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_FormatSeconds)->Arg(3)->Arg(6)->Arg(9);
+
+
+static void BM_snprintf_double(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeDurations();
+    int digits = (int)state.range(0);
+    char buffer[64];
+
+    for (auto _ : state) {
+        for (const CTimeSpec &value : values) {
+            struct timespec ts = value.c_timespec();
+            double seconds = ts.tv_sec + ts.tv_nsec / 1e9;
+            benchmark::DoNotOptimize(snprintf(buffer, sizeof(buffer), "%.*f", digits, seconds));
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_snprintf_double)->Arg(3)->Arg(6)->Arg(9);
+
+
+static void BM_ostream(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeDurations();
+
+    for (auto _ : state) {
+        std::ostringstream os;
+        for (const CTimeSpec &value : values) {
+            os << value;
+        }
+        benchmark::DoNotOptimize(os.str());
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_ostream);
+
+
+static void BM_CSecondsExporter(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeDurations();
+    std::vector<char> buffer(VALUES * (SECONDS_FORMAT_MAX + 1));
+
+    for (auto _ : state) {
+        CSecondsExporter exporter {buffer.data(), buffer.size(), 6};
+        benchmark::DoNotOptimize(exporter.Add(values.data(), values.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_CSecondsExporter);
+
+
+/**
+ *  Log line timestamps: a steady stream of times a few hundred 
+ *  microseconds apart.
+ */
+static std::vector<CTimeSpec> MakeTimestamps()
+{
+    std::vector<CTimeSpec> v;
+    CTimeSpec t {1481213045, 0};
+
+    for (int i = 0; i < VALUES; i++) {
+        t += CTimeSpec(0, 123457 * (i % 7 + 1));
+        v.push_back(t);
+    }
+    return v;
+}
+
+
+static void BM_strftime(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    char buffer[64];
+
+    for (auto _ : state) {
+        for (const CTimeSpec &value : values) {
+            struct timespec ts = value.c_timespec();
+            struct tm tm;
+            gmtime_r(&ts.tv_sec, &tm);
+            size_t n = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+            n += snprintf(buffer + n, sizeof(buffer) - n, ".%06ld", ts.tv_nsec / 1000);
+            benchmark::DoNotOptimize(n);
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_strftime);
+
+
+static void BM_CTimeFormat(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    CTimeFormat format {"%Y-%m-%d %H:%M:%S.%6N"};
+    char buffer[64];
+
+    for (auto _ : state) {
+        for (const CTimeSpec &value : values) {
+            benchmark::DoNotOptimize(format.Format(buffer, sizeof(buffer), value));
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_CTimeFormat);
+
+
+static void BM_FormatDuration(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeDurations();
+    char buffer[DURATION_FORMAT_MAX];
+
+    for (auto _ : state) {
+        for (const CTimeSpec &value : values) {
+            benchmark::DoNotOptimize(FormatDuration(buffer, sizeof(buffer), value));
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_FormatDuration);
+
+
+/**
+ *  The raw spec writes what operator<< does, so these compare 
+ *  directly against BM_ostream.
+ */
+static void BM_FormatTo_Raw(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeDurations();
+
+    for (auto _ : state) {
+        std::string out;
+        for (const CTimeSpec &value : values) {
+            FormatTo(std::back_inserter(out), value);
+        }
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_FormatTo_Raw);
+
+
+static void BM_FormatTo_Iso8601(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    CTimeFormatSpec spec;
+    bool ok;
+    const char text[] = "i";
+    spec.Parse(text, text + 1, &ok);
+    char buffer[TIME_FORMAT_SPEC_MAX];
+
+    for (auto _ : state) {
+        for (const CTimeSpec &value : values) {
+            benchmark::DoNotOptimize(FormatTo(buffer, value, spec));
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_FormatTo_Iso8601);
+
+
+#ifdef TIME_UTILITIES_HAVE_FMT
+static void BM_fmt_format_to(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeDurations();
+
+    for (auto _ : state) {
+        fmt::memory_buffer out;
+        for (const CTimeSpec &value : values) {
+            fmt::format_to(fmt::appender(out), "{}", value);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_fmt_format_to);
+
+
+static void BM_fmt_format_to_Iso8601(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+
+    for (auto _ : state) {
+        fmt::memory_buffer out;
+        for (const CTimeSpec &value : values) {
+            fmt::format_to(fmt::appender(out), "{:i}\n", value);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_fmt_format_to_Iso8601);
+#endif
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,166 @@
+/**
+ *  @file
+ *
+ *  Throughput of the hashers in time_hash.hpp, and what they do for
+ *  an open addressing table that masks the low bits, against the 
+ *  usual hand written combine of std::hash on the two fields. The
+ *  "probes_per_insert" counter is the mean linear probe length.
+ *
+ *  To run:
+ *  ./benchmark_time_hash
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "time_utilities.hpp"
+#include "time_hash.hpp"
+
+
+/**
+ *  Keys per batch, and slots in the open addressing table.
+ */
+#define VALUES  (4096)
+#define SLOTS   (8192)
+
+
+/**
+ *  The combine people write when there is no std::hash<CTimeSpec>.
+ */
+struct NaiveHash
+{
+    size_t operator()(const CTimeSpec& value) const
+    {
+        struct timespec ts = value.c_timespec();
+        return std::hash<time_t>()(ts.tv_sec) ^ (std::hash<long>()(ts.tv_nsec) << 1);
+    }
+};
+
+
+/**
+ *  Timestamps on a millisecond grid, as per request or per frame
+ *  keys would be.
+ */
+static std::vector<CTimeSpec> MakeTimestamps()
+{
+    std::vector<CTimeSpec> v;
+    CTimeSpec t {1481213045, 0};
+
+    for (int i = 0; i < VALUES; i++) {
+        v.push_back(t);
+        t += CTimeSpec(0, 1000000);
+    }
+    return v;
+}
+
+
+template <typename Hash>
+static void BM_Hash(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    Hash hash;
+
+    for (auto _ : state) {
+        size_t sum = 0;
+        for (const CTimeSpec &value : values)
+            sum += hash(value);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK_TEMPLATE(BM_Hash, NaiveHash);
+BENCHMARK_TEMPLATE(BM_Hash, CTimeSpecHash);
+
+
+/**
+ *  Linear probing into a power of two table, bucket from the low
+ *  bits of the hash.
+ */
+template <typename Hash>
+static void BM_OpenAddressing(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<CTimeSpec> table(SLOTS);
+    std::vector<bool> used(SLOTS);
+    Hash hash;
+    size_t probes = 0;
+
+    for (auto _ : state) {
+        std::fill(used.begin(), used.end(), false);
+        probes = 0;
+        for (const CTimeSpec &value : values) {
+            size_t slot = hash(value) & (SLOTS - 1);
+            while (used[slot] && !(table[slot] == value)) {
+                slot = (slot + 1) & (SLOTS - 1);
+                probes++;
+            }
+            used[slot] = true;
+            table[slot] = value;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+    state.counters["probes_per_insert"] = (double)probes / VALUES;
+}
+BENCHMARK_TEMPLATE(BM_OpenAddressing, NaiveHash);
+BENCHMARK_TEMPLATE(BM_OpenAddressing, CTimeSpecHash);
+
+
+template <typename Hash>
+static void BM_UnorderedSet(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+
+    for (auto _ : state) {
+        std::unordered_set<CTimeSpec, Hash> set(SLOTS);
+        for (const CTimeSpec &value : values)
+            set.insert(value);
+        benchmark::DoNotOptimize(set.size());
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK_TEMPLATE(BM_UnorderedSet, NaiveHash);
+BENCHMARK_TEMPLATE(BM_UnorderedSet, CTimeSpecHash);
+
+
+static void BM_BucketHash(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    CTimeSpecBucketHash hash(state.range(0));
+
+    for (auto _ : state) {
+        size_t sum = 0;
+        for (const CTimeSpec &value : values)
+            sum += hash(value);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_BucketHash)->Arg(10 * NS_IN_MS)->Arg(60 * NS_IN_SECOND)->Arg(1500 * NS_IN_MS);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,187 @@
+/**
+ *  @file
+ *
+ *  Cost of the order preserving keys in time_key.hpp: encoding a
+ *  batch, then sorting and inserting the keys with memcmp, as a
+ *  byte keyed store would, against doing the same with CTimeSpec
+ *  and its operator<.
+ *
+ *  To run:
+ *  ./benchmark_time_key
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "time_utilities.hpp"
+#include "time_key.hpp"
+
+
+/**
+ *  Values per batch.
+ */
+#define VALUES  (4096)
+
+
+typedef std::array<uint8_t, TIME_KEY_SIZE> Key;
+
+
+/**
+ *  memcmp order, which is what a byte keyed store uses.
+ */
+struct KeyLess
+{
+    bool operator()(const Key &lhs, const Key &rhs) const
+    {
+        return memcmp(lhs.data(), rhs.data(), TIME_KEY_SIZE) < 0;
+    }
+};
+
+
+/**
+ *  Event timestamps, out of order, on both sides of the epoch.
+ */
+static std::vector<CTimeSpec> MakeTimestamps()
+{
+    std::vector<CTimeSpec> v;
+    uint64_t state = 88172645463325252ULL;
+
+    for (int i = 0; i < VALUES; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        v.push_back(CTimeSpec((time_t)(state >> 32) - 0x80000000LL, 
+                              (long)(state % NS_IN_SECOND)));
+    }
+    return v;
+}
+
+
+static std::vector<Key> MakeKeys(const std::vector<CTimeSpec> &values)
+{
+    std::vector<Key> keys(values.size());
+    CTimeKey::Encode(keys[0].data(), values.data(), values.size(), sizeof(Key));
+    return keys;
+}
+
+
+static void BM_CTimeKey_Encode(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<uint8_t> out(VALUES * TIME_KEY_SIZE);
+
+    for (auto _ : state) {
+        CTimeKey::Encode(out.data(), values.data(), VALUES);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_CTimeKey_Encode);
+
+
+static void BM_CTimeKey_EncodeAligned(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<uint8_t> out(VALUES * TIME_KEY_ALIGNED_SIZE);
+
+    for (auto _ : state) {
+        CTimeKey::EncodeAligned(out.data(), values.data(), VALUES);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_CTimeKey_EncodeAligned);
+
+
+static void BM_Sort_CTimeSpec(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<CTimeSpec> work;
+
+    for (auto _ : state) {
+        work = values;
+        std::sort(work.begin(), work.end());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_Sort_CTimeSpec);
+
+
+static void BM_Sort_Key_memcmp(benchmark::State& state)
+{
+    std::vector<Key> keys = MakeKeys(MakeTimestamps());
+    std::vector<Key> work;
+
+    for (auto _ : state) {
+        work = keys;
+        std::sort(work.begin(), work.end(), KeyLess());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_Sort_Key_memcmp);
+
+
+static void BM_Insert_CTimeSpec(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+
+    for (auto _ : state) {
+        std::set<CTimeSpec> index;
+        for (const CTimeSpec &value : values)
+            index.insert(value);
+        benchmark::DoNotOptimize(index.size());
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_Insert_CTimeSpec);
+
+
+/**
+ *  Encode and insert, the bulk load path of a byte keyed store.
+ */
+static void BM_Insert_Key_memcmp(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<Key> keys(VALUES);
+
+    for (auto _ : state) {
+        CTimeKey::Encode(keys[0].data(), values.data(), VALUES, sizeof(Key));
+        std::set<Key, KeyLess> index;
+        for (const Key &key : keys)
+            index.insert(key);
+        benchmark::DoNotOptimize(index.size());
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_Insert_Key_memcmp);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,207 @@
+/**
+ *  @file
+ *
+ *  Benchmarks of CTimeParser against strptime + timegm, and of 
+ *  ParseDuration() against a regex.
+ *
+ *  To run:
+ *  ./benchmark_time_parse
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <regex>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "time_utilities.hpp"
+#include "time_format.hpp"
+#include "time_parse.hpp"
+
+
+/**
+ *  Number of rows in the parsed column.
+ */
+#define ROWS    (1024)
+
+
+/**
+ *  An access log style column, seconds apart.
+ */
+static std::vector<std::string> MakeColumn(const char *pattern)
+{
+    std::vector<std::string> v;
+    CTimeFormat format {pattern};
+    char buffer[128];
+
+    for (int i = 0; i < ROWS; i++) {
+        size_t n = format.Format(buffer, sizeof(buffer), CTimeSpec(1481213045 + i * 37, 0));
+        v.push_back(std::string(buffer, n));
+    }
+    return v;
+}
+
+
+static const char *Pattern(int index)
+{
+    static const char *patterns[] = {
+        "%Y-%m-%d %H:%M:%S",
+        "%d/%b/%Y:%H:%M:%S",
+    };
+    return patterns[index];
+}
+
+
+static void BM_strptime_timegm(benchmark::State& state)
+{
+    const char *pattern = Pattern((int)state.range(0));
+    std::vector<std::string> column = MakeColumn(pattern);
+
+    for (auto _ : state) {
+        for (const std::string &text : column) {
+            struct tm tm;
+            memset(&tm, 0, sizeof(tm));
+            strptime(text.c_str(), pattern, &tm);
+            benchmark::DoNotOptimize(timegm(&tm));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ROWS);
+}
+BENCHMARK(BM_strptime_timegm)->Arg(0)->Arg(1);
+
+
+static void BM_CTimeParser(benchmark::State& state)
+{
+    const char *pattern = Pattern((int)state.range(0));
+    std::vector<std::string> column = MakeColumn(pattern);
+    CTimeParser parser {pattern};
+    CTimeSpec parsed;
+
+    for (auto _ : state) {
+        for (const std::string &text : column) {
+            benchmark::DoNotOptimize(parser.Parse(text.data(), text.size(), &parsed));
+            benchmark::DoNotOptimize(parsed);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ROWS);
+}
+BENCHMARK(BM_CTimeParser)->Arg(0)->Arg(1);
+
+
+static void BM_CTimeParser_Bulk(benchmark::State& state)
+{
+    const char *pattern = Pattern((int)state.range(0));
+    std::vector<std::string> column = MakeColumn(pattern);
+    CTimeParser parser {pattern};
+    std::vector<const char *> texts;
+    std::vector<size_t> lengths;
+    std::vector<CTimeSpec> parsed(ROWS);
+    std::vector<uint8_t> errors(ROWS);
+
+    for (const std::string &text : column) {
+        texts.push_back(text.data());
+        lengths.push_back(text.size());
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parser.Parse(texts.data(), lengths.data(), ROWS, 
+                                              parsed.data(), errors.data()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * ROWS);
+}
+BENCHMARK(BM_CTimeParser_Bulk)->Arg(0)->Arg(1);
+
+
+/**
+ *  Timeout like durations, as FormatDuration() writes them.
+ */
+static std::vector<std::string> MakeDurationColumn()
+{
+    std::vector<std::string> v;
+    uint64_t state = 88172645463325252ULL;
+    char buffer[DURATION_FORMAT_MAX];
+
+    for (int i = 0; i < ROWS; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        uint64_t ns = state >> (state % 32 + 24);
+        size_t n = FormatDuration(buffer, sizeof(buffer), 
+                                  CTimeSpec((time_t)(ns / NS_IN_SECOND), (long)(ns % NS_IN_SECOND)));
+        v.push_back(std::string(buffer, n));
+    }
+    return v;
+}
+
+
+/**
+ *  The regex approach this replaces.
+ */
+static void BM_regex_duration(benchmark::State& state)
+{
+    std::vector<std::string> column = MakeDurationColumn();
+    std::regex component {"([0-9]*\\.?[0-9]*)(ns|us|ms|s|m|h)"};
+
+    for (auto _ : state) {
+        for (const std::string &text : column) {
+            double seconds = 0;
+            for (std::sregex_iterator it(text.begin(), text.end(), component), end; 
+                 it != end; ++it) {
+                double value = std::stod((*it)[1].str());
+                const std::string unit = (*it)[2].str();
+                if (unit == "ns") seconds += value / 1e9;
+                else if (unit == "us") seconds += value / 1e6;
+                else if (unit == "ms") seconds += value / 1e3;
+                else if (unit == "s") seconds += value;
+                else if (unit == "m") seconds += value * 60;
+                else seconds += value * 3600;
+            }
+            benchmark::DoNotOptimize(seconds);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ROWS);
+}
+BENCHMARK(BM_regex_duration);
+
+
+static void BM_ParseDuration(benchmark::State& state)
+{
+    std::vector<std::string> column = MakeDurationColumn();
+    CTimeSpec parsed;
+
+    for (auto _ : state) {
+        for (const std::string &text : column) {
+            benchmark::DoNotOptimize(ParseDuration(text.data(), text.size(), &parsed));
+            benchmark::DoNotOptimize(parsed);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ROWS);
+}
+BENCHMARK(BM_ParseDuration);
+
+
+BENCHMARK_MAIN();
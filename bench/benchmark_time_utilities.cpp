@@ -0,0 +1,387 @@
+/**
+ *  @file
+ *
+ *  Benchmarks of the basic clock reads and arithmetic in 
+ *  time_utilities.h and time_utilities.hpp.
+ *
+ *  To run:
+ *  ./benchmark_time_utilities
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#define USING_TIMEVAL
+#include "time_utilities.h"
+#include "time_utilities.hpp"
+
+
+/**
+ *  Size of the operand arrays used by the arithmetic benchmarks.
+ *  Big enough to defeat constant folding, small enough for L1.
+ */
+#define OPERANDS    (1024)
+
+
+static std::vector<struct timespec> MakeOperands()
+{
+    std::vector<struct timespec> v(OPERANDS);
+    uint64_t state = 88172645463325252ULL;
+
+    for (auto &ts : v) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        ts.tv_sec = static_cast<time_t>(state % 2000000000);
+        ts.tv_nsec = static_cast<long>((state >> 32) % NS_IN_SECOND);
+    }
+    return v;
+}
+
+
+static void BM_timespec_now(benchmark::State& state)
+{
+    struct timespec ts;
+    for (auto _ : state) {
+        timespec_now(&ts);
+        benchmark::DoNotOptimize(ts);
+    }
+}
+BENCHMARK(BM_timespec_now);
+
+
+static void BM_CTimeSpec_Now(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CTimeSpec::Now());
+    }
+}
+BENCHMARK(BM_CTimeSpec_Now);
+
+
+static void BM_CTimeSpec_NowMonotonic(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CTimeSpec::NowMonotonic());
+    }
+}
+BENCHMARK(BM_CTimeSpec_NowMonotonic);
+
+
+static void BM_CTimeSpec_NowMonotonicRaw(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CTimeSpec::NowMonotonicRaw());
+    }
+}
+BENCHMARK(BM_CTimeSpec_NowMonotonicRaw);
+
+
+static void BM_timespec_add(benchmark::State& state)
+{
+    std::vector<struct timespec> a = MakeOperands();
+    std::vector<struct timespec> b = MakeOperands();
+    std::vector<struct timespec> sum(OPERANDS);
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            timespec_add(&sum[i], &a[i], &b[(i + 1) % OPERANDS]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_timespec_add);
+
+
+static void BM_timespec_sum(benchmark::State& state)
+{
+    std::vector<struct timespec> a = MakeOperands();
+    std::vector<struct timespec> b = MakeOperands();
+    std::vector<struct timespec> sum(OPERANDS);
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            sum[i] = timespec_sum(a[i], b[(i + 1) % OPERANDS]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_timespec_sum);
+
+
+static void BM_CTimeSpec_Add(benchmark::State& state)
+{
+    std::vector<struct timespec> raw = MakeOperands();
+    std::vector<CTimeSpec> a(raw.begin(), raw.end());
+    std::vector<CTimeSpec> sum(OPERANDS);
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            sum[i] = a[i] + a[(i + 1) % OPERANDS];
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_CTimeSpec_Add);
+
+
+static void BM_timespec_subtract(benchmark::State& state)
+{
+    std::vector<struct timespec> a = MakeOperands();
+    std::vector<struct timespec> b = MakeOperands();
+    std::vector<struct timespec> difference(OPERANDS);
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            timespec_subtract(&difference[i], &a[i], &b[(i + 1) % OPERANDS]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_timespec_subtract);
+
+
+static void BM_timespec_diff(benchmark::State& state)
+{
+    std::vector<struct timespec> a = MakeOperands();
+    std::vector<struct timespec> b = MakeOperands();
+    std::vector<struct timespec> difference(OPERANDS);
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            difference[i] = timespec_diff(a[i], b[(i + 1) % OPERANDS]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_timespec_diff);
+
+
+static void BM_CTimeSpec_Subtract(benchmark::State& state)
+{
+    std::vector<struct timespec> raw = MakeOperands();
+    std::vector<CTimeSpec> a(raw.begin(), raw.end());
+    std::vector<CTimeSpec> difference(OPERANDS);
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            difference[i] = a[i] - a[(i + 1) % OPERANDS];
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_CTimeSpec_Subtract);
+
+
+static void BM_timespec_compare(benchmark::State& state)
+{
+    std::vector<struct timespec> a = MakeOperands();
+    std::vector<struct timespec> b = MakeOperands();
+
+    for (auto _ : state) {
+        int total = 0;
+        for (int i = 0; i < OPERANDS; i++) {
+            total += timespec_compare(&a[i], &b[(i + 1) % OPERANDS]);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_timespec_compare);
+
+
+static void BM_timespec_cmp(benchmark::State& state)
+{
+    std::vector<struct timespec> a = MakeOperands();
+    std::vector<struct timespec> b = MakeOperands();
+
+    for (auto _ : state) {
+        int total = 0;
+        for (int i = 0; i < OPERANDS; i++) {
+            total += timespec_cmp(a[i], b[(i + 1) % OPERANDS]);
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_timespec_cmp);
+
+
+static void BM_CTimeSpec_Less(benchmark::State& state)
+{
+    std::vector<struct timespec> raw = MakeOperands();
+    std::vector<CTimeSpec> a(raw.begin(), raw.end());
+
+    for (auto _ : state) {
+        int total = 0;
+        for (int i = 0; i < OPERANDS; i++) {
+            total += a[i] < a[(i + 1) % OPERANDS];
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_CTimeSpec_Less);
+
+
+/**
+ *  Breaking down times that mostly fall on the same day, as log 
+ *  and event timestamps do.
+ */
+static std::vector<struct timespec> MakeSameDayOperands()
+{
+    std::vector<struct timespec> v = MakeOperands();
+    for (size_t i = 0; i < v.size(); i++)
+        v[i].tv_sec = 1481155200 + (i * 7919) % SEC_IN_DAY;
+    return v;
+}
+
+
+static void BM_gmtime_r(benchmark::State& state)
+{
+    std::vector<struct timespec> a = MakeSameDayOperands();
+    struct tm tm;
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            gmtime_r(&a[i].tv_sec, &tm);
+            benchmark::DoNotOptimize(tm);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_gmtime_r);
+
+
+static void BM_CTimeSpec_Civil(benchmark::State& state)
+{
+    std::vector<struct timespec> raw = MakeSameDayOperands();
+    std::vector<CTimeSpec> a(raw.begin(), raw.end());
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            benchmark::DoNotOptimize(a[i].Civil());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_CTimeSpec_Civil);
+
+
+/**
+ *  Every time on a different day, so the day cache always misses.
+ */
+static void BM_CTimeSpec_Civil_Uncached(benchmark::State& state)
+{
+    std::vector<struct timespec> raw = MakeOperands();
+    std::vector<CTimeSpec> a(raw.begin(), raw.end());
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            benchmark::DoNotOptimize(a[i].Civil());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_CTimeSpec_Civil_Uncached);
+
+
+/**
+ *  Start of next month, through struct tm the traditional way, 
+ *  against the integer only calendar arithmetic.
+ */
+static void BM_timegm_NextMonth(benchmark::State& state)
+{
+    std::vector<struct timespec> a = MakeOperands();
+    struct tm tm;
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            gmtime_r(&a[i].tv_sec, &tm);
+            tm.tm_mday = 1;
+            tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+            tm.tm_mon += 1;
+            benchmark::DoNotOptimize(timegm(&tm));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_timegm_NextMonth);
+
+
+static void BM_CTimeSpec_NextMonth(benchmark::State& state)
+{
+    std::vector<struct timespec> raw = MakeOperands();
+    std::vector<CTimeSpec> a(raw.begin(), raw.end());
+
+    for (auto _ : state) {
+        for (int i = 0; i < OPERANDS; i++) {
+            benchmark::DoNotOptimize(a[i].FloorToMonth().AddMonths(1));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * OPERANDS);
+}
+BENCHMARK(BM_CTimeSpec_NextMonth);
+
+
+static void BM_CTimeSpec_AddMonths_Array(benchmark::State& state)
+{
+    std::vector<struct timespec> raw = MakeOperands();
+    std::vector<CTimeSpec> a(raw.begin(), raw.end());
+
+    for (auto _ : state) {
+        CTimeSpec::AddMonths(a.data(), a.size(), 1);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * a.size());
+}
+BENCHMARK(BM_CTimeSpec_AddMonths_Array);
+
+
+static void BM_CTimeSpec_FloorToDay_Array(benchmark::State& state)
+{
+    std::vector<struct timespec> raw = MakeOperands();
+    std::vector<CTimeSpec> a(raw.begin(), raw.end());
+    std::vector<CTimeSpec> b(a.size());
+
+    for (auto _ : state) {
+        std::copy(a.begin(), a.end(), b.begin());
+        CTimeSpec::FloorToDay(b.data(), b.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * a.size());
+}
+BENCHMARK(BM_CTimeSpec_FloorToDay_Array);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,203 @@
+/**
+ *  @file
+ *
+ *  Size and throughput of the encodings in time_wire.hpp, against
+ *  writing the 16 raw bytes of a timespec. The "bytes_per_value" 
+ *  counter is the encoded size.
+ *
+ *  To run:
+ *  ./benchmark_time_wire
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "time_utilities.hpp"
+#include "time_wire.hpp"
+
+
+/**
+ *  Values per batch.
+ */
+#define VALUES  (1024)
+
+
+/**
+ *  Event timestamps: wall clock times a few microseconds to a few 
+ *  milliseconds apart, as a batch of RPC events would be.
+ */
+static std::vector<CTimeSpec> MakeTimestamps()
+{
+    std::vector<CTimeSpec> v;
+    CTimeSpec t {1481213045, 123456789};
+    uint64_t state = 88172645463325252ULL;
+
+    for (int i = 0; i < VALUES; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        t += CTimeSpec(0, (long)(state >> (state % 16 + 42)));
+        v.push_back(t);
+    }
+    return v;
+}
+
+
+static void BM_Raw_Encode(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<uint8_t> out(VALUES * sizeof(struct timespec));
+
+    for (auto _ : state) {
+        uint8_t *p = out.data();
+        for (const CTimeSpec &value : values) {
+            struct timespec ts = value.c_timespec();
+            memcpy(p, &ts, sizeof(ts));
+            p += sizeof(ts);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+    state.counters["bytes_per_value"] = sizeof(struct timespec);
+}
+BENCHMARK(BM_Raw_Encode);
+
+
+static void BM_Compact_Encode(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<uint8_t> out(VALUES * TIME_WIRE_MAX);
+    size_t size = 0;
+
+    for (auto _ : state) {
+        uint8_t *p = out.data();
+        for (const CTimeSpec &value : values)
+            p += CTimeWire::EncodeCompact(p, value);
+        size = (size_t)(p - out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+    state.counters["bytes_per_value"] = (double)size / VALUES;
+}
+BENCHMARK(BM_Compact_Encode);
+
+
+static void BM_Compact_Decode(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<uint8_t> in(VALUES * TIME_WIRE_MAX);
+    uint8_t *end = in.data();
+    for (const CTimeSpec &value : values)
+        end += CTimeWire::EncodeCompact(end, value);
+
+    for (auto _ : state) {
+        const uint8_t *p = in.data();
+        for (CTimeSpec &value : values)
+            p += CTimeWire::DecodeCompact(p, (size_t)(end - p), &value);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_Compact_Decode);
+
+
+static void BM_Timestamp_Encode(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<uint8_t> out(VALUES * TIME_WIRE_MAX);
+    size_t size = 0;
+
+    for (auto _ : state) {
+        uint8_t *p = out.data();
+        for (const CTimeSpec &value : values)
+            p += CTimeWire::EncodeTimestamp(p, value);
+        size = (size_t)(p - out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+    state.counters["bytes_per_value"] = (double)size / VALUES;
+}
+BENCHMARK(BM_Timestamp_Encode);
+
+
+static void BM_Timestamp_Decode(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<uint8_t> in(VALUES * TIME_WIRE_MAX);
+    std::vector<size_t> sizes;
+    uint8_t *end = in.data();
+    for (const CTimeSpec &value : values) {
+        sizes.push_back(CTimeWire::EncodeTimestamp(end, value));
+        end += sizes.back();
+    }
+
+    for (auto _ : state) {
+        const uint8_t *p = in.data();
+        for (int i = 0; i < VALUES; i++) {
+            CTimeWire::DecodeTimestamp(p, sizes[i], &values[i]);
+            p += sizes[i];
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_Timestamp_Decode);
+
+
+static void BM_Deltas_Encode(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<uint8_t> out(VALUES * VARINT_MAX);
+    size_t size = 0;
+
+    for (auto _ : state) {
+        size = CTimeWire::EncodeDeltas(out.data(), values.data(), VALUES, values[0]);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+    state.counters["bytes_per_value"] = (double)size / VALUES;
+}
+BENCHMARK(BM_Deltas_Encode);
+
+
+static void BM_Deltas_Decode(benchmark::State& state)
+{
+    std::vector<CTimeSpec> values = MakeTimestamps();
+    std::vector<uint8_t> in(VALUES * VARINT_MAX);
+    size_t size = CTimeWire::EncodeDeltas(in.data(), values.data(), VALUES, values[0]);
+    CTimeSpec base = values[0];
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CTimeWire::DecodeDeltas(in.data(), size, base, 
+                                                         values.data(), VALUES));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * VALUES);
+}
+BENCHMARK(BM_Deltas_Decode);
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,178 @@
+/**
+ *  @file
+ *
+ *  Per operation latency of CTtlCache while a million entries expire
+ *  at once, against an unordered_map that sweeps everything every 
+ *  50ms. Every Get() and Put() is timed on its own into a 
+ *  CLatencyHistogram; the counters are its percentiles in ns.
+ *
+ *  The scenario, in simulated time: 2^20 entries put with a 1s TTL,
+ *  then 3M operations 100ns apart from 0.9s to 1.2s, half Get() of 
+ *  those keys and half Put() of new ones. Both tables are reserved up
+ *  front, so rehashing does not hide the sweep.
+ *
+ *  To run:
+ *  ./benchmark_ttl_cache
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdint>
+#include <unordered_map>
+#include <benchmark/benchmark.h>
+
+#include "time_utilities.hpp"
+#include "tsc_clock.hpp"
+#include "latency_histogram.hpp"
+#include "ttl_cache.hpp"
+
+
+#define KEYS        (1 << 20)
+#define OPERATIONS  (3000000)
+
+
+/**
+ *  The stop the world cache being replaced.
+ */
+class CSweptCache
+{
+    public:
+
+        CSweptCache() : next_sweep(0)
+        {
+        }
+
+        void Reserve(size_t entries)
+        {
+            map.reserve(entries);
+        }
+
+        void Put(int key, int value, const CTimeSpec& ttl, const CTimeSpec& now)
+        {
+            MaybeSweep(now);
+            Entry &entry = map[key];
+            entry.value = value;
+            entry.expires = now + ttl;
+        }
+
+        bool Get(int key, int *value, const CTimeSpec& now)
+        {
+            MaybeSweep(now);
+            std::unordered_map<int, Entry>::iterator it = map.find(key);
+            if (it == map.end() || it->second.expires <= now)
+                return false;
+            *value = it->second.value;
+            return true;
+        }
+
+        size_t Size() const
+        {
+            return map.size();
+        }
+
+    private:
+
+        struct Entry
+        {
+            int value;
+            CTimeSpec expires;
+        };
+
+        void MaybeSweep(const CTimeSpec& now)
+        {
+            if (now < next_sweep)
+                return;
+            for (std::unordered_map<int, Entry>::iterator it = map.begin(); it != map.end(); ) {
+                if (it->second.expires <= now)
+                    it = map.erase(it);
+                else
+                    ++it;
+            }
+            next_sweep = now + CTimeSpec(0, 50 * NS_IN_MS);
+        }
+
+        std::unordered_map<int, Entry> map;
+        CTimeSpec next_sweep;
+};
+
+
+template <typename Cache>
+static void RunScenario(benchmark::State& state, Cache& cache)
+{
+    const CTscClock &tsc = CTscClock::Instance();
+    CLatencyHistogram histogram;
+    uint64_t rng = 88172645463325252ULL;
+    int value = 0;
+
+    cache.Reserve(2 * KEYS);
+    for (int key = 0; key < KEYS; key++)
+        cache.Put(key, key, CTimeSpec(1, 0), CTimeSpec(0, key * 10L));
+
+    CTimeSpec now(0, 900 * NS_IN_MS);
+    for (int i = 0; i < OPERATIONS; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        int key = (int)(rng % KEYS);
+
+        uint64_t start = CTscClock::Read();
+        if (rng & (1ULL << 40))
+            cache.Get(key, &value, now);
+        else
+            cache.Put(KEYS + key, key, CTimeSpec(10, 0), now);
+        uint64_t end = CTscClock::Read();
+
+        histogram.Record(tsc.TicksToDuration(end - start));
+        now += CTimeSpec(0, 100);
+    }
+    benchmark::DoNotOptimize(value);
+
+    state.counters["p50_ns"] = (double)histogram.Percentile(50);
+    state.counters["p99_ns"] = (double)histogram.Percentile(99);
+    state.counters["p999_ns"] = (double)histogram.Percentile(99.9);
+    state.counters["max_ns"] = (double)histogram.Max();
+    state.counters["size"] = (double)cache.Size();
+}
+
+
+static void BM_SweptCache(benchmark::State& state)
+{
+    for (auto _ : state) {
+        CSweptCache cache;
+        RunScenario(state, cache);
+    }
+}
+BENCHMARK(BM_SweptCache)->Iterations(2)->Unit(benchmark::kMillisecond);
+
+
+static void BM_CTtlCache(benchmark::State& state)
+{
+    for (auto _ : state) {
+        CTtlCache<int, int> cache;
+        cache.SetSampleCount((size_t)state.range(0));
+        RunScenario(state, cache);
+    }
+}
+BENCHMARK(BM_CTtlCache)->Arg(0)->Arg(4)->Iterations(2)->Unit(benchmark::kMillisecond);
+
+
+BENCHMARK_MAIN();
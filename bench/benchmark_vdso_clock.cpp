@@ -0,0 +1,78 @@
+/**
+ *  @file
+ *
+ *  Per call cost of reading a clock through libc's clock_gettime(),
+ *  through CVdsoClock's direct vDSO call, and through the system 
+ *  call, on the clocks the vDSO serves.
+ *
+ *  To run:
+ *  ./benchmark_vdso_clock
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <ctime>
+#include <benchmark/benchmark.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "vdso_clock.hpp"
+
+
+static void BM_libc_clock_gettime(benchmark::State& state)
+{
+    clockid_t clock = (clockid_t)state.range(0);
+    struct timespec ts;
+    for (auto _ : state) {
+        clock_gettime(clock, &ts);
+        benchmark::DoNotOptimize(ts);
+    }
+}
+BENCHMARK(BM_libc_clock_gettime)->Arg(CLOCK_MONOTONIC)->Arg(CLOCK_REALTIME)->Arg(CLOCK_MONOTONIC_COARSE);
+
+
+static void BM_CVdsoClock_GetTime(benchmark::State& state)
+{
+    clockid_t clock = (clockid_t)state.range(0);
+    struct timespec ts;
+    for (auto _ : state) {
+        CVdsoClock::GetTime(clock, &ts);
+        benchmark::DoNotOptimize(ts);
+    }
+    state.counters["vdso"] = CVdsoClock::Available();
+}
+BENCHMARK(BM_CVdsoClock_GetTime)->Arg(CLOCK_MONOTONIC)->Arg(CLOCK_REALTIME)->Arg(CLOCK_MONOTONIC_COARSE);
+
+
+static void BM_syscall_clock_gettime(benchmark::State& state)
+{
+    clockid_t clock = (clockid_t)state.range(0);
+    struct timespec ts;
+    for (auto _ : state) {
+        syscall(SYS_clock_gettime, clock, &ts);
+        benchmark::DoNotOptimize(ts);
+    }
+}
+BENCHMARK(BM_syscall_clock_gettime)->Arg(CLOCK_MONOTONIC)->Arg(CLOCK_REALTIME);
+
+
+BENCHMARK_MAIN();
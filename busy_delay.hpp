@@ -0,0 +1,216 @@
+/**
+ *  @file
+ *
+ *  Busy wait delays down to tens of nanoseconds, for hardware facing
+ *  loops where nanosleep() (tens of microseconds of wakeup latency 
+ *  at best) is far too coarse.
+ *
+ *  The delay spins until a deadline on the fastest clock available:
+ *  the invariant TSC (or the aarch64 generic timer) through 
+ *  CTscClock, otherwise CLOCK_MONOTONIC_RAW. Calibration, done once
+ *  when the shared instance is first used, measures what a clock 
+ *  read and a pause hint cost. The read cost is taken off every 
+ *  deadline, since the wait cannot end sooner than one read after 
+ *  it starts, and pause hints stop once the deadline is closer than
+ *  one pause, so it is not overshot by one.
+ *
+ *  Burns the CPU for the whole delay; beyond some tens of 
+ *  microseconds, sleep instead.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef BUSY_DELAY_HPP__
+#define BUSY_DELAY_HPP__
+
+#include <cstdint>
+#include <ctime>
+
+#include "time_utilities.hpp"
+#include "tsc_clock.hpp"
+
+
+class CBusyDelay
+{
+    public:
+
+        /**
+         *  ctor - calibrates.
+         *  @param use_tsc spin on the hardware counter; if false, or
+         *  the counter is not both supported and invariant, spin on
+         *  CLOCK_MONOTONIC_RAW.
+         */
+        explicit CBusyDelay(bool use_tsc = true)
+            : tsc(use_tsc && CTscClock::Supported() && CTscClock::Invariant()), 
+              ticks_per_ns_q32(1ULL << 32), read_ticks(0), pause_ticks(0)
+        {
+            if (tsc) {
+                double ticks_per_ns = CTscClock::Instance().TicksPerSecond() / NS_IN_SECOND;
+                ticks_per_ns_q32 = (uint64_t)(ticks_per_ns * 4294967296.0);
+            }
+            Calibrate();
+        }
+
+        /**
+         *  The delay shared by the whole process, calibrated the 
+         *  first time it is asked for.
+         */
+        static const CBusyDelay& Instance()
+        {
+            static const CBusyDelay instance;
+            return instance;
+        }
+
+        /**
+         *  Spin for at least ns nanoseconds.
+         */
+        void DelayNs(uint64_t ns) const
+        {
+            uint64_t start = Read();
+            uint64_t ticks = ToTicks(ns);
+            if (ticks <= read_ticks)
+                return;
+            SpinUntil(start + ticks - read_ticks);
+        }
+
+        /**
+         *  Spin for at least a duration. Zero and negative durations
+         *  return at once.
+         */
+        void DelayFor(const CTimeSpec& duration) const
+        {
+            struct timespec ts = duration.c_timespec();
+            if (ts.tv_sec < 0 || (ts.tv_sec == 0 && ts.tv_nsec == 0))
+                return;
+            if ((uint64_t)ts.tv_sec >= UINT64_MAX / NS_IN_SECOND / 4)
+                ts.tv_sec = (time_t)(UINT64_MAX / NS_IN_SECOND / 4);
+            DelayNs((uint64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec);
+        }
+
+        /**
+         *  Tell the CPU this is a spin loop: it saves power and 
+         *  yields the core to a hyperthread sibling.
+         */
+        static void Pause()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            _mm_pause();
+#elif defined(__aarch64__)
+            __asm__ __volatile__("yield" ::: "memory");
+#endif
+        }
+
+        /**
+         *  True if spinning on the hardware counter.
+         */
+        bool UsesTsc() const
+        {
+            return tsc;
+        }
+
+        /**
+         *  Calibrated cost of one clock read, and of one Pause().
+         */
+        double ReadCostNs() const
+        {
+            return ToNs(read_ticks);
+        }
+
+        double PauseCostNs() const
+        {
+            return ToNs(pause_ticks);
+        }
+
+    private:
+
+        uint64_t Read() const
+        {
+            if (tsc)
+                return CTscClock::Read();
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+            return (uint64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+        }
+
+        uint64_t ToTicks(uint64_t ns) const
+        {
+            return (uint64_t)(((unsigned __int128)ns * ticks_per_ns_q32) >> 32);
+        }
+
+        double ToNs(uint64_t ticks) const
+        {
+            return (double)ticks * 4294967296.0 / ticks_per_ns_q32;
+        }
+
+        void SpinUntil(uint64_t deadline) const
+        {
+            for (;;) {
+                uint64_t now = Read();
+                if ((int64_t)(deadline - now) <= 0)
+                    return;
+                if (deadline - now > pause_ticks)
+                    Pause();
+            }
+        }
+
+        /**
+         *  Smallest gap between back to back reads, and the mean 
+         *  cost of a pause, each over a few tries so an interrupt
+         *  does not skew them.
+         */
+        void Calibrate()
+        {
+            uint64_t best_read = UINT64_MAX;
+            uint64_t best_pause = UINT64_MAX;
+
+            for (int attempt = 0; attempt < 10; attempt++) {
+                for (int i = 0; i < 100; i++) {
+                    uint64_t a = Read();
+                    uint64_t b = Read();
+                    if (b - a < best_read)
+                        best_read = b - a;
+                }
+
+                uint64_t start = Read();
+                for (int i = 0; i < 1000; i++)
+                    Pause();
+                uint64_t pauses = (Read() - start) / 1000;
+                if (pauses < best_pause)
+                    best_pause = pauses;
+            }
+            read_ticks = best_read;
+            pause_ticks = best_pause;
+        }
+
+        bool tsc;
+
+        /**
+         *  Counter ticks per ns, 32.32 fixed point; exactly 1.0 
+         *  when spinning on CLOCK_MONOTONIC_RAW.
+         */
+        uint64_t ticks_per_ns_q32;
+        uint64_t read_ticks;
+        uint64_t pause_ticks;
+};
+
+
+#endif
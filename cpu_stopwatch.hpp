@@ -0,0 +1,162 @@
+/**
+ *  @file
+ *
+ *  Stopwatch measuring wall clock and CPU time side by side, so a 
+ *  scope can tell how much of its elapsed time it spent running.
+ *
+ *  Both reads are clock_gettime() calls, CLOCK_MONOTONIC and 
+ *  CLOCK_THREAD_CPUTIME_ID. The monotonic read goes through the vDSO.
+ *  The CPU clock read is a syscall, like getrusage(), but a lighter
+ *  one: it does not fill in a dozen unrelated fields, does not walk
+ *  every thread of the process (RUSAGE_SELF does), and reports 
+ *  nanoseconds rather than microseconds. benchmark_cpu_clocks 
+ *  compares the two on a given host.
+ *
+ *  This header requires C++11 support.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef CPU_STOPWATCH_HPP__
+#define CPU_STOPWATCH_HPP__
+
+#include "time_utilities.hpp"
+
+
+/**
+ *  Wall clock and CPU time of a measured interval.
+ */
+struct CCpuTimes
+{
+    CTimeSpec wall;
+    CTimeSpec cpu;
+
+    /**
+     *  Time the interval spent not running: blocked, sleeping, or
+     *  waiting for a CPU. Clamped at zero, since the two clocks 
+     *  are read at slightly different moments.
+     */
+    CTimeSpec OffCpu() const
+    {
+        return wall > cpu ? wall - cpu : CTimeSpec();
+    }
+
+    CCpuTimes& operator+=(const CCpuTimes& rhs)
+    {
+        wall += rhs.wall;
+        cpu += rhs.cpu;
+        return *this;
+    }
+};
+
+
+/**
+ *  Stopwatch running on the monotonic clock and on the CPU clock 
+ *  of the thread that started it. Only read it from that thread.
+ */
+class CCpuStopwatch
+{
+    public:
+
+        /**
+         *  ctor - starts the stopwatch.
+         */
+        CCpuStopwatch()
+        : wall_start(CTimeSpec::NowMonotonic()),
+          cpu_start(CTimeSpec::NowThreadCpu())
+        {}
+
+        /**
+         *  Start measuring again from now.
+         */
+        void Restart()
+        {
+            wall_start = CTimeSpec::NowMonotonic();
+            cpu_start = CTimeSpec::NowThreadCpu();
+        }
+
+        /**
+         *  Wall clock time since the stopwatch was started.
+         */
+        CTimeSpec Wall() const
+        {
+            return CTimeSpec::NowMonotonic() - wall_start;
+        }
+
+        /**
+         *  CPU time used by this thread since the stopwatch was 
+         *  started.
+         */
+        CTimeSpec Cpu() const
+        {
+            return CTimeSpec::NowThreadCpu() - cpu_start;
+        }
+
+        /**
+         *  Both times since the stopwatch was started.
+         */
+        CCpuTimes Elapsed() const
+        {
+            CCpuTimes times;
+            times.cpu = Cpu();
+            times.wall = Wall();
+            return times;
+        }
+
+    private:
+        CTimeSpec wall_start;
+        CTimeSpec cpu_start;
+};
+
+
+/**
+ *  Measures the scope it lives in and adds the result to a 
+ *  CCpuTimes when the scope exits, e.g. to account a request's 
+ *  time across several handlers.
+ */
+class CScopedCpuStopwatch
+{
+    public:
+
+        /**
+         *  ctor
+         *  @param total receives the scope's times on destruction.
+         */
+        explicit CScopedCpuStopwatch(CCpuTimes& total)
+        : total(total)
+        {}
+
+        ~CScopedCpuStopwatch()
+        {
+            total += stopwatch.Elapsed();
+        }
+
+        CScopedCpuStopwatch(const CScopedCpuStopwatch&) = delete;
+        CScopedCpuStopwatch& operator=(const CScopedCpuStopwatch&) = delete;
+
+    private:
+        CCpuTimes& total;
+        CCpuStopwatch stopwatch;
+};
+
+
+#endif
@@ -0,0 +1,264 @@
+/**
+ *  @file
+ *
+ *  Fixed timestep loop driver: the frame loop feeds it real time, it
+ *  says how many fixed size simulation updates to run, and how far 
+ *  between two updates the frame falls, for interpolating the render.
+ *
+ *      CFixedTimestep timestep(CTimeSpec(0, 10 * NS_IN_MS));
+ *      for (;;) {
+ *          for (size_t n = timestep.Frame(CTimeSpec::NowMonotonic()); n; n--)
+ *              Update(timestep.Step());
+ *          Render(timestep.Alpha());
+ *      }
+ *
+ *  Time is accumulated in integer nanoseconds, so the simulated time 
+ *  is exactly steps * step and nothing drifts however long it runs; 
+ *  only Alpha() is a double.
+ *
+ *  Overload is bounded two ways, so a slow frame cannot make the next
+ *  one slower still (the spiral of death): a frame delta longer than
+ *  max_frame is clamped to it (a stall, or a debugger stop), and no 
+ *  more than max_steps updates run per frame, whole steps still 
+ *  owed beyond that being dropped. Both are counted, so overload 
+ *  shows up in the statistics rather than as a hang.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef FIXED_TIMESTEP_HPP__
+#define FIXED_TIMESTEP_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "time_utilities.hpp"
+#include "latency_histogram.hpp"
+
+
+class CFixedTimestep
+{
+    public:
+
+        /**
+         *  @param step simulated time per update, > 0.
+         *  @param max_steps most updates per frame, >= 1.
+         *  @param max_frame longest frame delta accepted; zero for 
+         *  max_steps steps.
+         */
+        explicit CFixedTimestep(const CTimeSpec& step, size_t max_steps = 5, 
+                                const CTimeSpec& max_frame = CTimeSpec(0, 0))
+            : step_ns(ToNs(step)), max_steps(max_steps ? max_steps : 1), 
+              max_frame_ns(ToNs(max_frame)), started(false), last_ns(0), accumulator_ns(0), 
+              frames(0), steps(0), dropped_steps(0), clamped_frames(0)
+        {
+            if (max_frame_ns <= 0)
+                max_frame_ns = step_ns * (int64_t)this->max_steps;
+        }
+
+        CFixedTimestep(const CFixedTimestep&) = delete;
+        CFixedTimestep& operator=(const CFixedTimestep&) = delete;
+
+        bool Valid() const
+        {
+            return step_ns > 0;
+        }
+
+        /**
+         *  Start a frame.
+         *  @param now the frame's time on a monotonic clock. The first
+         *  frame only sets the starting point.
+         *  @return updates to run this frame, at most max_steps.
+         */
+        size_t Frame(const CTimeSpec& now)
+        {
+            int64_t now_ns = ToNs(now);
+            if (!Valid())
+                return 0;
+            if (!started) {
+                started = true;
+                last_ns = now_ns;
+                return 0;
+            }
+
+            int64_t delta = now_ns - last_ns;
+            last_ns = now_ns;
+            if (delta < 0)
+                delta = 0;
+            frame_times.Record((uint64_t)delta);
+            frames++;
+
+            if (delta > max_frame_ns) {
+                delta = max_frame_ns;
+                clamped_frames++;
+            }
+            accumulator_ns += delta;
+
+            uint64_t owed = (uint64_t)(accumulator_ns / step_ns);
+            size_t run = owed < max_steps ? (size_t)owed : max_steps;
+            accumulator_ns -= (int64_t)run * step_ns;
+            if (owed > run) {
+                dropped_steps += owed - run;
+                accumulator_ns -= (int64_t)(owed - run) * step_ns;
+            }
+            steps += run;
+            return run;
+        }
+
+        /**
+         *  Frame at CTimeSpec::NowMonotonic().
+         */
+        size_t Frame()
+        {
+            return Frame(CTimeSpec::NowMonotonic());
+        }
+
+        /**
+         *  Run update(step) for each update of a frame.
+         *  @return updates run.
+         */
+        template <typename Update>
+        size_t Run(const CTimeSpec& now, Update update)
+        {
+            size_t n = Frame(now);
+            CTimeSpec dt = Step();
+            for (size_t i = 0; i < n; i++)
+                update(dt);
+            return n;
+        }
+
+        /**
+         *  Simulated time per update.
+         */
+        CTimeSpec Step() const
+        {
+            return FromNs(step_ns);
+        }
+
+        /**
+         *  How far the frame is past the last update, as a fraction
+         *  of a step in [0, 1), to blend the previous and current 
+         *  states with.
+         */
+        double Alpha() const
+        {
+            return step_ns > 0 ? (double)accumulator_ns / (double)step_ns : 0;
+        }
+
+        /**
+         *  The same as Alpha(), exactly: real time accumulated but not
+         *  yet simulated, less than one step.
+         */
+        CTimeSpec Remainder() const
+        {
+            return FromNs(accumulator_ns);
+        }
+
+        /**
+         *  Simulated time so far, exactly steps run * step.
+         */
+        CTimeSpec SimulatedTime() const
+        {
+            unsigned __int128 ns = (unsigned __int128)steps * (uint64_t)step_ns;
+            return CTimeSpec((time_t)(ns / NS_IN_SECOND), (long)(ns % NS_IN_SECOND));
+        }
+
+        uint64_t Frames() const
+        {
+            return frames;
+        }
+
+        uint64_t Steps() const
+        {
+            return steps;
+        }
+
+        /**
+         *  Whole steps owed beyond max_steps in a frame, never run.
+         */
+        uint64_t DroppedSteps() const
+        {
+            return dropped_steps;
+        }
+
+        /**
+         *  Frames whose delta was longer than max_frame.
+         */
+        uint64_t ClampedFrames() const
+        {
+            return clamped_frames;
+        }
+
+        /**
+         *  Real time between frames, in ns, before clamping.
+         */
+        const CLatencyHistogram& FrameTimes() const
+        {
+            return frame_times;
+        }
+
+        /**
+         *  Forget the starting point, the accumulated time and the 
+         *  statistics.
+         */
+        void Reset()
+        {
+            started = false;
+            accumulator_ns = 0;
+            frames = steps = dropped_steps = clamped_frames = 0;
+            frame_times.Reset();
+        }
+
+    private:
+
+        static int64_t ToNs(const CTimeSpec& value)
+        {
+            struct timespec ts = value.c_timespec();
+            return (int64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+        }
+
+        static CTimeSpec FromNs(int64_t ns)
+        {
+            return CTimeSpec((time_t)(ns / NS_IN_SECOND), (long)(ns % NS_IN_SECOND));
+        }
+
+        int64_t step_ns;
+        size_t max_steps;
+        int64_t max_frame_ns;
+
+        bool started;
+        int64_t last_ns;
+
+        /**
+         *  Real time not yet simulated, in [0, step_ns) between frames.
+         */
+        int64_t accumulator_ns;
+
+        uint64_t frames;
+        uint64_t steps;
+        uint64_t dropped_steps;
+        uint64_t clamped_frames;
+        CLatencyHistogram frame_times;
+};
+
+
+#endif
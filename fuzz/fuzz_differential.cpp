@@ -0,0 +1,280 @@
+/**
+ *  @file
+ *
+ *  Differential fuzz target. Every operation is computed three 
+ *  ways, through the C API in time_utilities.h, through the C++ 
+ *  classes in time_utilities.hpp, and through the 128 bit reference 
+ *  in reference_time.hpp, and all three must agree.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <sys/time.h>
+
+#define USING_TIMEVAL
+#include "time_utilities.h"
+#include "time_utilities.hpp"
+#include "fuzz_input.hpp"
+#include "reference_time.hpp"
+
+
+/**
+ *  Operand seconds are kept within +/- 2^61 so sums and 
+ *  differences of two of them cannot overflow a 64 bit time_t.
+ */
+#define SEC_LIMIT_DIVISOR   (4)
+
+
+/**
+ *  Pull a normalized timespec out of the input. Roughly half the 
+ *  time the seconds are taken relative to "near", so that equal 
+ *  and adjacent seconds (where the nsec comparison matters) show 
+ *  up often instead of almost never.
+ */
+static struct timespec TakeTimeSpec(CFuzzInput &input, const struct timespec *near)
+{
+    struct timespec ts;
+
+    if (near && input.TakeChoice(2))
+        ts.tv_sec = near->tv_sec + input.Take<int8_t>() % 2;
+    else
+        ts.tv_sec = input.Take<int64_t>() / SEC_LIMIT_DIVISOR;
+
+    ts.tv_nsec = input.Take<uint32_t>() % NS_IN_SECOND;
+    return ts;
+}
+
+
+static struct timeval TakeTimeVal(CFuzzInput &input, const struct timeval *near)
+{
+    struct timeval tv;
+
+    if (near && input.TakeChoice(2))
+        tv.tv_sec = near->tv_sec + input.Take<int8_t>() % 2;
+    else
+        tv.tv_sec = input.Take<int64_t>() / SEC_LIMIT_DIVISOR;
+
+    tv.tv_usec = input.Take<uint32_t>() % US_IN_SECOND;
+    return tv;
+}
+
+
+static void CheckTimeSpecArithmetic(CFuzzInput &input)
+{
+    struct timespec a = TakeTimeSpec(input, nullptr);
+    struct timespec b = TakeTimeSpec(input, &a);
+    struct timespec sum, difference;
+
+    struct timespec ref_sum = RefTimeSpec(RefNs(a) + RefNs(b));
+    struct timespec ref_difference = RefTimeSpec(RefNs(a) - RefNs(b));
+
+    timespec_add(&sum, &a, &b);
+    timespec_subtract(&difference, &a, &b);
+    assert(RefEqual(sum, ref_sum));
+    assert(RefEqual(difference, ref_difference));
+    assert(RefEqual(timespec_sum(a, b), ref_sum));
+    assert(RefEqual(timespec_diff(a, b), ref_difference));
+
+    CTimeSpec A {a}, B {b};
+    assert(RefEqual((A + B).c_timespec(), ref_sum));
+    assert(RefEqual((A - B).c_timespec(), ref_difference));
+
+    CTimeSpec C = A;
+    C += B;
+    assert(RefEqual(C.c_timespec(), ref_sum));
+
+    C = A;
+    C -= B;
+    assert(RefEqual(C.c_timespec(), ref_difference));
+}
+
+
+static void CheckTimeSpecCompare(CFuzzInput &input)
+{
+    struct timespec a = TakeTimeSpec(input, nullptr);
+    struct timespec b = TakeTimeSpec(input, &a);
+    int ref = RefCompare(RefNs(a), RefNs(b));
+
+    assert(timespec_compare(&a, &b) == ref);
+    assert(timespec_compare(&b, &a) == -ref);
+    assert(timespec_cmp(a, b) == ref);
+    assert(timespec_cmp(b, a) == -ref);
+
+    CTimeSpec A {a}, B {b};
+    assert((A <  B) == (ref <  0));
+    assert((A >  B) == (ref >  0));
+    assert((A <= B) == (ref <= 0));
+    assert((A >= B) == (ref >= 0));
+    assert((A == B) == (ref == 0));
+    assert((A != B) == (ref != 0));
+}
+
+
+static void CheckTimeSpecNormalize(CFuzzInput &input)
+{
+    //
+    //  The normalizing loops are linear in the amount of 
+    //  denormalization, so keep nsec to 32 bits.
+    //
+    time_t sec = input.Take<int64_t>() / SEC_LIMIT_DIVISOR;
+    long nsec = input.Take<int32_t>();
+    struct timespec ref = RefTimeSpec(RefNs(sec, nsec));
+
+    struct timespec ts;
+    ts.tv_sec = sec;
+    ts.tv_nsec = nsec;
+    CTimeSpec A {ts};
+    CTimeSpec B {sec, nsec};
+
+    timespec_normalize(&ts);
+    assert(RefEqual(ts, ref));
+    assert(RefEqual(A.c_timespec(), ref));
+    assert(RefEqual(B.c_timespec(), ref));
+}
+
+
+static void CheckFromMs(CFuzzInput &input)
+{
+    int ms = input.Take<int32_t>();
+    struct timespec ts;
+    struct timeval tv;
+
+    timespec_from_ms(&ts, ms);
+    timeval_from_ms(&tv, ms);
+    assert(RefEqual(ts, RefTimeSpec((ref_int)ms * NS_IN_MS)));
+    assert(RefEqual(tv, RefTimeVal((ref_int)ms * US_IN_MS)));
+
+    unsigned int ums = input.Take<uint32_t>();
+    CTimeSpec A {ums};
+    CTimeVal B {ums};
+    assert(RefEqual(A.c_timespec(), RefTimeSpec((ref_int)ums * NS_IN_MS)));
+    assert(RefEqual(B.c_timeval(), RefTimeVal((ref_int)ums * US_IN_MS)));
+}
+
+
+static void CheckTimeVal(CFuzzInput &input)
+{
+    struct timeval a = TakeTimeVal(input, nullptr);
+    struct timeval b = TakeTimeVal(input, &a);
+    struct timeval sum, difference;
+    int ref = RefCompare(RefUs(a), RefUs(b));
+
+    struct timeval ref_sum = RefTimeVal(RefUs(a) + RefUs(b));
+    struct timeval ref_difference = RefTimeVal(RefUs(a) - RefUs(b));
+
+    timeval_add(&sum, &a, &b);
+    timeval_subtract(&difference, &a, &b);
+    assert(RefEqual(sum, ref_sum));
+    assert(RefEqual(difference, ref_difference));
+    assert(timeval_compare(&a, &b) == ref);
+    assert(RefEqual(timeval_sum(a, b), ref_sum));
+    assert(RefEqual(timeval_diff(a, b), ref_difference));
+    assert(timeval_cmp(a, b) == ref);
+
+    CTimeVal A {a}, B {b};
+    assert(RefEqual((A + B).c_timeval(), ref_sum));
+    assert(RefEqual((A - B).c_timeval(), ref_difference));
+
+    CTimeVal C = A;
+    C += B;
+    assert(RefEqual(C.c_timeval(), ref_sum));
+    C = A;
+    C -= B;
+    assert(RefEqual(C.c_timeval(), ref_difference));
+
+    assert((A <  B) == (ref <  0));
+    assert((A >  B) == (ref >  0));
+    assert((A <= B) == (ref <= 0));
+    assert((A >= B) == (ref >= 0));
+    assert((A == B) == (ref == 0));
+    assert((A != B) == (ref != 0));
+
+    struct timeval tv;
+    tv.tv_sec = input.Take<int64_t>() / SEC_LIMIT_DIVISOR;
+    tv.tv_usec = input.Take<int32_t>();
+    struct timeval ref_tv = RefTimeVal(RefUs(tv));
+    CTimeVal D {tv};
+    CTimeVal E {tv.tv_sec, tv.tv_usec};
+    timeval_normalize(&tv);
+    assert(RefEqual(tv, ref_tv));
+    assert(RefEqual(D.c_timeval(), ref_tv));
+    assert(RefEqual(E.c_timeval(), ref_tv));
+}
+
+
+static void CheckConversions(CFuzzInput &input)
+{
+    struct timespec ts = TakeTimeSpec(input, nullptr);
+    struct timeval tv = TakeTimeVal(input, nullptr);
+
+    //
+    //  timespec -> timeval truncates to the microsecond, which for 
+    //  a normalized timespec is a floor.
+    //
+    struct timeval ref_tv = RefTimeVal(RefFloorDiv(RefNs(ts), 1000));
+    struct timespec ref_ts = RefTimeSpec(RefUs(tv) * 1000);
+
+    struct timeval c_tv;
+    struct timespec c_ts;
+    timespec_to_timeval(&c_tv, &ts);
+    timeval_to_timespec(&c_ts, &tv);
+    assert(RefEqual(c_tv, ref_tv));
+    assert(RefEqual(c_ts, ref_ts));
+
+    CTimeSpec A {ts};
+    assert(RefEqual(CTimeVal {ts}.c_timeval(), ref_tv));
+    assert(RefEqual(CTimeVal {A}.c_timeval(), ref_tv));
+    assert(RefEqual(CTimeSpec {tv}.c_timespec(), ref_ts));
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    CFuzzInput input {data, size};
+
+    switch (input.TakeChoice(6)) {
+        case 0:
+            CheckTimeSpecArithmetic(input);
+            break;
+        case 1:
+            CheckTimeSpecCompare(input);
+            break;
+        case 2:
+            CheckTimeSpecNormalize(input);
+            break;
+        case 3:
+            CheckFromMs(input);
+            break;
+        case 4:
+            CheckTimeVal(input);
+            break;
+        case 5:
+            CheckConversions(input);
+            break;
+    }
+
+    return 0;
+}
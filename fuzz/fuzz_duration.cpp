@@ -0,0 +1,131 @@
+/**
+ *  @file
+ *
+ *  Fuzz target for the duration text functions: ParseDuration() 
+ *  must cope with any input, agree with a 128 bit reference on 
+ *  well formed input, and read back everything FormatDuration() 
+ *  writes.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+#define USING_TIMEVAL
+#include "time_utilities.hpp"
+#include "time_format.hpp"
+#include "time_parse.hpp"
+#include "fuzz_input.hpp"
+#include "reference_time.hpp"
+
+
+static void CheckRoundTrip(const CTimeSpec& value)
+{
+    char text[DURATION_FORMAT_MAX];
+    size_t n = FormatDuration(text, sizeof(text), value);
+    assert(n > 0);
+
+    CTimeSpec parsed;
+    assert(ParseDuration(text, n, &parsed) == CTimeParser::PARSE_OK);
+    assert(parsed == value);
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    CFuzzInput input {data, size};
+
+    switch (input.TakeChoice(3)) {
+        case 0: {
+            //
+            //  Arbitrary bytes.
+            //
+            std::string text;
+            while (input.Remaining())
+                text += (char)input.Take<uint8_t>();
+
+            CTimeSpec parsed;
+            if (ParseDuration(text.data(), text.size(), &parsed) == CTimeParser::PARSE_OK &&
+                parsed.c_timespec().tv_sec != INT64_MIN)
+                CheckRoundTrip(parsed);
+            break;
+        }
+
+        case 1: {
+            //
+            //  Well formed text from random components, against the
+            //  sum computed in 128 bits.
+            //
+            static const char *units[] = {"ns", "us", "\xc2\xb5s", "ms", "s", "m", "h"};
+            static const ref_int unit_ns[] = {
+                1, 1000, 1000, 1000000, 1000000000LL, 60000000000LL, 3600000000000LL
+            };
+            bool negative = input.TakeChoice(2);
+            std::string text = negative ? "-" : "";
+            ref_int total = 0;
+            int components = 1 + input.TakeChoice(4);
+
+            for (int i = 0; i < components; i++) {
+                uint32_t whole = input.Take<uint32_t>();
+                int digits = input.TakeChoice(7);
+                ref_int scale = 1;
+                for (int d = 0; d < digits; d++)
+                    scale *= 10;
+                uint32_t fraction = input.Take<uint32_t>() % (uint32_t)scale;
+                unsigned unit = input.TakeChoice(7);
+
+                char number[32];
+                if (digits)
+                    snprintf(number, sizeof(number), "%u.%0*u", whole, digits, fraction);
+                else
+                    snprintf(number, sizeof(number), "%u", whole);
+                text += number;
+                text += units[unit];
+
+                total += whole * unit_ns[unit] + fraction * unit_ns[unit] / scale;
+            }
+
+            CTimeSpec parsed;
+            assert(ParseDuration(text.data(), text.size(), &parsed) == CTimeParser::PARSE_OK);
+            assert(RefNs(parsed.c_timespec()) == (negative ? -total : total));
+
+            CTimeVal parsed_tv;
+            assert(ParseDuration(text.data(), text.size(), &parsed_tv) == CTimeParser::PARSE_OK);
+            ref_int us = total / 1000;
+            assert(RefUs(parsed_tv.c_timeval()) == (negative ? -us : us));
+            break;
+        }
+
+        case 2: {
+            CTimeSpec value {input.Take<int64_t>(), input.Take<int32_t>()};
+            if (value.c_timespec().tv_sec != INT64_MIN)
+                CheckRoundTrip(value);
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ *  @file
+ *
+ *  Tiny helper for pulling typed values out of a fuzzer input.
+ *  Running off the end of the input yields zeros, which keeps the
+ *  targets simple and still lets the fuzzer reach every value.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef FUZZ_INPUT_HPP__
+#define FUZZ_INPUT_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+/**
+ *  Reads fixed size values from the front of a fuzzer input.
+ */
+class CFuzzInput
+{
+    public:
+
+        /**
+         *  ctor
+         *  @param data fuzzer input.
+         *  @param size number of bytes in data.
+         */
+        CFuzzInput(const uint8_t *data, size_t size)
+        : data(data), size(size)
+        {}
+
+        /**
+         *  Consume sizeof(T) bytes and return them as a T. 
+         *  Missing bytes read as zero.
+         */
+        template <typename T>
+        T Take()
+        {
+            T value;
+            unsigned char bytes[sizeof(T)] = {0};
+            size_t n = size < sizeof(T) ? size : sizeof(T);
+
+            memcpy(bytes, data, n);
+            data += n;
+            size -= n;
+
+            memcpy(&value, bytes, sizeof(T));
+            return value;
+        }
+
+        /**
+         *  Consume one byte and return a value in [0, count).
+         */
+        unsigned TakeChoice(unsigned count)
+        {
+            return Take<uint8_t>() % count;
+        }
+
+        /**
+         *  Number of unread bytes.
+         */
+        size_t Remaining() const
+        {
+            return size;
+        }
+
+    private:
+        const uint8_t *data;
+        size_t size;
+};
+
+
+#endif
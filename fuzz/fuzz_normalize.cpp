@@ -0,0 +1,79 @@
+/**
+ *  @file
+ *
+ *  Fuzz target checking that every way of building a normalized
+ *  timespec (C and C++) lands on the same value, and that add and
+ *  subtract round trip.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cassert>
+#include <cstdint>
+#include <ctime>
+
+#define USING_TIMEVAL
+#include "time_utilities.h"
+#include "time_utilities.hpp"
+#include "fuzz_input.hpp"
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    CFuzzInput input {data, size};
+
+    //
+    //  The normalizing loops are linear in the amount of 
+    //  denormalization, so keep nsec to 32 bits like the unit tests.
+    //
+    time_t sec = input.Take<int32_t>();
+    long nsec = input.Take<int32_t>();
+
+    struct timespec ts;
+    ts.tv_sec = sec;
+    ts.tv_nsec = nsec;
+    timespec_normalize(&ts);
+
+    assert(ts.tv_nsec >= 0 && ts.tv_nsec < NS_IN_SECOND);
+    assert((__int128)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec ==
+           (__int128)sec * NS_IN_SECOND + nsec);
+
+    CTimeSpec A {sec, nsec};
+    struct timespec a = A.c_timespec();
+    assert(a.tv_sec == ts.tv_sec && a.tv_nsec == ts.tv_nsec);
+
+    struct timespec raw;
+    raw.tv_sec = sec;
+    raw.tv_nsec = nsec;
+    CTimeSpec B {raw};
+    assert(B == A);
+
+    CTimeSpec C {input.Take<int32_t>(), input.Take<int32_t>()};
+    assert((A + C) - C == A);
+
+    CTimeSpec D = A;
+    D += C;
+    D -= C;
+    assert(D == A);
+
+    return 0;
+}
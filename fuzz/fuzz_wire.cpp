@@ -0,0 +1,103 @@
+/**
+ *  @file
+ *
+ *  Fuzz target for the decoders in time_wire.hpp, which read bytes
+ *  off the network: any input must decode cleanly or be rejected,
+ *  and whatever decodes must encode back to something that decodes
+ *  to the same value.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cassert>
+#include <cstdint>
+#include <ctime>
+
+#include "time_utilities.hpp"
+#include "time_wire.hpp"
+#include "fuzz_input.hpp"
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    CFuzzInput input {data, size};
+    unsigned which = input.TakeChoice(4);
+    //  Deltas reach 292 years either way, keep base + delta in time_t.
+    const CTimeSpec base {input.Take<int32_t>(), input.Take<int32_t>()};
+
+    data += size - input.Remaining();
+    size = input.Remaining();
+
+    uint8_t buffer[TIME_WIRE_MAX];
+    CTimeSpec value, again;
+    size_t n;
+
+    switch (which) {
+        case 0:
+            n = CTimeWire::DecodeCompact(data, size, &value);
+            assert(n <= size);
+            if (n) {
+                size_t m = CTimeWire::EncodeCompact(buffer, value);
+                assert(CTimeWire::DecodeCompact(buffer, m, &again) == m && again == value);
+            }
+            break;
+
+        case 1:
+            n = CTimeWire::DecodeTimestamp(data, size, &value);
+            assert(n == 0 || n == size);
+            if (n || size == 0) {
+                size_t m = CTimeWire::EncodeTimestamp(buffer, value);
+                again = CTimeSpec(7, 7);
+                CTimeWire::DecodeTimestamp(buffer, m, &again);
+                assert(again == value);
+            }
+            break;
+
+        case 2:
+            n = CTimeWire::DecodeDuration(data, size, &value);
+            assert(n == 0 || n == size);
+            if (n || size == 0) {
+                size_t m = CTimeWire::EncodeDuration(buffer, value);
+                again = CTimeSpec(7, 7);
+                CTimeWire::DecodeDuration(buffer, m, &again);
+                assert(again == value);
+            }
+            break;
+
+        case 3: {
+            CTimeSpec values[32];
+            size_t count = size % 33;
+            n = CTimeWire::DecodeDeltas(data, size, base, values, count);
+            assert(n <= size);
+            for (size_t i = 0; n && i < count; i++) {
+                size_t m = CTimeWire::EncodeDelta(buffer, values[i], base);
+                if (m) {
+                    assert(CTimeWire::DecodeDelta(buffer, m, base, &again) == m);
+                    assert(again == values[i]);
+                }
+            }
+            break;
+        }
+    }
+
+    return 0;
+}
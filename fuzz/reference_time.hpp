@@ -0,0 +1,125 @@
+/**
+ *  @file
+ *
+ *  Reference implementation of the time arithmetic, used by the 
+ *  differential fuzz targets. Values are held as a single 128 bit
+ *  count of nanoseconds (or microseconds), which is slow but
+ *  obviously correct, and is only ever converted back into
+ *  sec / subsec form at the edges.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef REFERENCE_TIME_HPP__
+#define REFERENCE_TIME_HPP__
+
+#include <ctime>
+#include <sys/time.h>
+
+
+typedef __int128 ref_int;
+
+
+/**
+ *  Floor division, so negative totals split into a negative 
+ *  seconds part and a non negative subsecond part.
+ */
+inline ref_int RefFloorDiv(ref_int n, ref_int d)
+{
+    ref_int q = n / d;
+    if ((n % d != 0) && ((n < 0) != (d < 0)))
+        q--;
+    return q;
+}
+
+inline ref_int RefFloorMod(ref_int n, ref_int d)
+{
+    return n - RefFloorDiv(n, d) * d;
+}
+
+
+/**
+ *  Total nanoseconds of a (possibly unnormalized) timespec.
+ */
+inline ref_int RefNs(time_t sec, long nsec)
+{
+    return (ref_int)sec * 1000000000 + nsec;
+}
+
+inline ref_int RefNs(const struct timespec &ts)
+{
+    return RefNs(ts.tv_sec, ts.tv_nsec);
+}
+
+/**
+ *  Total microseconds of a (possibly unnormalized) timeval.
+ */
+inline ref_int RefUs(const struct timeval &tv)
+{
+    return (ref_int)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+
+/**
+ *  Normalized timespec for a nanosecond total.
+ */
+inline struct timespec RefTimeSpec(ref_int ns)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)RefFloorDiv(ns, 1000000000);
+    ts.tv_nsec = (long)RefFloorMod(ns, 1000000000);
+    return ts;
+}
+
+/**
+ *  Normalized timeval for a microsecond total.
+ */
+inline struct timeval RefTimeVal(ref_int us)
+{
+    struct timeval tv;
+    tv.tv_sec = (time_t)RefFloorDiv(us, 1000000);
+    tv.tv_usec = (suseconds_t)RefFloorMod(us, 1000000);
+    return tv;
+}
+
+
+/**
+ *  strcmp style three way compare.
+ */
+inline int RefCompare(ref_int a, ref_int b)
+{
+    return (a > b) - (a < b);
+}
+
+
+inline bool RefEqual(const struct timespec &a, const struct timespec &b)
+{
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+inline bool RefEqual(const struct timeval &a, const struct timeval &b)
+{
+    return a.tv_sec == b.tv_sec && a.tv_usec == b.tv_usec;
+}
+
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ *  @file
+ *
+ *  Standalone driver for the fuzz targets, used when the compiler
+ *  has no libFuzzer support.
+ *
+ *  Usage:
+ *  ./fuzz_xxx [-runs=N] [file ...]
+ *
+ *  Each file given is replayed once as an input. With no files,
+ *  N pseudo random inputs (fixed seed, so runs are repeatable) are
+ *  generated and fed to the target.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+
+/**
+ *  Inputs are at most this long. The targets only ever consume
+ *  a handful of integers, so longer inputs buy nothing.
+ */
+#define MAX_INPUT_SIZE  (256)
+
+
+int main(int argc, char **argv)
+{
+    unsigned long runs = 100000;
+    std::vector<const char *> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0)
+            runs = strtoul(argv[i] + 6, nullptr, 10);
+        else if (argv[i][0] != '-')
+            files.push_back(argv[i]);
+    }
+
+    for (const char *name : files) {
+        std::ifstream file(name, std::ios::binary);
+        std::vector<uint8_t> data {std::istreambuf_iterator<char>(file),
+                                   std::istreambuf_iterator<char>()};
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+
+    if (!files.empty()) {
+        std::cout << "replayed " << files.size() << " inputs" << std::endl;
+        return 0;
+    }
+
+    //
+    //  xorshift64*, good enough to spread inputs around and 
+    //  trivially repeatable.
+    //
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    uint8_t buffer[MAX_INPUT_SIZE];
+
+    for (unsigned long run = 0; run < runs; run++) {
+        size_t size = 0;
+        size_t length;
+
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        length = (state * 0x2545f4914f6cdd1dULL) % (MAX_INPUT_SIZE + 1);
+
+        while (size < length) {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            uint64_t word = state * 0x2545f4914f6cdd1dULL;
+            for (int i = 0; i < 8 && size < length; i++) {
+                buffer[size++] = static_cast<uint8_t>(word >> (i * 8));
+            }
+        }
+
+        LLVMFuzzerTestOneInput(buffer, size);
+    }
+
+    std::cout << "ran " << runs << " inputs" << std::endl;
+    return 0;
+}
@@ -0,0 +1,270 @@
+/**
+ *  @file
+ *
+ *  Log-linear histogram of durations, for latency distributions.
+ *
+ *  Values below 16 ns get a bucket each. Above that every power of 
+ *  two is split into 16 equal buckets, so any recorded value is 
+ *  known to within 1/16 (6.25%) and the whole range of a uint64_t 
+ *  fits in under a thousand buckets. Buckets are atomic, so several
+ *  threads may record into one histogram without locking.
+ *
+ *  This header requires C++11 support.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef LATENCY_HISTOGRAM_HPP__
+#define LATENCY_HISTOGRAM_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "time_utilities.hpp"
+
+
+/**
+ *  Histogram of nanosecond values.
+ */
+class CLatencyHistogram
+{
+    public:
+
+        /**
+         *  Each power of two is split into 2^SUB_BITS buckets.
+         */
+        static const int SUB_BITS = 4;
+        static const int SUB_BUCKETS = 1 << SUB_BITS;
+        static const int NUM_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+        CLatencyHistogram()
+        {
+            Reset();
+        }
+
+        CLatencyHistogram(const CLatencyHistogram&) = delete;
+        CLatencyHistogram& operator=(const CLatencyHistogram&) = delete;
+
+        /**
+         *  Record one value, in nanoseconds.
+         */
+        void Record(uint64_t ns)
+        {
+            buckets[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+            sum.fetch_add(ns, std::memory_order_relaxed);
+
+            uint64_t current = min.load(std::memory_order_relaxed);
+            while (ns < current && 
+                   !min.compare_exchange_weak(current, ns, std::memory_order_relaxed))
+                ;
+            current = max.load(std::memory_order_relaxed);
+            while (ns > current && 
+                   !max.compare_exchange_weak(current, ns, std::memory_order_relaxed))
+                ;
+        }
+
+        /**
+         *  Record one duration. Negative durations record as zero.
+         */
+        void Record(const CTimeSpec& duration)
+        {
+            Record(ToNs(duration));
+        }
+
+        /**
+         *  Add all of another histogram's values to this one.
+         */
+        void Merge(const CLatencyHistogram& other)
+        {
+            for (int i = 0; i < NUM_BUCKETS; i++) {
+                uint64_t n = other.buckets[i].load(std::memory_order_relaxed);
+                if (n)
+                    buckets[i].fetch_add(n, std::memory_order_relaxed);
+            }
+            count.fetch_add(other.Count(), std::memory_order_relaxed);
+            sum.fetch_add(other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+            uint64_t other_min = other.min.load(std::memory_order_relaxed);
+            uint64_t other_max = other.max.load(std::memory_order_relaxed);
+            uint64_t current = min.load(std::memory_order_relaxed);
+            while (other_min < current && 
+                   !min.compare_exchange_weak(current, other_min, std::memory_order_relaxed))
+                ;
+            current = max.load(std::memory_order_relaxed);
+            while (other_max > current && 
+                   !max.compare_exchange_weak(current, other_max, std::memory_order_relaxed))
+                ;
+        }
+
+        /**
+         *  Forget every value. Not atomic with respect to concurrent
+         *  Record() calls.
+         */
+        void Reset()
+        {
+            for (int i = 0; i < NUM_BUCKETS; i++)
+                buckets[i].store(0, std::memory_order_relaxed);
+            count.store(0, std::memory_order_relaxed);
+            sum.store(0, std::memory_order_relaxed);
+            min.store(UINT64_MAX, std::memory_order_relaxed);
+            max.store(0, std::memory_order_relaxed);
+        }
+
+        uint64_t Count() const
+        {
+            return count.load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  Sum of all values in ns. Wraps after ~584 years of total.
+         */
+        uint64_t Sum() const
+        {
+            return sum.load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  Exact smallest value, 0 if empty.
+         */
+        uint64_t Min() const
+        {
+            return Count() ? min.load(std::memory_order_relaxed) : 0;
+        }
+
+        /**
+         *  Exact largest value, 0 if empty.
+         */
+        uint64_t Max() const
+        {
+            return max.load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  Exact mean, 0 if empty.
+         */
+        uint64_t Mean() const
+        {
+            uint64_t n = Count();
+            return n ? Sum() / n : 0;
+        }
+
+        /**
+         *  Value at or below which "percent" of the values lie. 
+         *  Reported as the top of the bucket holding that rank 
+         *  (never above the maximum), so it is at most 6.25% high.
+         *  @param percent in [0, 100].
+         */
+        uint64_t Percentile(double percent) const
+        {
+            uint64_t n = Count();
+            if (n == 0)
+                return 0;
+
+            uint64_t rank = (uint64_t)(percent / 100.0 * n + 0.5);
+            if (rank < 1)
+                rank = 1;
+            if (rank > n)
+                rank = n;
+
+            uint64_t seen = 0;
+            for (int i = 0; i < NUM_BUCKETS; i++) {
+                seen += buckets[i].load(std::memory_order_relaxed);
+                if (seen >= rank) {
+                    uint64_t top = BucketUpper(i);
+                    uint64_t highest = Max();
+                    return top < highest ? top : highest;
+                }
+            }
+            return Max();
+        }
+
+        /**
+         *  Number of values in bucket "index".
+         */
+        uint64_t BucketCount(int index) const
+        {
+            return buckets[index].load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  Bucket a value falls into.
+         */
+        static int BucketIndex(uint64_t ns)
+        {
+            if (ns < (uint64_t)SUB_BUCKETS)
+                return (int)ns;
+
+            int msb = 63 - __builtin_clzll(ns);
+            int shift = msb - SUB_BITS;
+            return (shift + 1) * SUB_BUCKETS + (int)((ns >> shift) & (SUB_BUCKETS - 1));
+        }
+
+        /**
+         *  Smallest value that falls into bucket "index".
+         */
+        static uint64_t BucketLower(int index)
+        {
+            if (index < SUB_BUCKETS)
+                return (uint64_t)index;
+
+            int shift = index / SUB_BUCKETS - 1;
+            uint64_t sub = (uint64_t)(index % SUB_BUCKETS);
+            return (SUB_BUCKETS + sub) << shift;
+        }
+
+        /**
+         *  Largest value that falls into bucket "index".
+         */
+        static uint64_t BucketUpper(int index)
+        {
+            if (index < SUB_BUCKETS)
+                return (uint64_t)index;
+
+            int shift = index / SUB_BUCKETS - 1;
+            return BucketLower(index) + ((uint64_t)1 << shift) - 1;
+        }
+
+        /**
+         *  Non negative duration in ns, saturating.
+         */
+        static uint64_t ToNs(const CTimeSpec& duration)
+        {
+            struct timespec ts = duration.c_timespec();
+            if (ts.tv_sec < 0)
+                return 0;
+            if ((uint64_t)ts.tv_sec >= UINT64_MAX / NS_IN_SECOND)
+                return UINT64_MAX;
+            return (uint64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+        }
+
+    private:
+        std::atomic<uint64_t> buckets[NUM_BUCKETS];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> min;
+        std::atomic<uint64_t> max;
+};
+
+
+#endif
@@ -0,0 +1,336 @@
+/**
+ *  @file
+ *
+ *  Last seen tracking for many entities, with expiry found without
+ *  scanning them all.
+ *
+ *  Entities are ids in [0, capacity). Each one sits in a doubly linked
+ *  list for the time bucket (a slot of a timing wheel) it was last 
+ *  touched in, so a touch is an unlink and a link, and a sweep only 
+ *  visits the buckets that have gone past the timeout. The links are
+ *  uint32 indexes into an array sized once up front: 8 bytes per 
+ *  entity, and nothing allocated after construction.
+ *
+ *  Expiry is at bucket resolution: an entity expires no earlier than
+ *  timeout after its last touch, and no more than one granularity 
+ *  later.
+ *
+ *  Not thread safe; shard by id for concurrent use.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef LIVENESS_TRACKER_HPP__
+#define LIVENESS_TRACKER_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "time_utilities.hpp"
+
+
+/**
+ *  Link of an untracked entity, and stamp of an empty bucket.
+ */
+#define LIVENESS_NONE   (0xffffffffu)
+#define LIVENESS_EMPTY  (INT64_MAX)
+
+
+class CLivenessTracker
+{
+    public:
+
+        /**
+         *  @param capacity number of ids, at most 2^31.
+         *  @param timeout how long after its last touch an entity is
+         *  expired.
+         *  @param granularity width of a bucket, > 0. The wheel has 
+         *  timeout / granularity + 2 buckets.
+         */
+        CLivenessTracker(uint32_t capacity, const CTimeSpec& timeout, 
+                         const CTimeSpec& granularity)
+            : capacity(capacity), timeout_ns(ToNs(timeout)), granularity_ns(ToNs(granularity)), 
+              num_buckets(0), swept(0), size(0)
+        {
+            if (!Valid())
+                return;
+
+            num_buckets = (uint32_t)((timeout_ns + granularity_ns - 1) / granularity_ns + 2);
+            Link none = {LIVENESS_NONE, LIVENESS_NONE};
+            links.assign((size_t)capacity + num_buckets + 1, none);
+            stamps.assign(num_buckets, LIVENESS_EMPTY);
+            for (uint32_t list = capacity; list < capacity + num_buckets + 1; list++)
+                links[list].next = links[list].prev = list;
+            swept = INT64_MIN;
+        }
+
+        CLivenessTracker(const CLivenessTracker&) = delete;
+        CLivenessTracker& operator=(const CLivenessTracker&) = delete;
+
+        /**
+         *  Whether the parameters made sense. An invalid tracker 
+         *  tracks nothing.
+         */
+        bool Valid() const
+        {
+            return capacity > 0 && capacity <= 0x80000000u && 
+                   timeout_ns >= 0 && granularity_ns > 0 &&
+                   timeout_ns / granularity_ns < 0x40000000;
+        }
+
+        /**
+         *  Record that an entity was seen at now, tracking it if it 
+         *  was not already.
+         *  @return false if id is out of range.
+         */
+        bool Touch(uint32_t id, const CTimeSpec& now)
+        {
+            if (id >= capacity || links.empty())
+                return false;
+
+            int64_t tick = Tick(ToNs(now));
+            if (tick < swept)
+                tick = swept;
+
+            //
+            //  A slot still holding a bucket a whole turn older is all
+            //  expired; move it aside for the next sweep. A touch a 
+            //  whole turn older than the slot, from a clock that went
+            //  back, joins the newer bucket and expires late.
+            //
+            uint32_t slot = Slot(tick);
+            if (stamps[slot] == LIVENESS_EMPTY || stamps[slot] < tick) {
+                Splice(capacity + slot, Pending());
+                stamps[slot] = tick;
+            }
+
+            if (links[id].next == LIVENESS_NONE)
+                size++;
+            else
+                Unlink(id);
+            Insert(id, capacity + slot);
+            return true;
+        }
+
+        /**
+         *  Touch at CTimeSpec::NowMonotonic().
+         */
+        bool Touch(uint32_t id)
+        {
+            return Touch(id, CTimeSpec::NowMonotonic());
+        }
+
+        /**
+         *  Stop tracking an entity.
+         *  @return false if it was not tracked.
+         */
+        bool Remove(uint32_t id)
+        {
+            if (!Tracked(id))
+                return false;
+            Unlink(id);
+            links[id].next = links[id].prev = LIVENESS_NONE;
+            size--;
+            return true;
+        }
+
+        bool Tracked(uint32_t id) const
+        {
+            return id < capacity && !links.empty() && links[id].next != LIVENESS_NONE;
+        }
+
+        /**
+         *  Untrack every entity that has expired as of now, calling 
+         *  on_expired(id) for each. The callback may Touch() or 
+         *  Remove() any id, including the one passed.
+         *  @return number expired.
+         */
+        template <typename Callback>
+        size_t Expire(const CTimeSpec& now, Callback on_expired)
+        {
+            if (links.empty())
+                return 0;
+
+            //
+            //  Buckets before limit end at least timeout ago. Each slot
+            //  in the last turn is looked at once, however far now has
+            //  jumped. They are all moved to the pending list before 
+            //  any callback runs, so touches from the callback land in
+            //  live buckets only.
+            //
+            int64_t limit = Tick(ToNs(now) - timeout_ns);
+            if (limit > swept) {
+                int64_t first = swept;
+                if (first == INT64_MIN || limit - first > (int64_t)num_buckets)
+                    first = limit - num_buckets;
+                for (int64_t tick = first; tick < limit; tick++) {
+                    uint32_t slot = Slot(tick);
+                    if (stamps[slot] != LIVENESS_EMPTY && stamps[slot] < limit) {
+                        Splice(capacity + slot, Pending());
+                        stamps[slot] = LIVENESS_EMPTY;
+                    }
+                }
+                swept = limit;
+            }
+            return Drain(Pending(), on_expired);
+        }
+
+        /**
+         *  Expire at CTimeSpec::NowMonotonic().
+         */
+        template <typename Callback>
+        size_t Expire(Callback on_expired)
+        {
+            return Expire(CTimeSpec::NowMonotonic(), on_expired);
+        }
+
+        /**
+         *  Number of entities tracked.
+         */
+        size_t Size() const
+        {
+            return size;
+        }
+
+        uint32_t Capacity() const
+        {
+            return capacity;
+        }
+
+        /**
+         *  Bytes held by the tracker.
+         */
+        size_t MemoryUsage() const
+        {
+            return sizeof(*this) + links.capacity() * sizeof(Link) + 
+                   stamps.capacity() * sizeof(int64_t);
+        }
+
+    private:
+
+        struct Link
+        {
+            uint32_t next;
+            uint32_t prev;
+        };
+
+        static int64_t ToNs(const CTimeSpec& value)
+        {
+            struct timespec ts = value.c_timespec();
+            return (int64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+        }
+
+        int64_t Tick(int64_t ns) const
+        {
+            int64_t tick = ns / granularity_ns;
+            return (ns % granularity_ns < 0) ? tick - 1 : tick;
+        }
+
+        uint32_t Slot(int64_t tick) const
+        {
+            int64_t slot = tick % (int64_t)num_buckets;
+            return (uint32_t)(slot < 0 ? slot + num_buckets : slot);
+        }
+
+        /**
+         *  Sentinel of the list of entities known to be expired.
+         */
+        uint32_t Pending() const
+        {
+            return capacity + num_buckets;
+        }
+
+        void Insert(uint32_t id, uint32_t list)
+        {
+            uint32_t head = links[list].next;
+            links[id].next = head;
+            links[id].prev = list;
+            links[head].prev = id;
+            links[list].next = id;
+        }
+
+        void Unlink(uint32_t id)
+        {
+            Link link = links[id];
+            links[link.prev].next = link.next;
+            links[link.next].prev = link.prev;
+        }
+
+        /**
+         *  Move every entity of one list onto another.
+         */
+        void Splice(uint32_t from, uint32_t to)
+        {
+            if (links[from].next == from)
+                return;
+            uint32_t first = links[from].next;
+            uint32_t last = links[from].prev;
+            uint32_t head = links[to].next;
+            links[first].prev = to;
+            links[to].next = first;
+            links[last].next = head;
+            links[head].prev = last;
+            links[from].next = links[from].prev = from;
+        }
+
+        template <typename Callback>
+        size_t Drain(uint32_t list, Callback& on_expired)
+        {
+            size_t drained = 0;
+            while (links[list].next != list) {
+                uint32_t id = links[list].next;
+                Unlink(id);
+                links[id].next = links[id].prev = LIVENESS_NONE;
+                size--;
+                drained++;
+                on_expired(id);
+            }
+            return drained;
+        }
+
+        uint32_t capacity;
+        int64_t timeout_ns;
+        int64_t granularity_ns;
+        uint32_t num_buckets;
+
+        /**
+         *  Ticks below this have been expired.
+         */
+        int64_t swept;
+        size_t size;
+
+        /**
+         *  Entities first, then a sentinel per bucket, then the 
+         *  pending sentinel. Both links of an entity share a cache
+         *  line.
+         */
+        std::vector<Link> links;
+
+        /**
+         *  Tick each bucket holds, or LIVENESS_EMPTY.
+         */
+        std::vector<int64_t> stamps;
+};
+
+
+#endif
@@ -0,0 +1,319 @@
+/**
+ *  @file
+ *
+ *  Releases messages at a fixed rate, for replays and load 
+ *  generators, without the bunching of sleeping one interval per 
+ *  message.
+ *
+ *  Release times are exact: the n-th message is due at start + 
+ *  floor(n * per / messages) ns, kept with a Bresenham style 
+ *  accumulator of the fractional nanoseconds instead of a rounded
+ *  interval, so the rate never drifts. Waiting is hybrid: 
+ *  clock_nanosleep() to an absolute time short of the deadline, then
+ *  spinning on CLOCK_MONOTONIC for the rest, which hides the sleep's
+ *  wakeup latency. When the sender falls behind, every message that
+ *  is due is released as one batch rather than one per wait.
+ *
+ *  Lateness (departure minus due time, for the first message of each
+ *  release) is kept in a CLatencyHistogram, with its standard 
+ *  deviation as the jitter figure.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef MESSAGE_PACER_HPP__
+#define MESSAGE_PACER_HPP__
+
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "time_utilities.hpp"
+#include "latency_histogram.hpp"
+#include "busy_delay.hpp"
+
+
+class CMessagePacer
+{
+    public:
+
+        /**
+         *  @param messages how many messages to release every "per".
+         *  @param per the period the rate is over, > 0.
+         */
+        explicit CMessagePacer(uint64_t messages, const CTimeSpec& per = CTimeSpec(1, 0))
+            : messages(messages), whole_ns(0), remainder(0), accumulated(0), 
+              start_ns(0), next_ns(0), last_ns(0), released(0), releases(0), batched(0), 
+              rebased(0), spin_ns(50 * 1000), max_lag_ns(0), lateness_mean(0), lateness_m2(0)
+        {
+            int64_t per_ns = ToNs(per);
+            if (messages > 0 && per_ns > 0) {
+                whole_ns = per_ns / (int64_t)messages;
+                remainder = (uint64_t)(per_ns % (int64_t)messages);
+            }
+            Start();
+        }
+
+        CMessagePacer(const CMessagePacer&) = delete;
+        CMessagePacer& operator=(const CMessagePacer&) = delete;
+
+        bool Valid() const
+        {
+            return whole_ns > 0 || remainder > 0;
+        }
+
+        /**
+         *  Restart the schedule, with the first message due at now,
+         *  and clear the statistics.
+         */
+        void Start(const CTimeSpec& now)
+        {
+            start_ns = next_ns = last_ns = ToNs(now);
+            accumulated = 0;
+            released = releases = batched = rebased = 0;
+            lateness.Reset();
+            lateness_mean = lateness_m2 = 0;
+        }
+
+        void Start()
+        {
+            Start(CTimeSpec::NowMonotonic());
+        }
+
+        /**
+         *  How long before a deadline to stop sleeping and start 
+         *  spinning (default 50us). Zero sleeps all the way, a value 
+         *  beyond the interval spins all the time.
+         */
+        void SetSpinThreshold(const CTimeSpec& threshold)
+        {
+            spin_ns = ToNs(threshold);
+        }
+
+        /**
+         *  If the sender falls further behind than this, skip the 
+         *  backlog and restart the schedule from now instead of 
+         *  releasing it in a burst. Zero (the default) never skips.
+         */
+        void SetMaxLag(const CTimeSpec& lag)
+        {
+            max_lag_ns = ToNs(lag);
+        }
+
+        /**
+         *  Block until the next message is due.
+         *  @param max_batch most messages to release at once, >= 1.
+         *  @return number of messages to send now, at least 1, more
+         *  when behind.
+         */
+        size_t Wait(size_t max_batch = 1)
+        {
+            if (!Valid())
+                return 0;
+            SleepUntil(next_ns);
+            return Release(ToNs(CTimeSpec::NowMonotonic()), max_batch);
+        }
+
+        /**
+         *  Without blocking, how many messages are due at now, for 
+         *  callers with their own event loop. Those returned are 
+         *  counted as sent.
+         */
+        size_t Due(const CTimeSpec& now, size_t max_batch = 1)
+        {
+            int64_t now_ns = ToNs(now);
+            if (!Valid() || now_ns < next_ns)
+                return 0;
+            return Release(now_ns, max_batch);
+        }
+
+        /**
+         *  When the next message is due, on CLOCK_MONOTONIC.
+         */
+        CTimeSpec NextRelease() const
+        {
+            return FromNs(next_ns);
+        }
+
+        /**
+         *  Messages released since Start(), and in how many releases.
+         */
+        uint64_t Released() const
+        {
+            return released;
+        }
+
+        uint64_t Releases() const
+        {
+            return releases;
+        }
+
+        /**
+         *  Releases of more than one message, from being behind.
+         */
+        uint64_t Batched() const
+        {
+            return batched;
+        }
+
+        /**
+         *  Times the backlog was skipped under SetMaxLag().
+         */
+        uint64_t Rebased() const
+        {
+            return rebased;
+        }
+
+        /**
+         *  Messages per second achieved from Start() to the latest 
+         *  release.
+         */
+        double AchievedRate() const
+        {
+            if (last_ns <= start_ns)
+                return 0;
+            return (double)released * NS_IN_SECOND / (double)(last_ns - start_ns);
+        }
+
+        /**
+         *  Departure minus due time of each release, in ns.
+         */
+        const CLatencyHistogram& Lateness() const
+        {
+            return lateness;
+        }
+
+        /**
+         *  Standard deviation of the lateness, in ns.
+         */
+        double JitterNs() const
+        {
+            return releases > 1 ? std::sqrt(lateness_m2 / (double)(releases - 1)) : 0;
+        }
+
+    private:
+
+        static int64_t ToNs(const CTimeSpec& value)
+        {
+            struct timespec ts = value.c_timespec();
+            return (int64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+        }
+
+        static CTimeSpec FromNs(int64_t ns)
+        {
+            int64_t sec = ns / NS_IN_SECOND;
+            int64_t nsec = ns % NS_IN_SECOND;
+            if (nsec < 0) {
+                sec--;
+                nsec += NS_IN_SECOND;
+            }
+            return CTimeSpec((time_t)sec, (long)nsec);
+        }
+
+        /**
+         *  Step to the next due time: the whole ns of the interval, 
+         *  and one more each time the fractions add up to one.
+         */
+        void Advance()
+        {
+            next_ns += whole_ns;
+            accumulated += remainder;
+            if (accumulated >= messages) {
+                accumulated -= messages;
+                next_ns++;
+            }
+        }
+
+        size_t Release(int64_t now_ns, size_t max_batch)
+        {
+            if (max_lag_ns > 0 && now_ns - next_ns > max_lag_ns) {
+                next_ns = now_ns;
+                accumulated = 0;
+                rebased++;
+            }
+
+            int64_t late = now_ns - next_ns;
+            size_t count = 0;
+            if (max_batch == 0)
+                max_batch = 1;
+            while (count < max_batch && next_ns <= now_ns) {
+                Advance();
+                count++;
+            }
+
+            released += count;
+            releases++;
+            if (count > 1)
+                batched++;
+            last_ns = now_ns;
+
+            lateness.Record((uint64_t)late);
+            double delta = (double)late - lateness_mean;
+            lateness_mean += delta / (double)releases;
+            lateness_m2 += delta * ((double)late - lateness_mean);
+            return count;
+        }
+
+        /**
+         *  Sleep to spin_ns short of the deadline, then spin.
+         */
+        void SleepUntil(int64_t deadline_ns) const
+        {
+            if (deadline_ns - spin_ns > ToNs(CTimeSpec::NowMonotonic())) {
+                struct timespec wake = FromNs(deadline_ns - spin_ns).c_timespec();
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR)
+                    ;
+            }
+            while (ToNs(CTimeSpec::NowMonotonic()) < deadline_ns)
+                CBusyDelay::Pause();
+        }
+
+        /**
+         *  The rate as messages per period: the interval is whole_ns
+         *  plus remainder / messages ns.
+         */
+        uint64_t messages;
+        int64_t whole_ns;
+        uint64_t remainder;
+        uint64_t accumulated;
+
+        int64_t start_ns;
+        int64_t next_ns;
+        int64_t last_ns;
+
+        uint64_t released;
+        uint64_t releases;
+        uint64_t batched;
+        uint64_t rebased;
+
+        int64_t spin_ns;
+        int64_t max_lag_ns;
+
+        CLatencyHistogram lateness;
+        double lateness_mean;
+        double lateness_m2;
+};
+
+
+#endif
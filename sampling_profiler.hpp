@@ -0,0 +1,427 @@
+/**
+ *  @file
+ *
+ *  A small in-process sampling profiler built on POSIX interval 
+ *  timers.
+ *
+ *  Every thread that wants to be profiled gets its own timer on 
+ *  CLOCK_THREAD_CPUTIME_ID, so samples are taken in proportion to 
+ *  the CPU time each thread burns, and idle or blocked threads cost
+ *  nothing. The timer signal (SIGPROF) is delivered to the thread 
+ *  that owns the timer, whose handler captures a backtrace into a 
+ *  fixed size, preallocated buffer. Slots in the buffer are claimed
+ *  with a single atomic increment, so the handler never locks and 
+ *  never allocates.
+ *
+ *  When done, WriteCollapsed() symbolizes the samples and writes 
+ *  them in the "collapsed stacks" format read by flamegraph.pl and
+ *  most flame graph viewers:
+ *
+ *      main;Work;Inner 42
+ *
+ *  Symbol names come from dladdr(), so link executables with 
+ *  -rdynamic (CMake: ENABLE_EXPORTS) to see functions that are not
+ *  in a shared library.
+ *
+ *  backtrace() is not formally async-signal-safe, only because its 
+ *  first call may load the unwinder. The profiler calls it once 
+ *  up front so that never happens inside the handler.
+ *
+ *  Linux only (SIGEV_THREAD_ID). This header requires C++11 support.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SAMPLING_PROFILER_HPP__
+#define SAMPLING_PROFILER_HPP__
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <csignal>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "time_utilities.hpp"
+
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+
+/**
+ *  Process wide sampling profiler. Only one can be running at a time.
+ */
+class CSamplingProfiler
+{
+    public:
+
+        /**
+         *  Deepest stack recorded per sample, deeper stacks are cut
+         *  off at the root end.
+         */
+        static const int MAX_DEPTH = 48;
+
+        /**
+         *  ctor - start profiling, and add the calling thread.
+         *  @param interval CPU time between samples of each thread.
+         *  @param max_samples samples kept; later ones are counted 
+         *  as dropped.
+         *  Check Running() to see whether the profiler started.
+         */
+        CSamplingProfiler(const CTimeSpec& interval, size_t max_samples = 10000)
+        : interval(interval),
+          capacity(max_samples),
+          samples(new Sample[max_samples]),
+          next(0),
+          dropped(0),
+          overruns(0),
+          running(false)
+        {
+            void *warm_up[1];
+            backtrace(warm_up, 1);
+
+            CSamplingProfiler *expected = nullptr;
+            if (!Active().compare_exchange_strong(expected, this))
+                return;
+
+            struct sigaction action;
+            memset(&action, 0, sizeof(action));
+            action.sa_sigaction = Handler;
+            action.sa_flags = SA_SIGINFO | SA_RESTART;
+            sigemptyset(&action.sa_mask);
+
+            if (sigaction(SIGPROF, &action, &previous_action) != 0) {
+                Active().store(nullptr);
+                return;
+            }
+
+            running = true;
+            AddCurrentThread();
+        }
+
+        /**
+         *  dtor - stop profiling. Samples are discarded, write them 
+         *  out first.
+         */
+        ~CSamplingProfiler()
+        {
+            Stop();
+        }
+
+        CSamplingProfiler(const CSamplingProfiler&) = delete;
+        CSamplingProfiler& operator=(const CSamplingProfiler&) = delete;
+
+        /**
+         *  True if the profiler started and has not been stopped.
+         */
+        bool Running() const
+        {
+            return running;
+        }
+
+        /**
+         *  Start sampling the calling thread.
+         *  @return true on success.
+         */
+        bool AddCurrentThread()
+        {
+            if (!running)
+                return false;
+
+            struct sigevent event;
+            memset(&event, 0, sizeof(event));
+            event.sigev_notify = SIGEV_THREAD_ID;
+            event.sigev_signo = SIGPROF;
+            event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+
+            timer_t timer;
+            if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer) != 0)
+                return false;
+
+            struct itimerspec spec;
+            spec.it_interval = interval.c_timespec();
+            spec.it_value = interval.c_timespec();
+            if (timer_settime(timer, 0, &spec, nullptr) != 0) {
+                timer_delete(timer);
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(timers_mutex);
+            timers.push_back(ThreadTimer {event.sigev_notify_thread_id, timer});
+            return true;
+        }
+
+        /**
+         *  Stop sampling the calling thread. Threads should call this
+         *  before exiting if the profiler outlives them.
+         */
+        void RemoveCurrentThread()
+        {
+            pid_t tid = (pid_t)syscall(SYS_gettid);
+            std::lock_guard<std::mutex> lock(timers_mutex);
+
+            for (size_t i = 0; i < timers.size(); i++) {
+                if (timers[i].tid == tid) {
+                    timer_delete(timers[i].timer);
+                    timers.erase(timers.begin() + i);
+                    return;
+                }
+            }
+        }
+
+        /**
+         *  Stop all timers. Samples already taken are kept.
+         *
+         *  The SIGPROF handler stays installed if the previous 
+         *  disposition was the default (terminate), since a signal 
+         *  may still be pending; it just does nothing from now on.
+         */
+        void Stop()
+        {
+            if (!running)
+                return;
+            running = false;
+
+            {
+                std::lock_guard<std::mutex> lock(timers_mutex);
+                for (const ThreadTimer &t : timers)
+                    timer_delete(t.timer);
+                timers.clear();
+            }
+
+            Active().store(nullptr);
+            while (HandlersRunning().load() != 0)
+                ;
+
+            if (previous_action.sa_handler != SIG_DFL)
+                sigaction(SIGPROF, &previous_action, nullptr);
+        }
+
+        /**
+         *  Number of samples recorded.
+         */
+        size_t Samples() const
+        {
+            size_t n = next.load();
+            return n < capacity ? n : capacity;
+        }
+
+        /**
+         *  Number of samples lost because the buffer was full.
+         */
+        size_t Dropped() const
+        {
+            return dropped.load();
+        }
+
+        /**
+         *  Number of timer expirations that never became a signal, 
+         *  because the previous one was still pending (e.g. while 
+         *  the thread was preempted). Samples() + Dropped() + 
+         *  Overruns() is the number of intervals of CPU time used.
+         */
+        size_t Overruns() const
+        {
+            return overruns.load();
+        }
+
+        /**
+         *  Write all samples as collapsed stacks, root first, one 
+         *  line per distinct stack with its count.
+         */
+        void WriteCollapsed(std::ostream& os) const
+        {
+            std::map<void *, std::string> symbols;
+            std::map<std::string, size_t> stacks;
+            size_t n = Samples();
+
+            for (size_t i = 0; i < n; i++) {
+                const Sample &sample = samples[i];
+                if (!sample.ready.load(std::memory_order_acquire))
+                    continue;
+
+                std::string line;
+                for (int f = sample.depth - 1; f >= 0; f--) {
+                    //
+                    //  Every frame but the interrupted one is a 
+                    //  return address, which may already belong 
+                    //  to the next function. Look up the call.
+                    //
+                    void *pc = sample.frames[f];
+                    if (f != 0)
+                        pc = (void *)((uintptr_t)pc - 1);
+
+                    auto it = symbols.find(pc);
+                    if (it == symbols.end())
+                        it = symbols.insert(std::make_pair(pc, Symbolize(pc))).first;
+                    if (!line.empty())
+                        line += ';';
+                    line += it->second;
+                }
+                stacks[line]++;
+            }
+
+            for (const auto &stack : stacks)
+                os << stack.first << ' ' << stack.second << '\n';
+        }
+
+    private:
+        /**
+         *  One recorded stack. frames[0] is the interrupted pc.
+         */
+        struct Sample
+        {
+            std::atomic<int> ready;
+            int depth;
+            void *frames[MAX_DEPTH];
+
+            Sample() : ready(0), depth(0) {}
+        };
+
+        struct ThreadTimer
+        {
+            pid_t tid;
+            timer_t timer;
+        };
+
+        /**
+         *  Frames belonging to the handler and the kernel's signal
+         *  return trampoline, skipped in every sample.
+         */
+        static const int SKIP_FRAMES = 2;
+
+        static std::atomic<CSamplingProfiler *>& Active()
+        {
+            static std::atomic<CSamplingProfiler *> active {nullptr};
+            return active;
+        }
+
+        static std::atomic<int>& HandlersRunning()
+        {
+            static std::atomic<int> handlers {0};
+            return handlers;
+        }
+
+        /**
+         *  SIGPROF handler. Announces itself before looking for the 
+         *  profiler, so Stop() can wait for handlers in flight.
+         */
+        static void Handler(int, siginfo_t *info, void *)
+        {
+            int saved_errno = errno;
+            HandlersRunning().fetch_add(1);
+
+            CSamplingProfiler *profiler = Active().load();
+            if (profiler)
+                profiler->Record(info && info->si_code == SI_TIMER ? info->si_overrun : 0);
+
+            HandlersRunning().fetch_sub(1);
+            errno = saved_errno;
+        }
+
+        void Record(int overrun)
+        {
+            if (overrun > 0)
+                overruns.fetch_add((size_t)overrun, std::memory_order_relaxed);
+
+            size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+            if (slot >= capacity) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            void *frames[MAX_DEPTH + SKIP_FRAMES];
+            int depth = backtrace(frames, MAX_DEPTH + SKIP_FRAMES) - SKIP_FRAMES;
+            if (depth < 0)
+                depth = 0;
+
+            Sample &sample = samples[slot];
+            memcpy(sample.frames, frames + SKIP_FRAMES, depth * sizeof(void *));
+            sample.depth = depth;
+            sample.ready.store(1, std::memory_order_release);
+        }
+
+        /**
+         *  Best effort name for a code address: the demangled symbol,
+         *  else module+offset, else the raw address.
+         */
+        static std::string Symbolize(void *pc)
+        {
+            Dl_info info;
+            char buffer[64];
+
+            if (dladdr(pc, &info) && info.dli_sname) {
+                int status = 0;
+                char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+                std::string name = status == 0 && demangled ? demangled : info.dli_sname;
+                free(demangled);
+                //
+                //  ';' separates frames, keep it out of names.
+                //
+                for (char &c : name) {
+                    if (c == ';')
+                        c = '_';
+                }
+                return name;
+            }
+
+            if (dladdr(pc, &info) && info.dli_fname) {
+                const char *base = strrchr(info.dli_fname, '/');
+                snprintf(buffer, sizeof(buffer), "+0x%lx", 
+                         (unsigned long)((uintptr_t)pc - (uintptr_t)info.dli_fbase));
+                return std::string(base ? base + 1 : info.dli_fname) + buffer;
+            }
+
+            snprintf(buffer, sizeof(buffer), "0x%lx", (unsigned long)(uintptr_t)pc);
+            return buffer;
+        }
+
+        CTimeSpec interval;
+        size_t capacity;
+        std::unique_ptr<Sample[]> samples;
+        std::atomic<size_t> next;
+        std::atomic<size_t> dropped;
+        std::atomic<size_t> overruns;
+        bool running;
+
+        struct sigaction previous_action;
+        std::mutex timers_mutex;
+        std::vector<ThreadTimer> timers;
+};
+
+
+#endif
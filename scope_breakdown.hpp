@@ -0,0 +1,298 @@
+/**
+ *  @file
+ *
+ *  Instrumentation telling where a scope's time went: running on a
+ *  CPU, or off it (blocked, sleeping, or runnable but waiting).
+ *
+ *  On entry and exit a CScopeBreakdown reads the monotonic clock, 
+ *  the thread's CPU clock and, optionally, the thread's voluntary 
+ *  and involuntary context switch counts (getrusage(RUSAGE_THREAD)).
+ *  The differences are recorded into per scope name statistics held
+ *  in a process wide registry, which can dump a report at any time.
+ *
+ *      void HandleRequest()
+ *      {
+ *          TIME_SCOPE_BREAKDOWN("HandleRequest");
+ *          ...
+ *      }
+ *
+ *      CScopeRegistry::Instance().WriteReport(std::cerr);
+ *
+ *  Many voluntary switches with high off-CPU time means the scope 
+ *  blocked; involuntary switches with high off-CPU time means it 
+ *  was preempted and waited for a CPU.
+ *
+ *  This header requires C++11 support.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SCOPE_BREAKDOWN_HPP__
+#define SCOPE_BREAKDOWN_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <sys/resource.h>
+
+#include "time_utilities.hpp"
+#include "latency_histogram.hpp"
+
+
+/**
+ *  Aggregated measurements of one scope name.
+ */
+class CScopeStats
+{
+    public:
+
+        explicit CScopeStats(const std::string& name)
+        : name(name), voluntary_switches(0), involuntary_switches(0)
+        {}
+
+        CScopeStats(const CScopeStats&) = delete;
+        CScopeStats& operator=(const CScopeStats&) = delete;
+
+        /**
+         *  Record one execution of the scope.
+         */
+        void Record(const CTimeSpec& wall_time, const CTimeSpec& cpu_time,
+                    long voluntary, long involuntary)
+        {
+            CTimeSpec off = wall_time > cpu_time ? wall_time - cpu_time : CTimeSpec();
+            wall.Record(wall_time);
+            cpu.Record(cpu_time);
+            off_cpu.Record(off);
+            voluntary_switches.fetch_add((uint64_t)voluntary, std::memory_order_relaxed);
+            involuntary_switches.fetch_add((uint64_t)involuntary, std::memory_order_relaxed);
+        }
+
+        void Reset()
+        {
+            wall.Reset();
+            cpu.Reset();
+            off_cpu.Reset();
+            voluntary_switches.store(0, std::memory_order_relaxed);
+            involuntary_switches.store(0, std::memory_order_relaxed);
+        }
+
+        const std::string& Name() const
+        {
+            return name;
+        }
+
+        const CLatencyHistogram& Wall() const
+        {
+            return wall;
+        }
+
+        const CLatencyHistogram& Cpu() const
+        {
+            return cpu;
+        }
+
+        const CLatencyHistogram& OffCpu() const
+        {
+            return off_cpu;
+        }
+
+        uint64_t VoluntarySwitches() const
+        {
+            return voluntary_switches.load(std::memory_order_relaxed);
+        }
+
+        uint64_t InvoluntarySwitches() const
+        {
+            return involuntary_switches.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::string name;
+        CLatencyHistogram wall;
+        CLatencyHistogram cpu;
+        CLatencyHistogram off_cpu;
+        std::atomic<uint64_t> voluntary_switches;
+        std::atomic<uint64_t> involuntary_switches;
+};
+
+
+/**
+ *  Process wide map from scope name to its statistics. Entries are
+ *  never removed, so references handed out stay valid.
+ */
+class CScopeRegistry
+{
+    public:
+
+        static CScopeRegistry& Instance()
+        {
+            static CScopeRegistry instance;
+            return instance;
+        }
+
+        /**
+         *  Statistics for "name", created on first use. Takes a lock,
+         *  so look a scope up once and keep the reference (which is 
+         *  what TIME_SCOPE_BREAKDOWN does).
+         */
+        CScopeStats& Get(const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::unique_ptr<CScopeStats> &entry = scopes[name];
+            if (!entry)
+                entry.reset(new CScopeStats(name));
+            return *entry;
+        }
+
+        /**
+         *  Clear the statistics of every scope.
+         */
+        void Reset()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto &scope : scopes)
+                scope.second->Reset();
+        }
+
+        /**
+         *  Write a table of every scope, times in microseconds:
+         *  count, wall / cpu / off-CPU percentiles, the share of 
+         *  total wall time spent off CPU, and mean context switches 
+         *  per execution.
+         */
+        void WriteReport(std::ostream& os)
+        {
+            char line[256];
+            std::lock_guard<std::mutex> lock(mutex);
+
+            snprintf(line, sizeof(line), 
+                     "%-24s %9s %10s %10s %10s %10s %10s %10s %7s %7s %7s\n",
+                     "scope", "count", "wall p50", "wall p99", "wall max", 
+                     "cpu p50", "cpu p99", "off p99", "off %", "vcsw", "ivcsw");
+            os << line;
+
+            for (auto &scope : scopes) {
+                const CScopeStats &s = *scope.second;
+                uint64_t n = s.Wall().Count();
+                if (n == 0)
+                    continue;
+
+                double wall_total = (double)s.Wall().Sum();
+                double off_total = (double)s.OffCpu().Sum();
+
+                snprintf(line, sizeof(line), 
+                         "%-24s %9llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f %6.1f%% %7.2f %7.2f\n",
+                         s.Name().c_str(), (unsigned long long)n,
+                         s.Wall().Percentile(50) / 1e3, s.Wall().Percentile(99) / 1e3,
+                         s.Wall().Max() / 1e3,
+                         s.Cpu().Percentile(50) / 1e3, s.Cpu().Percentile(99) / 1e3,
+                         s.OffCpu().Percentile(99) / 1e3,
+                         wall_total > 0 ? 100.0 * off_total / wall_total : 0.0,
+                         (double)s.VoluntarySwitches() / n, 
+                         (double)s.InvoluntarySwitches() / n);
+                os << line;
+            }
+        }
+
+    private:
+        CScopeRegistry() {}
+
+        std::mutex mutex;
+        std::map<std::string, std::unique_ptr<CScopeStats>> scopes;
+};
+
+
+/**
+ *  Measures the scope it lives in and records it into a CScopeStats
+ *  on exit. Must be destroyed on the thread that created it.
+ */
+class CScopeBreakdown
+{
+    public:
+
+        /**
+         *  ctor
+         *  @param stats where the measurement is recorded.
+         *  @param count_switches also count context switches. Costs 
+         *  two getrusage() syscalls per scope.
+         */
+        explicit CScopeBreakdown(CScopeStats& stats, bool count_switches = true)
+        : stats(stats), count_switches(count_switches), voluntary(0), involuntary(0)
+        {
+            if (count_switches) {
+                struct rusage usage;
+                getrusage(RUSAGE_THREAD, &usage);
+                voluntary = usage.ru_nvcsw;
+                involuntary = usage.ru_nivcsw;
+            }
+            cpu_start = CTimeSpec::NowThreadCpu();
+            wall_start = CTimeSpec::NowMonotonic();
+        }
+
+        ~CScopeBreakdown()
+        {
+            CTimeSpec wall = CTimeSpec::NowMonotonic() - wall_start;
+            CTimeSpec cpu = CTimeSpec::NowThreadCpu() - cpu_start;
+
+            if (count_switches) {
+                struct rusage usage;
+                getrusage(RUSAGE_THREAD, &usage);
+                voluntary = usage.ru_nvcsw - voluntary;
+                involuntary = usage.ru_nivcsw - involuntary;
+            }
+
+            stats.Record(wall, cpu, voluntary, involuntary);
+        }
+
+        CScopeBreakdown(const CScopeBreakdown&) = delete;
+        CScopeBreakdown& operator=(const CScopeBreakdown&) = delete;
+
+    private:
+        CScopeStats& stats;
+        bool count_switches;
+        long voluntary;
+        long involuntary;
+        CTimeSpec cpu_start;
+        CTimeSpec wall_start;
+};
+
+
+#define TIME_SCOPE_CONCAT_(a_, b_) a_ ## b_
+#define TIME_SCOPE_CONCAT(a_, b_) TIME_SCOPE_CONCAT_(a_, b_)
+
+/**
+ *  Measure the rest of the enclosing scope under "name_". The 
+ *  registry lookup happens once per call site.
+ */
+#define TIME_SCOPE_BREAKDOWN(name_) \
+    static CScopeStats& TIME_SCOPE_CONCAT(time_scope_stats_, __LINE__) = \
+        CScopeRegistry::Instance().Get(name_); \
+    CScopeBreakdown TIME_SCOPE_CONCAT(time_scope_, __LINE__) \
+        {TIME_SCOPE_CONCAT(time_scope_stats_, __LINE__)}
+
+
+#endif
@@ -0,0 +1,1113 @@
+/**
+ *  @file
+ *
+ *  Text formatting of CTimeSpec values into caller supplied buffers,
+ *  without floating point, iostreams, locales or allocation.
+ *
+ *  Functions write at most "size" bytes, do not NUL terminate, and 
+ *  return the number of bytes written. If the result does not fit 
+ *  nothing is written and 0 is returned.
+ *
+ *  This header requires C++11 support.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef TIME_FORMAT_HPP__
+#define TIME_FORMAT_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "time_utilities.hpp"
+
+
+/**
+ *  Longest output of FormatSeconds(): sign, 20 integer digits,
+ *  point and 9 fraction digits.
+ */
+#define SECONDS_FORMAT_MAX  (31)
+
+
+/**
+ *  Building blocks shared by the formatters in this header.
+ */
+class CFormatDigits
+{
+    public:
+
+        /**
+         *  "00" through "99", so digits can be written two at a time.
+         */
+        static const char *Pairs()
+        {
+            static const char pairs[201] =
+                "00010203040506070809101112131415161718192021222324"
+                "25262728293031323334353637383940414243444546474849"
+                "50515253545556575859606162636465666768697071727374"
+                "75767778798081828384858687888990919293949596979899";
+            return pairs;
+        }
+
+        /**
+         *  10^n for n in [0, 19].
+         */
+        static uint64_t Pow10(int n)
+        {
+            static const uint64_t powers[20] = {
+                1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+                10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+                100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+                100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+                100000000000000000ULL, 1000000000000000000ULL, 
+                10000000000000000000ULL
+            };
+            return powers[n];
+        }
+
+        /**
+         *  Number of decimal digits in v, at least 1.
+         */
+        static int CountDigits(uint64_t v)
+        {
+            int n = 1;
+            while (n < 20 && v >= Pow10(n))
+                n++;
+            return n;
+        }
+
+        /**
+         *  Write v as exactly "width" digits, zero padded on the left
+         *  (high digits beyond width are dropped). Returns out + width.
+         */
+        static char *WriteFixed(char *out, uint64_t v, int width)
+        {
+            const char *pairs = Pairs();
+            char *p = out + width;
+
+            while (p - out >= 2) {
+                unsigned pair = (unsigned)(v % 100);
+                v /= 100;
+                p -= 2;
+                p[0] = pairs[pair * 2];
+                p[1] = pairs[pair * 2 + 1];
+            }
+            if (p != out)
+                *--p = (char)('0' + v % 10);
+
+            return out + width;
+        }
+
+        /**
+         *  Write v with no padding. Returns one past the last digit.
+         */
+        static char *WriteUnsigned(char *out, uint64_t v)
+        {
+            return WriteFixed(out, v, CountDigits(v));
+        }
+
+        /**
+         *  Split a normalized time into sign and magnitude, taking 
+         *  care that the most negative time_t does not overflow.
+         */
+        static void Magnitude(const struct timespec& ts, bool *negative, 
+                              uint64_t *sec, uint64_t *nsec)
+        {
+            *negative = ts.tv_sec < 0;
+            if (!*negative) {
+                *sec = (uint64_t)ts.tv_sec;
+                *nsec = (uint64_t)ts.tv_nsec;
+            }
+            else if (ts.tv_nsec == 0) {
+                *sec = 0 - (uint64_t)ts.tv_sec;
+                *nsec = 0;
+            }
+            else {
+                *sec = 0 - (uint64_t)ts.tv_sec - 1;
+                *nsec = (uint64_t)(NS_IN_SECOND - ts.tv_nsec);
+            }
+        }
+};
+
+
+/**
+ *  Format a time as decimal seconds, e.g. "12.345" or "-0.000001".
+ *
+ *  This is the exact decimal value of the timespec, rounded half 
+ *  away from zero to "digits" fraction digits. Unlike going through
+ *  a double, no precision is lost for large values (a double only 
+ *  holds about 104 days at nanosecond resolution).
+ *
+ *  @param buffer output, not NUL terminated.
+ *  @param size bytes available in buffer.
+ *  @param value time to format.
+ *  @param digits fraction digits, clamped to [0, 9]. With 0 no
+ *  decimal point is written.
+ *  @return bytes written, 0 if the result would not fit.
+ */
+inline size_t FormatSeconds(char *buffer, size_t size, const CTimeSpec& value, int digits = 9)
+{
+    bool negative;
+    uint64_t sec, nsec;
+
+    if (digits < 0)
+        digits = 0;
+    if (digits > 9)
+        digits = 9;
+
+    CFormatDigits::Magnitude(value.c_timespec(), &negative, &sec, &nsec);
+
+    uint64_t scale = CFormatDigits::Pow10(9 - digits);
+    uint64_t fraction = (nsec + scale / 2) / scale;
+    if (fraction == CFormatDigits::Pow10(digits)) {
+        sec++;
+        fraction = 0;
+    }
+    if (sec == 0 && fraction == 0)
+        negative = false;
+
+    size_t length = (negative ? 1 : 0) + CFormatDigits::CountDigits(sec) + 
+                    (digits ? 1 + digits : 0);
+    if (length > size)
+        return 0;
+
+    char *p = buffer;
+    if (negative)
+        *p++ = '-';
+    p = CFormatDigits::WriteUnsigned(p, sec);
+    if (digits) {
+        *p++ = '.';
+        p = CFormatDigits::WriteFixed(p, fraction, digits);
+    }
+    return length;
+}
+
+
+#ifdef USING_TIMEVAL
+/**
+ *  Format a timeval as decimal seconds. See the CTimeSpec version.
+ */
+inline size_t FormatSeconds(char *buffer, size_t size, const CTimeVal& value, int digits = 6)
+{
+    return FormatSeconds(buffer, size, CTimeSpec(value.c_timeval()), digits);
+}
+#endif
+
+
+/**
+ *  Longest output of FormatDuration(): sign, 16 digits of hours,
+ *  "h59m59.999999999s".
+ */
+#define DURATION_FORMAT_MAX  (34)
+
+
+/**
+ *  Format a duration the way Go prints a time.Duration: "1h30m0s",
+ *  "2.5s", "250ms", "3.5us", "0s". Values under a second use the 
+ *  largest of ms, us or ns that keeps an integer part; longer ones
+ *  are hours, minutes and seconds, leading zero units omitted. 
+ *  Fractions are exact with trailing zeros dropped. Microseconds 
+ *  are written "us", keeping the output ASCII. ParseDuration() in
+ *  time_parse.hpp reads it all back.
+ *
+ *  @param buffer output, not NUL terminated.
+ *  @param size bytes available in buffer.
+ *  @param value duration to format.
+ *  @return bytes written, 0 if the result would not fit.
+ */
+inline size_t FormatDuration(char *buffer, size_t size, const CTimeSpec& value)
+{
+    char scratch[DURATION_FORMAT_MAX];
+    char *p = scratch;
+    bool negative;
+    uint64_t sec, nsec;
+
+    CFormatDigits::Magnitude(value.c_timespec(), &negative, &sec, &nsec);
+
+    if (negative)
+        *p++ = '-';
+
+    //
+    //  Integer part, then the fraction with trailing zeros dropped.
+    //
+    uint64_t whole, fraction;
+    int digits;
+    const char *unit;
+
+    if (sec == 0 && nsec == 0) {
+        whole = 0, fraction = 0, digits = 0, unit = "s";
+    }
+    else if (sec == 0 && nsec < 1000) {
+        whole = nsec, fraction = 0, digits = 0, unit = "ns";
+    }
+    else if (sec == 0 && nsec < 1000000) {
+        whole = nsec / 1000, fraction = nsec % 1000, digits = 3, unit = "us";
+    }
+    else if (sec == 0) {
+        whole = nsec / 1000000, fraction = nsec % 1000000, digits = 6, unit = "ms";
+    }
+    else {
+        uint64_t hours = sec / 3600;
+        uint64_t minutes = sec / 60 % 60;
+
+        if (hours) {
+            p = CFormatDigits::WriteUnsigned(p, hours);
+            *p++ = 'h';
+        }
+        if (hours || minutes) {
+            p = CFormatDigits::WriteUnsigned(p, minutes);
+            *p++ = 'm';
+        }
+        whole = sec % 60, fraction = nsec, digits = 9, unit = "s";
+    }
+
+    p = CFormatDigits::WriteUnsigned(p, whole);
+    if (fraction) {
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            digits--;
+        }
+        *p++ = '.';
+        p = CFormatDigits::WriteFixed(p, fraction, digits);
+    }
+    while (*unit)
+        *p++ = *unit++;
+
+    size_t length = (size_t)(p - scratch);
+    if (length > size)
+        return 0;
+    memcpy(buffer, scratch, length);
+    return length;
+}
+
+
+#ifdef USING_TIMEVAL
+/**
+ *  Format a timeval duration. See the CTimeSpec version.
+ */
+inline size_t FormatDuration(char *buffer, size_t size, const CTimeVal& value)
+{
+    return FormatDuration(buffer, size, CTimeSpec(value.c_timeval()));
+}
+#endif
+
+
+/**
+ *  Formats many durations back to back into one buffer, each 
+ *  followed by a separator, e.g. for building a metrics payload.
+ *
+ *      CSecondsExporter exporter {buffer, sizeof(buffer), 6};
+ *      for (...)
+ *          exporter.Add(latency);
+ *      write(fd, buffer, exporter.Size());
+ */
+class CSecondsExporter
+{
+    public:
+
+        /**
+         *  ctor
+         *  @param buffer output, not NUL terminated.
+         *  @param size bytes available in buffer.
+         *  @param digits fraction digits of every value.
+         *  @param separator byte written after every value.
+         */
+        CSecondsExporter(char *buffer, size_t size, int digits = 9, char separator = '\n')
+        : buffer(buffer), size(size), used(0), digits(digits), separator(separator)
+        {}
+
+        /**
+         *  Append one value and its separator.
+         *  @return false, writing nothing, if it does not fit.
+         */
+        bool Add(const CTimeSpec& value)
+        {
+            size_t room = size - used;
+
+            //
+            //  Format straight into the buffer when it surely fits,
+            //  which is nearly always, else go through a scratch 
+            //  buffer so a failed Add leaves nothing behind.
+            //
+            if (room > SECONDS_FORMAT_MAX) {
+                used += FormatSeconds(buffer + used, room, value, digits);
+                buffer[used++] = separator;
+                return true;
+            }
+
+            char scratch[SECONDS_FORMAT_MAX];
+            size_t n = FormatSeconds(scratch, sizeof(scratch), value, digits);
+            if (n + 1 > room)
+                return false;
+            memcpy(buffer + used, scratch, n);
+            used += n;
+            buffer[used++] = separator;
+            return true;
+        }
+
+        /**
+         *  Append an array of values.
+         *  @return number of values added, less than count if the 
+         *  buffer filled up.
+         */
+        size_t Add(const CTimeSpec *values, size_t count)
+        {
+            for (size_t i = 0; i < count; i++) {
+                if (!Add(values[i]))
+                    return i;
+            }
+            return count;
+        }
+
+        /**
+         *  Bytes written so far.
+         */
+        size_t Size() const
+        {
+            return used;
+        }
+
+        /**
+         *  Start over at the beginning of the buffer.
+         */
+        void Clear()
+        {
+            used = 0;
+        }
+
+    private:
+        char *buffer;
+        size_t size;
+        size_t used;
+        int digits;
+        char separator;
+};
+
+
+/**
+ *  A strftime style pattern compiled once into a list of ops, then 
+ *  used to render many times. Rendering does no allocation, no 
+ *  locale lookup and no pattern parsing; it breaks the time down 
+ *  with CTimeSpec::Civil(), so lines stamped on the same day skip 
+ *  most of the calendar math.
+ *
+ *      static const CTimeFormat format {"%Y-%m-%d %H:%M:%S.%6N "};
+ *      size_t n = format.Format(line, sizeof(line), CTimeSpec::Now());
+ *
+ *  Times are always UTC and names are always English. Supported:
+ *
+ *      %Y  year, at least 4 digits        %y  year % 100, 2 digits
+ *      %m  month 01-12                    %d  day 01-31
+ *      %e  day, space padded              %j  day of year 001-366
+ *      %H  hour 00-23                     %M  minute 00-59
+ *      %S  second 00-59                   %s  seconds since the epoch
+ *      %N  nanoseconds, 9 digits          %1N - %9N  fraction, truncated
+ *      %a  "Mon"    %A  "Monday"          %b  "Jan"    %B  "January"
+ *      %u  weekday 1-7, Monday is 1       %w  weekday 0-6, Sunday is 0
+ *      %F  "%Y-%m-%d"                     %T  "%H:%M:%S"
+ *      %z  "+0000"  %Z  "UTC"             %%  "%"
+ *
+ *  Anything else, or a pattern too long for the fixed op table, 
+ *  makes the format invalid and Format() always returns 0.
+ */
+class CTimeFormat
+{
+    public:
+
+        /**
+         *  Limits of a compiled pattern.
+         */
+        static const int MAX_OPS = 48;
+        static const int MAX_LITERAL = 128;
+
+        /**
+         *  ctor, compiles the pattern.
+         *  @param pattern NUL terminated strftime style pattern.
+         */
+        explicit CTimeFormat(const char *pattern)
+        : num_ops(0), literal_used(0), max_length(0), valid(true)
+        {
+            Compile(pattern);
+        }
+
+        /**
+         *  True if the pattern compiled.
+         */
+        bool Valid() const
+        {
+            return valid;
+        }
+
+        /**
+         *  Upper bound on the output of Format(), so callers can size
+         *  their buffers once.
+         */
+        size_t MaxLength() const
+        {
+            return max_length;
+        }
+
+        /**
+         *  Render a time.
+         *  @param buffer output, not NUL terminated.
+         *  @param size bytes available in buffer.
+         *  @param value time to render, as UTC.
+         *  @return bytes written, 0 if the result would not fit or 
+         *  the format is invalid.
+         */
+        size_t Format(char *buffer, size_t size, const CTimeSpec& value) const
+        {
+            if (!valid)
+                return 0;
+
+            CCivilTime civil = value.Civil();
+            char *p = buffer;
+            char *end = buffer + size;
+
+            for (int i = 0; i < num_ops; i++) {
+                const Op &op = ops[i];
+
+                switch (op.code) {
+                    case OP_LITERAL:
+                        if (end - p < op.length)
+                            return 0;
+                        memcpy(p, literals + op.offset, op.length);
+                        p += op.length;
+                        break;
+
+                    case OP_YEAR:
+                        p = WriteSigned(p, end, civil.year, 4);
+                        break;
+
+                    case OP_EPOCH:
+                        p = WriteSigned(p, end, value.c_timespec().tv_sec, 1);
+                        break;
+
+                    case OP_YEAR_2:
+                        p = WriteFixed(p, end, (uint64_t)(((civil.year % 100) + 100) % 100), 2);
+                        break;
+
+                    case OP_MONTH:
+                        p = WriteFixed(p, end, civil.month, 2);
+                        break;
+
+                    case OP_DAY:
+                        p = WriteFixed(p, end, civil.day, 2);
+                        break;
+
+                    case OP_DAY_SPACE:
+                        p = WriteFixed(p, end, civil.day, 2);
+                        if (p && civil.day < 10)
+                            p[-2] = ' ';
+                        break;
+
+                    case OP_DAY_OF_YEAR:
+                        p = WriteFixed(p, end, civil.day_of_year, 3);
+                        break;
+
+                    case OP_HOUR:
+                        p = WriteFixed(p, end, civil.hour, 2);
+                        break;
+
+                    case OP_MINUTE:
+                        p = WriteFixed(p, end, civil.minute, 2);
+                        break;
+
+                    case OP_SECOND:
+                        p = WriteFixed(p, end, civil.second, 2);
+                        break;
+
+                    case OP_FRACTION:
+                        p = WriteFixed(p, end, (uint64_t)civil.nsec / 
+                                       CFormatDigits::Pow10(9 - op.length), op.length);
+                        break;
+
+                    case OP_WEEKDAY_ISO:
+                        p = WriteFixed(p, end, civil.weekday ? civil.weekday : 7, 1);
+                        break;
+
+                    case OP_WEEKDAY:
+                        p = WriteFixed(p, end, civil.weekday, 1);
+                        break;
+
+                    case OP_WEEKDAY_NAME:
+                        p = WriteName(p, end, WeekdayNames()[civil.weekday], op.length);
+                        break;
+
+                    case OP_MONTH_NAME:
+                        p = WriteName(p, end, MonthNames()[civil.month - 1], op.length);
+                        break;
+                }
+                if (!p)
+                    return 0;
+            }
+            return (size_t)(p - buffer);
+        }
+
+        /**
+         *  English day names, Sunday first, and month names.
+         */
+        static const char *const *WeekdayNames()
+        {
+            static const char *const names[7] = {
+                "Sunday", "Monday", "Tuesday", "Wednesday", 
+                "Thursday", "Friday", "Saturday"
+            };
+            return names;
+        }
+
+        static const char *const *MonthNames()
+        {
+            static const char *const names[12] = {
+                "January", "February", "March", "April", "May", "June", 
+                "July", "August", "September", "October", "November", "December"
+            };
+            return names;
+        }
+
+#ifdef USING_TIMEVAL
+        /**
+         *  Render a timeval, see the CTimeSpec version.
+         */
+        size_t Format(char *buffer, size_t size, const CTimeVal& value) const
+        {
+            return Format(buffer, size, CTimeSpec(value.c_timeval()));
+        }
+#endif
+
+    private:
+        enum OpCode {
+            OP_LITERAL,
+            OP_YEAR,
+            OP_YEAR_2,
+            OP_MONTH,
+            OP_DAY,
+            OP_DAY_SPACE,
+            OP_DAY_OF_YEAR,
+            OP_HOUR,
+            OP_MINUTE,
+            OP_SECOND,
+            OP_FRACTION,
+            OP_EPOCH,
+            OP_WEEKDAY_ISO,
+            OP_WEEKDAY,
+            OP_WEEKDAY_NAME,
+            OP_MONTH_NAME,
+        };
+
+        /**
+         *  For literals, "offset" and "length" locate the text in 
+         *  the literal pool. For fractions "length" is the digit 
+         *  count, for names 3 or 0 for the full name.
+         */
+        struct Op {
+            uint8_t code;
+            uint8_t length;
+            uint16_t offset;
+        };
+
+        Op ops[MAX_OPS];
+        char literals[MAX_LITERAL];
+        int num_ops;
+        int literal_used;
+        size_t max_length;
+        bool valid;
+
+        void Compile(const char *pattern)
+        {
+            const char *p = pattern;
+
+            while (*p && valid) {
+                if (*p != '%') {
+                    AddLiteral(*p++);
+                    continue;
+                }
+                p++;
+
+                int digits = 9;
+                if (*p >= '1' && *p <= '9' && p[1] == 'N')
+                    digits = *p++ - '0';
+
+                switch (*p) {
+                    case 'Y': AddOp(OP_YEAR, 0, 21); break;
+                    case 'y': AddOp(OP_YEAR_2, 0, 2); break;
+                    case 'm': AddOp(OP_MONTH, 0, 2); break;
+                    case 'd': AddOp(OP_DAY, 0, 2); break;
+                    case 'e': AddOp(OP_DAY_SPACE, 0, 2); break;
+                    case 'j': AddOp(OP_DAY_OF_YEAR, 0, 3); break;
+                    case 'H': AddOp(OP_HOUR, 0, 2); break;
+                    case 'M': AddOp(OP_MINUTE, 0, 2); break;
+                    case 'S': AddOp(OP_SECOND, 0, 2); break;
+                    case 'N': AddOp(OP_FRACTION, (uint8_t)digits, digits); break;
+                    case 's': AddOp(OP_EPOCH, 0, 20); break;
+                    case 'u': AddOp(OP_WEEKDAY_ISO, 0, 1); break;
+                    case 'w': AddOp(OP_WEEKDAY, 0, 1); break;
+                    case 'a': AddOp(OP_WEEKDAY_NAME, 3, 3); break;
+                    case 'A': AddOp(OP_WEEKDAY_NAME, 0, 9); break;
+                    case 'b': AddOp(OP_MONTH_NAME, 3, 3); break;
+                    case 'B': AddOp(OP_MONTH_NAME, 0, 9); break;
+                    case 'F': 
+                        AddOp(OP_YEAR, 0, 21);
+                        AddLiteral('-');
+                        AddOp(OP_MONTH, 0, 2);
+                        AddLiteral('-');
+                        AddOp(OP_DAY, 0, 2);
+                        break;
+                    case 'T': 
+                        AddOp(OP_HOUR, 0, 2);
+                        AddLiteral(':');
+                        AddOp(OP_MINUTE, 0, 2);
+                        AddLiteral(':');
+                        AddOp(OP_SECOND, 0, 2);
+                        break;
+                    case 'z': 
+                        AddLiteral('+');
+                        for (int i = 0; i < 4; i++)
+                            AddLiteral('0');
+                        break;
+                    case 'Z': 
+                        AddLiteral('U');
+                        AddLiteral('T');
+                        AddLiteral('C');
+                        break;
+                    case '%': AddLiteral('%'); break;
+                    default:
+                        valid = false;
+                        return;
+                }
+                p++;
+            }
+        }
+
+        void AddOp(OpCode code, uint8_t length, int width)
+        {
+            if (num_ops == MAX_OPS) {
+                valid = false;
+                return;
+            }
+            ops[num_ops].code = (uint8_t)code;
+            ops[num_ops].length = length;
+            ops[num_ops].offset = 0;
+            num_ops++;
+            max_length += width;
+        }
+
+        /**
+         *  Runs of literal text become one op.
+         */
+        void AddLiteral(char c)
+        {
+            if (literal_used == MAX_LITERAL) {
+                valid = false;
+                return;
+            }
+            Op *last = num_ops ? &ops[num_ops - 1] : NULL;
+            if (!last || last->code != OP_LITERAL || 
+                last->offset + last->length != literal_used || last->length == 255) {
+                AddOp(OP_LITERAL, 0, 0);
+                if (!valid)
+                    return;
+                last = &ops[num_ops - 1];
+                last->offset = (uint16_t)literal_used;
+            }
+            literals[literal_used++] = c;
+            last->length++;
+            max_length++;
+        }
+
+        static char *WriteFixed(char *p, char *end, uint64_t v, int width)
+        {
+            if (end - p < width)
+                return NULL;
+            return CFormatDigits::WriteFixed(p, v, width);
+        }
+
+        static char *WriteSigned(char *p, char *end, int64_t v, int min_width)
+        {
+            bool negative = v < 0;
+            uint64_t magnitude = negative ? 0 - (uint64_t)v : (uint64_t)v;
+            int width = CFormatDigits::CountDigits(magnitude);
+            if (width < min_width)
+                width = min_width;
+
+            if (end - p < width + negative)
+                return NULL;
+            if (negative)
+                *p++ = '-';
+            return CFormatDigits::WriteFixed(p, magnitude, width);
+        }
+
+        static char *WriteName(char *p, char *end, const char *name, int length)
+        {
+            if (!length)
+                length = (int)strlen(name);
+            if (end - p < length)
+                return NULL;
+            memcpy(p, name, length);
+            return p + length;
+        }
+};
+
+
+/**
+ *  Longest output of FormatIso8601(): a 12 digit signed year, 
+ *  "-mm-ddThh:mm:ss", 9 fraction digits and "Z".
+ */
+#define ISO8601_FORMAT_MAX  (40)
+
+
+/**
+ *  Format a time as ISO 8601 UTC, e.g. "2016-12-08T16:04:05.123Z".
+ *  Years outside 0-9999 get a sign or more digits, as CTimeFormat's
+ *  %Y does.
+ *
+ *  @param buffer output, not NUL terminated.
+ *  @param size bytes available in buffer.
+ *  @param value time to format.
+ *  @param digits fraction digits, clamped to [0, 9] and truncated.
+ *  With 0 no decimal point is written.
+ *  @return bytes written, 0 if the result would not fit.
+ */
+inline size_t FormatIso8601(char *buffer, size_t size, const CTimeSpec& value, int digits = 9)
+{
+    char scratch[ISO8601_FORMAT_MAX];
+    char *p = scratch;
+
+    if (digits < 0)
+        digits = 0;
+    if (digits > 9)
+        digits = 9;
+
+    CCivilTime civil = value.Civil();
+
+    uint64_t year = (uint64_t)civil.year;
+    if (civil.year < 0) {
+        *p++ = '-';
+        year = 0 - year;
+    }
+    int width = CFormatDigits::CountDigits(year);
+    p = CFormatDigits::WriteFixed(p, year, width < 4 ? 4 : width);
+
+    *p++ = '-';
+    p = CFormatDigits::WriteFixed(p, civil.month, 2);
+    *p++ = '-';
+    p = CFormatDigits::WriteFixed(p, civil.day, 2);
+    *p++ = 'T';
+    p = CFormatDigits::WriteFixed(p, civil.hour, 2);
+    *p++ = ':';
+    p = CFormatDigits::WriteFixed(p, civil.minute, 2);
+    *p++ = ':';
+    p = CFormatDigits::WriteFixed(p, civil.second, 2);
+    if (digits) {
+        *p++ = '.';
+        p = CFormatDigits::WriteFixed(p, (uint64_t)civil.nsec / CFormatDigits::Pow10(9 - digits), digits);
+    }
+    *p++ = 'Z';
+
+    size_t length = (size_t)(p - scratch);
+    if (length > size)
+        return 0;
+    memcpy(buffer, scratch, length);
+    return length;
+}
+
+
+/**
+ *  Allow the format spec parser to run at compile time where the 
+ *  language lets it, as std::format requires.
+ */
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304L
+#define TIME_FORMAT_CONSTEXPR constexpr
+#else
+#define TIME_FORMAT_CONSTEXPR
+#endif
+
+
+/**
+ *  Longest output of CTimeFormatSpec::Format().
+ */
+#define TIME_FORMAT_SPEC_MAX  (48)
+
+
+/**
+ *  The spec part of "{:spec}" for CTimeSpec and CTimeVal, shared by
+ *  the std::format and fmt formatters below and usable on its own 
+ *  through FormatTo():
+ *
+ *      (empty), r      raw, as operator<< writes it: "(5 sec, 250 nsec)"
+ *      s, .Ns          decimal seconds with N digits, see FormatSeconds()
+ *      i, .Ni          ISO 8601 UTC with N fraction digits, see FormatIso8601()
+ *      d               Go style duration, see FormatDuration()
+ *
+ *  N defaults to 9 for CTimeSpec and 6 for CTimeVal.
+ */
+class CTimeFormatSpec
+{
+    public:
+
+        /**
+         *  ctor, the raw spec.
+         */
+        TIME_FORMAT_CONSTEXPR CTimeFormatSpec()
+        : type('r'), precision(-1)
+        {}
+
+        /**
+         *  Parse a spec.
+         *  @param it start of the spec.
+         *  @param end end of the format string.
+         *  @param ok set false if the spec is malformed.
+         *  @return position of the closing '}', or end.
+         */
+        template <typename It>
+        TIME_FORMAT_CONSTEXPR It Parse(It it, It end, bool *ok)
+        {
+            *ok = true;
+            if (it != end && *it == '.') {
+                ++it;
+                if (it == end || *it < '0' || *it > '9') {
+                    *ok = false;
+                    return it;
+                }
+                precision = *it++ - '0';
+            }
+            if (it != end && (*it == 'r' || *it == 's' || *it == 'i' || *it == 'd'))
+                type = *it++;
+            if (it != end && *it != '}')
+                *ok = false;
+            if (precision >= 0 && type != 's' && type != 'i')
+                *ok = false;
+            return it;
+        }
+
+        /**
+         *  Render a value according to the spec.
+         *  @param buffer at least TIME_FORMAT_SPEC_MAX bytes.
+         *  @return bytes written.
+         */
+        size_t Format(char *buffer, const CTimeSpec& value) const
+        {
+            int digits = precision < 0 ? 9 : precision;
+
+            switch (type) {
+                case 's':
+                    return FormatSeconds(buffer, TIME_FORMAT_SPEC_MAX, value, digits);
+                case 'i':
+                    return FormatIso8601(buffer, TIME_FORMAT_SPEC_MAX, value, digits);
+                case 'd':
+                    return FormatDuration(buffer, TIME_FORMAT_SPEC_MAX, value);
+            }
+            struct timespec ts = value.c_timespec();
+            return FormatRaw(buffer, ts.tv_sec, ts.tv_nsec, " nsec)");
+        }
+
+#ifdef USING_TIMEVAL
+        size_t Format(char *buffer, const CTimeVal& value) const
+        {
+            int digits = precision < 0 ? 6 : precision;
+
+            switch (type) {
+                case 's':
+                    return FormatSeconds(buffer, TIME_FORMAT_SPEC_MAX, value, digits);
+                case 'i':
+                    return FormatIso8601(buffer, TIME_FORMAT_SPEC_MAX, 
+                                         CTimeSpec(value.c_timeval()), digits);
+                case 'd':
+                    return FormatDuration(buffer, TIME_FORMAT_SPEC_MAX, value);
+            }
+            struct timeval tv = value.c_timeval();
+            return FormatRaw(buffer, tv.tv_sec, tv.tv_usec, " usec)");
+        }
+#endif
+
+    private:
+        char type;
+        int precision;
+
+        static size_t FormatRaw(char *buffer, int64_t sec, long sub, const char *unit)
+        {
+            char *p = buffer;
+
+            *p++ = '(';
+            if (sec < 0)
+                *p++ = '-';
+            p = CFormatDigits::WriteUnsigned(p, sec < 0 ? 0 - (uint64_t)sec : (uint64_t)sec);
+            memcpy(p, " sec, ", 6);
+            p += 6;
+            if (sub < 0)
+                *p++ = '-';
+            p = CFormatDigits::WriteUnsigned(p, sub < 0 ? 0 - (uint64_t)sub : (uint64_t)sub);
+            while (*unit)
+                *p++ = *unit++;
+            return (size_t)(p - buffer);
+        }
+};
+
+
+/**
+ *  Write a value through any output iterator, e.g. a char pointer,
+ *  std::back_inserter(string) or a format context's out().
+ *
+ *      std::string line;
+ *      FormatTo(std::back_inserter(line), elapsed, spec);
+ */
+template <typename OutputIt>
+OutputIt FormatTo(OutputIt out, const CTimeSpec& value, 
+                  const CTimeFormatSpec& spec = CTimeFormatSpec())
+{
+    char buffer[TIME_FORMAT_SPEC_MAX];
+    size_t n = spec.Format(buffer, value);
+    for (size_t i = 0; i < n; i++)
+        *out++ = buffer[i];
+    return out;
+}
+
+
+#ifdef USING_TIMEVAL
+template <typename OutputIt>
+OutputIt FormatTo(OutputIt out, const CTimeVal& value, 
+                  const CTimeFormatSpec& spec = CTimeFormatSpec())
+{
+    char buffer[TIME_FORMAT_SPEC_MAX];
+    size_t n = spec.Format(buffer, value);
+    for (size_t i = 0; i < n; i++)
+        *out++ = buffer[i];
+    return out;
+}
+#endif
+
+
+/**
+ *  std::format("{:.3s}", elapsed), where the library has <format>.
+ */
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if defined(__cpp_lib_format)
+#include <format>
+
+template <>
+struct std::formatter<CTimeSpec, char>
+{
+    CTimeFormatSpec spec;
+
+    constexpr std::format_parse_context::iterator parse(std::format_parse_context& ctx)
+    {
+        bool ok = true;
+        auto it = spec.Parse(ctx.begin(), ctx.end(), &ok);
+        if (!ok)
+            throw std::format_error("invalid CTimeSpec format spec");
+        return it;
+    }
+
+    template <typename FormatContext>
+    typename FormatContext::iterator format(const CTimeSpec& value, FormatContext& ctx) const
+    {
+        return FormatTo(ctx.out(), value, spec);
+    }
+};
+
+#ifdef USING_TIMEVAL
+template <>
+struct std::formatter<CTimeVal, char>
+{
+    CTimeFormatSpec spec;
+
+    constexpr std::format_parse_context::iterator parse(std::format_parse_context& ctx)
+    {
+        bool ok = true;
+        auto it = spec.Parse(ctx.begin(), ctx.end(), &ok);
+        if (!ok)
+            throw std::format_error("invalid CTimeVal format spec");
+        return it;
+    }
+
+    template <typename FormatContext>
+    typename FormatContext::iterator format(const CTimeVal& value, FormatContext& ctx) const
+    {
+        return FormatTo(ctx.out(), value, spec);
+    }
+};
+#endif
+#endif
+
+
+/**
+ *  fmt::format("{:i}", now), when <fmt/format.h> is included 
+ *  before this header.
+ */
+#ifdef FMT_VERSION
+namespace fmt {
+
+template <>
+struct formatter<CTimeSpec>
+{
+    CTimeFormatSpec spec;
+
+    TIME_FORMAT_CONSTEXPR format_parse_context::iterator parse(format_parse_context& ctx)
+    {
+        bool ok = true;
+        auto it = spec.Parse(ctx.begin(), ctx.end(), &ok);
+        if (!ok)
+            FMT_THROW(format_error("invalid CTimeSpec format spec"));
+        return it;
+    }
+
+    template <typename FormatContext>
+    auto format(const CTimeSpec& value, FormatContext& ctx) const -> decltype(ctx.out())
+    {
+        return FormatTo(ctx.out(), value, spec);
+    }
+};
+
+#ifdef USING_TIMEVAL
+template <>
+struct formatter<CTimeVal>
+{
+    CTimeFormatSpec spec;
+
+    TIME_FORMAT_CONSTEXPR format_parse_context::iterator parse(format_parse_context& ctx)
+    {
+        bool ok = true;
+        auto it = spec.Parse(ctx.begin(), ctx.end(), &ok);
+        if (!ok)
+            FMT_THROW(format_error("invalid CTimeVal format spec"));
+        return it;
+    }
+
+    template <typename FormatContext>
+    auto format(const CTimeVal& value, FormatContext& ctx) const -> decltype(ctx.out())
+    {
+        return FormatTo(ctx.out(), value, spec);
+    }
+};
+#endif
+
+}
+#endif
+
+
+#endif
@@ -0,0 +1,258 @@
+/**
+ *  @file
+ *
+ *  Hash functions for CTimeSpec and CTimeVal, for keying hash maps
+ *  on timestamps.
+ *
+ *  The hashes fold the seconds and the fraction through two 64x64 
+ *  to 128 bit multiplies, so every output bit depends on every input
+ *  bit and the low bits are as good as the high ones. That matters
+ *  for open addressing tables that take the bucket from the low bits 
+ *  of the hash with a mask; std::hash of an integer is the identity 
+ *  in libstdc++ and clusters timestamps badly there.
+ *
+ *  CTimeSpecBucketHash hashes the time truncated to a unit (a second,
+ *  a minute, 10ms), for maps that collect everything in one unit 
+ *  under one key; CTimeSpecBucketEqual is the matching comparison.
+ *
+ *  Including this header also specializes std::hash, so CTimeSpec 
+ *  and CTimeVal work as std::unordered_map keys without naming a 
+ *  hasher.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef TIME_HASH_HPP__
+#define TIME_HASH_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "time_utilities.hpp"
+
+
+/**
+ *  The mixing shared by all the hashers here.
+ */
+class CTimeHash
+{
+    public:
+
+        /**
+         *  64 bit hash of a time given as seconds and a fraction
+         *  (nanoseconds or microseconds).
+         *  @param seed to vary the hash between tables or processes.
+         */
+        static uint64_t Hash64(int64_t sec, int64_t fraction, uint64_t seed = 0)
+        {
+            uint64_t h = Mum((uint64_t)sec ^ seed ^ 0xa0761d6478bd642fULL, 
+                             (uint64_t)fraction ^ 0xe7037ed1a0b428dbULL);
+            return Mum(h ^ 0x8ebc6af09c88c6e3ULL, (uint64_t)fraction ^ 0x589965cc75374cc3ULL);
+        }
+
+    private:
+        /**
+         *  Full 128 bit product, high half folded into the low.
+         */
+        static uint64_t Mum(uint64_t a, uint64_t b)
+        {
+            unsigned __int128 product = (unsigned __int128)a * b;
+            return (uint64_t)product ^ (uint64_t)(product >> 64);
+        }
+};
+
+
+/**
+ *  Hasher for CTimeSpec keys.
+ */
+class CTimeSpecHash
+{
+    public:
+
+        CTimeSpecHash()
+        : seed(0)
+        {}
+
+        explicit CTimeSpecHash(uint64_t seed)
+        : seed(seed)
+        {}
+
+        size_t operator()(const CTimeSpec& value) const
+        {
+            struct timespec ts = value.c_timespec();
+            return (size_t)CTimeHash::Hash64(ts.tv_sec, ts.tv_nsec, seed);
+        }
+
+    private:
+        uint64_t seed;
+};
+
+
+/**
+ *  Hasher of the unit a CTimeSpec falls in, so every time in the 
+ *  same second (or minute, or 10ms) hashes alike. Units are counted
+ *  from the epoch, and times before it go to the unit below, as 
+ *  FloorToDay does.
+ */
+class CTimeSpecBucketHash
+{
+    public:
+
+        /**
+         *  @param unit_ns width of a bucket, in nanoseconds, > 0.
+         */
+        explicit CTimeSpecBucketHash(int64_t unit_ns = NS_IN_SECOND, uint64_t seed = 0)
+        : unit(unit_ns > 0 ? unit_ns : 1), seed(seed)
+        {}
+
+        size_t operator()(const CTimeSpec& value) const
+        {
+            int64_t hi, lo;
+            Bucket(value, &hi, &lo);
+            return (size_t)CTimeHash::Hash64(hi, lo, seed);
+        }
+
+        /**
+         *  Whether two times fall in the same bucket.
+         */
+        bool Same(const CTimeSpec& lhs, const CTimeSpec& rhs) const
+        {
+            int64_t lhs_hi, lhs_lo, rhs_hi, rhs_lo;
+            Bucket(lhs, &lhs_hi, &lhs_lo);
+            Bucket(rhs, &rhs_hi, &rhs_lo);
+            return lhs_hi == rhs_hi && lhs_lo == rhs_lo;
+        }
+
+        int64_t Unit() const
+        {
+            return unit;
+        }
+
+    private:
+        /**
+         *  Exact bucket number as a pair, without the 128 bit divide
+         *  when the unit divides a second or is whole seconds.
+         */
+        void Bucket(const CTimeSpec& value, int64_t *hi, int64_t *lo) const
+        {
+            struct timespec ts = value.c_timespec();
+
+            if (NS_IN_SECOND % unit == 0) {
+                *hi = ts.tv_sec;
+                *lo = ts.tv_nsec / unit;
+            }
+            else if (unit % NS_IN_SECOND == 0) {
+                int64_t seconds = unit / NS_IN_SECOND;
+                int64_t q = ts.tv_sec / seconds;
+                *hi = (ts.tv_sec % seconds < 0) ? q - 1 : q;
+                *lo = 0;
+            }
+            else {
+                __int128 ns = (__int128)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+                __int128 q = ns / unit;
+                if (ns % unit < 0)
+                    q--;
+                *hi = (int64_t)(q >> 64);
+                *lo = (int64_t)q;
+            }
+        }
+
+        int64_t unit;
+        uint64_t seed;
+};
+
+
+/**
+ *  Key equality matching a CTimeSpecBucketHash of the same unit.
+ */
+class CTimeSpecBucketEqual
+{
+    public:
+
+        explicit CTimeSpecBucketEqual(int64_t unit_ns = NS_IN_SECOND)
+        : bucket(unit_ns)
+        {}
+
+        bool operator()(const CTimeSpec& lhs, const CTimeSpec& rhs) const
+        {
+            return bucket.Same(lhs, rhs);
+        }
+
+    private:
+        CTimeSpecBucketHash bucket;
+};
+
+
+#ifdef USING_TIMEVAL
+/**
+ *  Hasher for CTimeVal keys.
+ */
+class CTimeValHash
+{
+    public:
+
+        CTimeValHash()
+        : seed(0)
+        {}
+
+        explicit CTimeValHash(uint64_t seed)
+        : seed(seed)
+        {}
+
+        size_t operator()(const CTimeVal& value) const
+        {
+            struct timeval tv = value.c_timeval();
+            return (size_t)CTimeHash::Hash64(tv.tv_sec, tv.tv_usec, seed);
+        }
+
+    private:
+        uint64_t seed;
+};
+#endif
+
+
+namespace std {
+
+template <>
+struct hash<CTimeSpec>
+{
+    size_t operator()(const CTimeSpec& value) const noexcept
+    {
+        return CTimeSpecHash()(value);
+    }
+};
+
+#ifdef USING_TIMEVAL
+template <>
+struct hash<CTimeVal>
+{
+    size_t operator()(const CTimeVal& value) const noexcept
+    {
+        return CTimeValHash()(value);
+    }
+};
+#endif
+
+}
+
+#endif
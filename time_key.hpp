@@ -0,0 +1,201 @@
+/**
+ *  @file
+ *
+ *  Fixed size binary keys of CTimeSpec whose memcmp() order is time
+ *  order, for use as (a prefix of) keys in sorted byte stores such 
+ *  as RocksDB or LMDB, which compare keys with memcmp().
+ *
+ *  Seconds are stored big endian with the sign bit flipped, so 
+ *  negative times sort before positive ones, followed by the 
+ *  nanoseconds big endian:
+ *
+ *      12 byte key     sec (8) | nsec (4)
+ *      16 byte key     sec (8) | nsec (8), keeps what follows 8 byte aligned
+ *
+ *  This header requires C++11 support.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef TIME_KEY_HPP__
+#define TIME_KEY_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "time_utilities.hpp"
+
+
+#define TIME_KEY_SIZE           (12)
+#define TIME_KEY_ALIGNED_SIZE   (16)
+
+
+class CTimeKey
+{
+    public:
+
+        /**
+         *  Write the 12 byte key of a time.
+         */
+        static void Encode(uint8_t *out, const CTimeSpec& value)
+        {
+            struct timespec ts = value.c_timespec();
+            Store64(out, Bias(ts.tv_sec));
+            Store32(out + 8, (uint32_t)ts.tv_nsec);
+        }
+
+        /**
+         *  Read a 12 byte key.
+         *  @return false, leaving value alone, if nsec is out of range.
+         */
+        static bool Decode(const uint8_t *in, CTimeSpec *value)
+        {
+            uint32_t nsec = Load32(in + 8);
+            if (nsec >= NS_IN_SECOND)
+                return false;
+            *value = CTimeSpec((time_t)Unbias(Load64(in)), (long)nsec);
+            return true;
+        }
+
+        /**
+         *  Write the 16 byte key of a time.
+         */
+        static void EncodeAligned(uint8_t *out, const CTimeSpec& value)
+        {
+            struct timespec ts = value.c_timespec();
+            Store64(out, Bias(ts.tv_sec));
+            Store64(out + 8, (uint64_t)ts.tv_nsec);
+        }
+
+        /**
+         *  Read a 16 byte key.
+         *  @return false, leaving value alone, if nsec is out of range.
+         */
+        static bool DecodeAligned(const uint8_t *in, CTimeSpec *value)
+        {
+            uint64_t nsec = Load64(in + 8);
+            if (nsec >= NS_IN_SECOND)
+                return false;
+            *value = CTimeSpec((time_t)Unbias(Load64(in)), (long)nsec);
+            return true;
+        }
+
+        /**
+         *  Write the 12 byte keys of many times, for bulk loads.
+         *  @param out first key.
+         *  @param stride bytes from one key to the next, at least 
+         *  TIME_KEY_SIZE; larger to write the time prefix of wider 
+         *  records in place.
+         */
+        static void Encode(uint8_t *out, const CTimeSpec *values, size_t count, 
+                           size_t stride = TIME_KEY_SIZE)
+        {
+            for (size_t i = 0; i < count; i++)
+                Encode(out + i * stride, values[i]);
+        }
+
+        /**
+         *  Write the 16 byte keys of many times.
+         */
+        static void EncodeAligned(uint8_t *out, const CTimeSpec *values, size_t count, 
+                                  size_t stride = TIME_KEY_ALIGNED_SIZE)
+        {
+            for (size_t i = 0; i < count; i++)
+                EncodeAligned(out + i * stride, values[i]);
+        }
+
+#ifdef USING_TIMEVAL
+        /**
+         *  12 byte key of a timeval: sec (8) | usec (4). Same order
+         *  property, but not comparable with CTimeSpec keys.
+         */
+        static void Encode(uint8_t *out, const CTimeVal& value)
+        {
+            struct timeval tv = value.c_timeval();
+            Store64(out, Bias(tv.tv_sec));
+            Store32(out + 8, (uint32_t)tv.tv_usec);
+        }
+
+        static bool Decode(const uint8_t *in, CTimeVal *value)
+        {
+            uint32_t usec = Load32(in + 8);
+            if (usec >= US_IN_SECOND)
+                return false;
+            *value = CTimeVal((time_t)Unbias(Load64(in)), (long)usec);
+            return true;
+        }
+#endif
+
+    private:
+        /**
+         *  Flip the sign bit so signed order becomes unsigned order.
+         */
+        static uint64_t Bias(int64_t v)
+        {
+            return (uint64_t)v ^ 0x8000000000000000ULL;
+        }
+
+        static int64_t Unbias(uint64_t v)
+        {
+            return (int64_t)(v ^ 0x8000000000000000ULL);
+        }
+
+        static void Store64(uint8_t *out, uint64_t v)
+        {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            v = __builtin_bswap64(v);
+#endif
+            memcpy(out, &v, sizeof(v));
+        }
+
+        static void Store32(uint8_t *out, uint32_t v)
+        {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            v = __builtin_bswap32(v);
+#endif
+            memcpy(out, &v, sizeof(v));
+        }
+
+        static uint64_t Load64(const uint8_t *in)
+        {
+            uint64_t v;
+            memcpy(&v, in, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            v = __builtin_bswap64(v);
+#endif
+            return v;
+        }
+
+        static uint32_t Load32(const uint8_t *in)
+        {
+            uint32_t v;
+            memcpy(&v, in, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            v = __builtin_bswap32(v);
+#endif
+            return v;
+        }
+};
+
+
+#endif
@@ -0,0 +1,757 @@
+/**
+ *  @file
+ *
+ *  Parsing of timestamps in custom layouts into CTimeSpec, the 
+ *  counterpart of CTimeFormat in time_format.hpp.
+ *
+ *  Parsers report failures with a result code, never exceptions, 
+ *  and do no allocation. ParseDuration() reads human durations 
+ *  like "1h30m" back into a CTimeSpec.
+ *
+ *  This header requires C++11 support.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef TIME_PARSE_HPP__
+#define TIME_PARSE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "time_utilities.hpp"
+#include "time_format.hpp"
+
+
+/**
+ *  A strptime style pattern compiled once, then used to parse many
+ *  timestamps straight to a CTimeSpec, with no struct tm, timegm, 
+ *  locale or allocation in between.
+ *
+ *      static const CTimeParser parser {"%d/%b/%Y:%H:%M:%S %z"};
+ *      CTimeSpec when;
+ *      if (parser.Parse(text, length, &when) != CTimeParser::PARSE_OK)
+ *          ...
+ *
+ *  Supported, all case insensitive for names:
+ *
+ *      %Y  year, exactly 4 digits         %y  2 digits, 69-99 are 19xx
+ *      %m  month 1-12                     %d  day 1-31 (%e: may lead with a space)
+ *      %j  day of year 1-366              %H  hour 0-23
+ *      %I  hour 1-12, with %p             %p  AM or PM
+ *      %M  minute 0-59                    %S  second 0-60
+ *      %N  fraction, 1 to 9 digits        %1N - %9N  exactly that many digits
+ *      %s  seconds since the epoch        %u %w  weekday number, ignored
+ *      %a %A  weekday name, ignored       %b %B %h  month name
+ *      %z  "Z", "+hh", "+hhmm" or "+hh:mm", subtracted to give UTC
+ *      %Z  "UTC" or "GMT"                 %F  "%Y-%m-%d"
+ *      %T  "%H:%M:%S"                     %D  "%m/%d/%y"
+ *      %n %t  and white space, any amount of white space
+ *      %%  "%"
+ *
+ *  Numbers other than %Y, %s and fixed width fractions take 1 or 2 
+ *  digits (3 for %j), like strptime. Dates and times are checked, 
+ *  so Feb 30 is PARSE_RANGE. A second of 60 rolls into the next 
+ *  minute, as timegm does.
+ */
+class CTimeParser
+{
+    public:
+
+        /**
+         *  Outcome of a parse, per row for the bulk API.
+         */
+        enum ParseResult {
+            PARSE_OK = 0,
+            PARSE_MISMATCH,         /**< text does not follow the pattern */
+            PARSE_RANGE,            /**< a field is out of range */
+            PARSE_TRAILING,         /**< text left over after the pattern */
+            PARSE_BAD_PATTERN,      /**< the pattern did not compile */
+        };
+
+        /**
+         *  Limits of a compiled pattern.
+         */
+        static const int MAX_OPS = 48;
+        static const int MAX_LITERAL = 128;
+
+        /**
+         *  ctor, compiles the pattern.
+         *  @param pattern NUL terminated strptime style pattern.
+         */
+        explicit CTimeParser(const char *pattern)
+        : num_ops(0), literal_used(0), valid(true)
+        {
+            Compile(pattern);
+        }
+
+        /**
+         *  True if the pattern compiled.
+         */
+        bool Valid() const
+        {
+            return valid;
+        }
+
+        /**
+         *  Parse one timestamp.
+         *  @param text input, need not be NUL terminated.
+         *  @param length bytes of input.
+         *  @param result set only on PARSE_OK.
+         *  @param consumed if given, text may continue after the 
+         *  pattern and this is set to the bytes used; if NULL 
+         *  leftover text is PARSE_TRAILING.
+         */
+        ParseResult Parse(const char *text, size_t length, CTimeSpec *result, 
+                          size_t *consumed = NULL) const
+        {
+            if (!valid)
+                return PARSE_BAD_PATTERN;
+
+            Fields f;
+            const char *p = text;
+            const char *end = text + length;
+
+            for (int i = 0; i < num_ops; i++) {
+                p = Apply(ops[i], p, end, &f);
+                if (!p)
+                    return PARSE_MISMATCH;
+            }
+
+            if (consumed)
+                *consumed = (size_t)(p - text);
+            else if (p != end)
+                return PARSE_TRAILING;
+
+            return Combine(f, result);
+        }
+
+        /**
+         *  Parse one NUL terminated timestamp.
+         */
+        ParseResult Parse(const char *text, CTimeSpec *result) const
+        {
+            return Parse(text, strlen(text), result);
+        }
+
+        /**
+         *  Parse a column of timestamps.
+         *  @param texts the strings.
+         *  @param lengths their lengths, or NULL if NUL terminated.
+         *  @param count number of rows.
+         *  @param results parsed times, rows that fail are left as is.
+         *  @param errors if not NULL, a ParseResult per row.
+         *  @return number of rows parsed successfully.
+         */
+        size_t Parse(const char *const *texts, const size_t *lengths, size_t count,
+                     CTimeSpec *results, uint8_t *errors) const
+        {
+            size_t parsed = 0;
+
+            for (size_t i = 0; i < count; i++) {
+                size_t length = lengths ? lengths[i] : strlen(texts[i]);
+                ParseResult r = Parse(texts[i], length, &results[i]);
+                if (errors)
+                    errors[i] = (uint8_t)r;
+                parsed += r == PARSE_OK;
+            }
+            return parsed;
+        }
+
+    private:
+        enum OpCode {
+            OP_LITERAL,
+            OP_SPACE,
+            OP_YEAR,
+            OP_YEAR_2,
+            OP_MONTH,
+            OP_DAY,
+            OP_DAY_SPACE,
+            OP_DAY_OF_YEAR,
+            OP_HOUR,
+            OP_HOUR_12,
+            OP_AM_PM,
+            OP_MINUTE,
+            OP_SECOND,
+            OP_FRACTION,
+            OP_EPOCH,
+            OP_WEEKDAY,
+            OP_WEEKDAY_NAME,
+            OP_MONTH_NAME,
+            OP_ZONE_OFFSET,
+            OP_ZONE_NAME,
+        };
+
+        /**
+         *  For literals, "offset" and "length" locate the text in the
+         *  literal pool. For numbers "min" and "max" bound the digits.
+         */
+        struct Op {
+            uint8_t code;
+            uint8_t min;
+            uint8_t max;
+            uint8_t length;
+            uint16_t offset;
+        };
+
+        /**
+         *  Everything a pattern can set, defaulting to the epoch.
+         */
+        struct Fields {
+            int64_t year = 1970;
+            int64_t epoch = 0;
+            long nsec = 0;
+            long offset = 0;
+            int month = 1;
+            int day = 1;
+            int day_of_year = -1;
+            int hour = 0;
+            int minute = 0;
+            int second = 0;
+            int pm = -1;
+            bool has_month_day = false;
+            bool has_epoch = false;
+        };
+
+        Op ops[MAX_OPS];
+        char literals[MAX_LITERAL];
+        int num_ops;
+        int literal_used;
+        bool valid;
+
+        void Compile(const char *pattern)
+        {
+            const char *p = pattern;
+
+            while (*p && valid) {
+                if (IsSpace(*p)) {
+                    while (IsSpace(*p))
+                        p++;
+                    AddOp(OP_SPACE, 0, 0);
+                    continue;
+                }
+                if (*p != '%') {
+                    AddLiteral(*p++);
+                    continue;
+                }
+                p++;
+
+                int digits = 0;
+                if (*p >= '1' && *p <= '9' && p[1] == 'N')
+                    digits = *p++ - '0';
+
+                switch (*p) {
+                    case 'Y': AddOp(OP_YEAR, 4, 4); break;
+                    case 'y': AddOp(OP_YEAR_2, 2, 2); break;
+                    case 'm': AddOp(OP_MONTH, 1, 2); break;
+                    case 'd': AddOp(OP_DAY, 1, 2); break;
+                    case 'e': AddOp(OP_DAY_SPACE, 1, 2); break;
+                    case 'j': AddOp(OP_DAY_OF_YEAR, 1, 3); break;
+                    case 'H': AddOp(OP_HOUR, 1, 2); break;
+                    case 'I': AddOp(OP_HOUR_12, 1, 2); break;
+                    case 'p': AddOp(OP_AM_PM, 0, 0); break;
+                    case 'M': AddOp(OP_MINUTE, 1, 2); break;
+                    case 'S': AddOp(OP_SECOND, 1, 2); break;
+                    case 'N': 
+                        if (digits)
+                            AddOp(OP_FRACTION, (uint8_t)digits, (uint8_t)digits);
+                        else
+                            AddOp(OP_FRACTION, 1, 9);
+                        break;
+                    case 's': AddOp(OP_EPOCH, 1, 18); break;
+                    case 'u': AddOp(OP_WEEKDAY, 1, 1); break;
+                    case 'w': AddOp(OP_WEEKDAY, 1, 1); break;
+                    case 'a': AddOp(OP_WEEKDAY_NAME, 0, 0); break;
+                    case 'A': AddOp(OP_WEEKDAY_NAME, 0, 0); break;
+                    case 'b': AddOp(OP_MONTH_NAME, 0, 0); break;
+                    case 'B': AddOp(OP_MONTH_NAME, 0, 0); break;
+                    case 'h': AddOp(OP_MONTH_NAME, 0, 0); break;
+                    case 'z': AddOp(OP_ZONE_OFFSET, 0, 0); break;
+                    case 'Z': AddOp(OP_ZONE_NAME, 0, 0); break;
+                    case 'n': AddOp(OP_SPACE, 0, 0); break;
+                    case 't': AddOp(OP_SPACE, 0, 0); break;
+                    case 'F':
+                        AddOp(OP_YEAR, 4, 4);
+                        AddLiteral('-');
+                        AddOp(OP_MONTH, 1, 2);
+                        AddLiteral('-');
+                        AddOp(OP_DAY, 1, 2);
+                        break;
+                    case 'T':
+                        AddOp(OP_HOUR, 1, 2);
+                        AddLiteral(':');
+                        AddOp(OP_MINUTE, 1, 2);
+                        AddLiteral(':');
+                        AddOp(OP_SECOND, 1, 2);
+                        break;
+                    case 'D':
+                        AddOp(OP_MONTH, 1, 2);
+                        AddLiteral('/');
+                        AddOp(OP_DAY, 1, 2);
+                        AddLiteral('/');
+                        AddOp(OP_YEAR_2, 2, 2);
+                        break;
+                    case '%': AddLiteral('%'); break;
+                    default:
+                        valid = false;
+                        return;
+                }
+                p++;
+            }
+        }
+
+        void AddOp(OpCode code, uint8_t min, uint8_t max)
+        {
+            if (num_ops == MAX_OPS) {
+                valid = false;
+                return;
+            }
+            ops[num_ops].code = (uint8_t)code;
+            ops[num_ops].min = min;
+            ops[num_ops].max = max;
+            ops[num_ops].length = 0;
+            ops[num_ops].offset = 0;
+            num_ops++;
+        }
+
+        /**
+         *  Runs of literal text become one op.
+         */
+        void AddLiteral(char c)
+        {
+            if (literal_used == MAX_LITERAL) {
+                valid = false;
+                return;
+            }
+            Op *last = num_ops ? &ops[num_ops - 1] : NULL;
+            if (!last || last->code != OP_LITERAL || 
+                last->offset + last->length != literal_used || last->length == 255) {
+                AddOp(OP_LITERAL, 0, 0);
+                if (!valid)
+                    return;
+                last = &ops[num_ops - 1];
+                last->offset = (uint16_t)literal_used;
+            }
+            literals[literal_used++] = c;
+            last->length++;
+        }
+
+        /**
+         *  Match one op, returning the rest of the text or NULL.
+         */
+        const char *Apply(const Op& op, const char *p, const char *end, Fields *f) const
+        {
+            int64_t v = 0;
+
+            switch (op.code) {
+                case OP_LITERAL:
+                    if (end - p < op.length || memcmp(p, literals + op.offset, op.length))
+                        return NULL;
+                    return p + op.length;
+
+                case OP_SPACE:
+                    while (p != end && IsSpace(*p))
+                        p++;
+                    return p;
+
+                case OP_YEAR:
+                    p = ReadNumber(p, end, op, &v);
+                    f->year = v;
+                    return p;
+
+                case OP_YEAR_2:
+                    p = ReadNumber(p, end, op, &v);
+                    f->year = v < 69 ? 2000 + v : 1900 + v;
+                    return p;
+
+                case OP_MONTH:
+                    p = ReadNumber(p, end, op, &v);
+                    f->month = (int)v;
+                    f->has_month_day = true;
+                    return p;
+
+                case OP_DAY_SPACE:
+                    if (p != end && *p == ' ')
+                        p++;
+                    //  fall through
+                case OP_DAY:
+                    p = ReadNumber(p, end, op, &v);
+                    f->day = (int)v;
+                    f->has_month_day = true;
+                    return p;
+
+                case OP_DAY_OF_YEAR:
+                    p = ReadNumber(p, end, op, &v);
+                    f->day_of_year = (int)v;
+                    return p;
+
+                case OP_HOUR:
+                case OP_HOUR_12:
+                    p = ReadNumber(p, end, op, &v);
+                    f->hour = (int)v;
+                    if (op.code == OP_HOUR_12 && f->pm < 0)
+                        f->pm = 0;
+                    return p;
+
+                case OP_AM_PM:
+                    if (end - p < 2 || (Lower(p[1]) != 'm'))
+                        return NULL;
+                    if (Lower(p[0]) == 'a')
+                        f->pm = 0;
+                    else if (Lower(p[0]) == 'p')
+                        f->pm = 1;
+                    else
+                        return NULL;
+                    return p + 2;
+
+                case OP_MINUTE:
+                    p = ReadNumber(p, end, op, &v);
+                    f->minute = (int)v;
+                    return p;
+
+                case OP_SECOND:
+                    p = ReadNumber(p, end, op, &v);
+                    f->second = (int)v;
+                    return p;
+
+                case OP_FRACTION: {
+                    const char *start = p;
+                    p = ReadNumber(p, end, op, &v);
+                    if (p)
+                        f->nsec = (long)(v * (int64_t)CFormatDigits::Pow10(9 - (int)(p - start)));
+                    return p;
+                }
+
+                case OP_EPOCH: {
+                    bool negative = p != end && *p == '-';
+                    p = ReadNumber(p + negative, end, op, &v);
+                    f->epoch = negative ? -v : v;
+                    f->has_epoch = true;
+                    return p;
+                }
+
+                case OP_WEEKDAY:
+                    return ReadNumber(p, end, op, &v);
+
+                case OP_WEEKDAY_NAME:
+                    return MatchName(p, end, CTimeFormat::WeekdayNames(), 7, &v);
+
+                case OP_MONTH_NAME:
+                    p = MatchName(p, end, CTimeFormat::MonthNames(), 12, &v);
+                    f->month = (int)v + 1;
+                    f->has_month_day = true;
+                    return p;
+
+                case OP_ZONE_OFFSET:
+                    return ReadOffset(p, end, &f->offset);
+
+                case OP_ZONE_NAME:
+                    if (end - p < 3)
+                        return NULL;
+                    if ((Lower(p[0]) == 'u' && Lower(p[1]) == 't' && Lower(p[2]) == 'c') ||
+                        (Lower(p[0]) == 'g' && Lower(p[1]) == 'm' && Lower(p[2]) == 't'))
+                        return p + 3;
+                    return NULL;
+            }
+            return NULL;
+        }
+
+        /**
+         *  Check the fields and turn them into a time.
+         */
+        static ParseResult Combine(const Fields& f, CTimeSpec *result)
+        {
+            if (f.has_epoch) {
+                *result = CTimeSpec(f.epoch, f.nsec);
+                return PARSE_OK;
+            }
+
+            int hour = f.hour;
+            if (f.pm >= 0) {
+                if (hour < 1 || hour > 12)
+                    return PARSE_RANGE;
+                hour = hour % 12 + 12 * f.pm;
+            }
+            if (hour > 23 || f.minute > 59 || f.second > 60)
+                return PARSE_RANGE;
+
+            int64_t days;
+            if (f.day_of_year >= 0 && !f.has_month_day) {
+                if (f.day_of_year < 1 || f.day_of_year > 365 + CTimeSpec::IsLeapYear(f.year))
+                    return PARSE_RANGE;
+                days = CTimeSpec::DaysFromCivil(f.year, 1, 1) + f.day_of_year - 1;
+            }
+            else {
+                if (f.month < 1 || f.month > 12 || f.day < 1 || 
+                    f.day > (int)CTimeSpec::DaysInMonth(f.year, f.month))
+                    return PARSE_RANGE;
+                days = CTimeSpec::DaysFromCivil(f.year, f.month, f.day);
+            }
+
+            int64_t sec = days * SEC_IN_DAY + hour * 3600 + f.minute * 60 + f.second - f.offset;
+            *result = CTimeSpec(sec, f.nsec);
+            return PARSE_OK;
+        }
+
+        static bool IsSpace(char c)
+        {
+            return c == ' ' || (c >= '\t' && c <= '\r');
+        }
+
+        static char Lower(char c)
+        {
+            return (char)(c | 0x20);
+        }
+
+        /**
+         *  Between op.min and op.max digits, as many as there are.
+         */
+        static const char *ReadNumber(const char *p, const char *end, const Op& op, int64_t *value)
+        {
+            if (!p)
+                return NULL;
+
+            const char *limit = end - p > op.max ? p + op.max : end;
+            const char *start = p;
+            int64_t v = 0;
+
+            while (p != limit && (unsigned)(*p - '0') < 10)
+                v = v * 10 + (*p++ - '0');
+
+            if (p - start < op.min)
+                return NULL;
+            *value = v;
+            return p;
+        }
+
+        /**
+         *  A name, abbreviated to 3 letters or in full.
+         */
+        static const char *MatchName(const char *p, const char *end, 
+                                     const char *const *names, int count, int64_t *index)
+        {
+            if (end - p < 3)
+                return NULL;
+
+            for (int i = 0; i < count; i++) {
+                const char *name = names[i];
+                if (Lower(p[0]) != Lower(name[0]) || Lower(p[1]) != name[1] || 
+                    Lower(p[2]) != name[2])
+                    continue;
+
+                *index = i;
+                size_t full = strlen(name);
+                if ((size_t)(end - p) >= full) {
+                    size_t j = 3;
+                    while (j < full && Lower(p[j]) == name[j])
+                        j++;
+                    if (j == full)
+                        return p + full;
+                }
+                return p + 3;
+            }
+            return NULL;
+        }
+
+        /**
+         *  "Z", "+hh", "+hhmm" or "+hh:mm", in seconds east of UTC.
+         */
+        static const char *ReadOffset(const char *p, const char *end, long *offset)
+        {
+            if (p == end)
+                return NULL;
+            if (*p == 'Z' || *p == 'z') {
+                *offset = 0;
+                return p + 1;
+            }
+            if (*p != '+' && *p != '-')
+                return NULL;
+
+            bool negative = *p++ == '-';
+            Op two = {0, 2, 2, 0, 0};
+            int64_t hours, minutes = 0;
+
+            p = ReadNumber(p, end, two, &hours);
+            if (!p)
+                return NULL;
+            if (p != end && *p == ':')
+                p = ReadNumber(p + 1, end, two, &minutes);
+            else if (end - p >= 2 && (unsigned)(*p - '0') < 10)
+                p = ReadNumber(p, end, two, &minutes);
+            if (!p || hours > 23 || minutes > 59)
+                return NULL;
+
+            *offset = (long)(hours * 3600 + minutes * 60) * (negative ? -1 : 1);
+            return p;
+        }
+};
+
+
+/**
+ *  Sign and magnitude of a Go style duration, see ParseDuration().
+ */
+inline CTimeParser::ParseResult ParseDurationMagnitude(const char *text, size_t length, 
+                                                       bool *negative, uint64_t *sec, 
+                                                       uint64_t *nsec)
+{
+    const char *p = text;
+    const char *end = text + length;
+
+    *negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+        *negative = *p++ == '-';
+    if (p == end)
+        return CTimeParser::PARSE_MISMATCH;
+
+    if (end - p == 1 && *p == '0') {
+        *sec = *nsec = 0;
+        return CTimeParser::PARSE_OK;
+    }
+
+    //
+    //  Exact, in 128 bit nanoseconds, up to the largest time_t.
+    //
+    const unsigned __int128 limit = (unsigned __int128)INT64_MAX * NS_IN_SECOND + NS_IN_SECOND - 1;
+    unsigned __int128 total = 0;
+
+    while (p != end) {
+        uint64_t whole = 0, fraction = 0, scale = 1;
+        bool digits = false;
+
+        while (p != end && (unsigned)(*p - '0') < 10) {
+            if (whole > (UINT64_MAX - 9) / 10)
+                return CTimeParser::PARSE_RANGE;
+            whole = whole * 10 + (uint64_t)(*p++ - '0');
+            digits = true;
+        }
+        if (p != end && *p == '.') {
+            p++;
+            while (p != end && (unsigned)(*p - '0') < 10) {
+                //  Digits past 10^-18 of a unit cannot change the result.
+                if (scale < 1000000000000000000ULL) {
+                    fraction = fraction * 10 + (uint64_t)(*p - '0');
+                    scale *= 10;
+                }
+                p++;
+                digits = true;
+            }
+        }
+        if (!digits)
+            return CTimeParser::PARSE_MISMATCH;
+
+        uint64_t unit;
+        size_t left = (size_t)(end - p);
+        if (left >= 2 && p[0] == 'n' && p[1] == 's')
+            unit = 1, p += 2;
+        else if (left >= 2 && p[0] == 'u' && p[1] == 's')
+            unit = 1000, p += 2;
+        else if (left >= 3 && (unsigned char)p[0] == 0xc2 && (unsigned char)p[1] == 0xb5 && p[2] == 's')
+            unit = 1000, p += 3;    //  U+00B5 micro sign
+        else if (left >= 3 && (unsigned char)p[0] == 0xce && (unsigned char)p[1] == 0xbc && p[2] == 's')
+            unit = 1000, p += 3;    //  U+03BC greek small letter mu
+        else if (left >= 2 && p[0] == 'm' && p[1] == 's')
+            unit = 1000000, p += 2;
+        else if (left >= 1 && p[0] == 's')
+            unit = NS_IN_SECOND, p += 1;
+        else if (left >= 1 && p[0] == 'm')
+            unit = 60ULL * NS_IN_SECOND, p += 1;
+        else if (left >= 1 && p[0] == 'h')
+            unit = 3600ULL * NS_IN_SECOND, p += 1;
+        else
+            return CTimeParser::PARSE_MISMATCH;
+
+        total += (unsigned __int128)whole * unit + (unsigned __int128)fraction * unit / scale;
+        if (total > limit)
+            return CTimeParser::PARSE_RANGE;
+    }
+
+    *sec = (uint64_t)(total / NS_IN_SECOND);
+    *nsec = (uint64_t)(total % NS_IN_SECOND);
+    return CTimeParser::PARSE_OK;
+}
+
+
+/**
+ *  Parse a Go style duration such as "1h30m", "250ms", "-1.5s", 
+ *  "3.5us" or "0": an optional sign, then one or more decimal 
+ *  numbers, each with an optional fraction and a unit of ns, us 
+ *  (or "µs"), ms, s, m or h. The math is exact integer math; 
+ *  digits finer than a nanosecond are truncated.
+ *
+ *  @param text input, need not be NUL terminated.
+ *  @param length bytes of input.
+ *  @param result set only on PARSE_OK.
+ *  @return PARSE_OK, PARSE_MISMATCH for bad syntax, or PARSE_RANGE
+ *  if the value does not fit a time_t of seconds.
+ */
+inline CTimeParser::ParseResult ParseDuration(const char *text, size_t length, CTimeSpec *result)
+{
+    bool negative;
+    uint64_t sec, nsec;
+
+    CTimeParser::ParseResult r = ParseDurationMagnitude(text, length, &negative, &sec, &nsec);
+    if (r == CTimeParser::PARSE_OK) {
+        if (negative)
+            *result = CTimeSpec(-(time_t)sec, -(long)nsec);
+        else
+            *result = CTimeSpec((time_t)sec, (long)nsec);
+    }
+    return r;
+}
+
+
+inline CTimeParser::ParseResult ParseDuration(const char *text, CTimeSpec *result)
+{
+    return ParseDuration(text, strlen(text), result);
+}
+
+
+#ifdef USING_TIMEVAL
+/**
+ *  Parse a duration into a timeval, truncating toward zero to 
+ *  microseconds. See the CTimeSpec version.
+ */
+inline CTimeParser::ParseResult ParseDuration(const char *text, size_t length, CTimeVal *result)
+{
+    bool negative;
+    uint64_t sec, nsec;
+
+    CTimeParser::ParseResult r = ParseDurationMagnitude(text, length, &negative, &sec, &nsec);
+    if (r == CTimeParser::PARSE_OK) {
+        if (negative)
+            *result = CTimeVal(-(time_t)sec, -(long)(nsec / 1000));
+        else
+            *result = CTimeVal((time_t)sec, (long)(nsec / 1000));
+    }
+    return r;
+}
+
+
+inline CTimeParser::ParseResult ParseDuration(const char *text, CTimeVal *result)
+{
+    return ParseDuration(text, strlen(text), result);
+}
+#endif
+
+
+#endif
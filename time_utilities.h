@@ -49,12 +49,27 @@
 #define US_IN_MS        (1000L)
 
 
+/**
+ *  Function attributes for the compiler. A TIME_UTILITIES_CONST
+ *  function depends only on its arguments' values, so repeated calls
+ *  can be merged and hoisted; a TIME_UTILITIES_PURE one may also 
+ *  read through its pointer arguments, but writes nothing.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define TIME_UTILITIES_CONST    __attribute__((const))
+#define TIME_UTILITIES_PURE     __attribute__((pure))
+#else
+#define TIME_UTILITIES_CONST
+#define TIME_UTILITIES_PURE
+#endif
+
+
 /**
  *  Get the realtime clock time.
  *  @param[out] ts time returned in this variable.
  *  @return 0 on success, -1 in failure.
  */
-inline int timespec_now(struct timespec *ts)
+static inline int timespec_now(struct timespec *ts)
 {
     return clock_gettime(CLOCK_REALTIME, ts);
 }
@@ -65,7 +80,7 @@ inline int timespec_now(struct timespec *ts)
  *  @param[out] ts time returned in this variable.
  *  @return 0 on success, -1 in failure.
  */
-inline int timespec_now_monotonic(struct timespec *ts)
+static inline int timespec_now_monotonic(struct timespec *ts)
 {
     return clock_gettime(CLOCK_MONOTONIC, ts);
 }
@@ -76,21 +91,43 @@ inline int timespec_now_monotonic(struct timespec *ts)
  *  @param[out] ts time returned in this variable.
  *  @return 0 on success, -1 in failure.
  */
-inline int timespec_now_monotonic_raw(struct timespec *ts)
+static inline int timespec_now_monotonic_raw(struct timespec *ts)
 {
     return clock_gettime(CLOCK_MONOTONIC_RAW, ts);
 }
 
 
+/**
+ *  Get the CPU time used so far by the calling thread.
+ *  @param[out] ts time returned in this variable.
+ *  @return 0 on success, -1 in failure.
+ */
+static inline int timespec_now_thread_cpu(struct timespec *ts)
+{
+    return clock_gettime(CLOCK_THREAD_CPUTIME_ID, ts);
+}
+
+
+/**
+ *  Get the CPU time used so far by the whole process.
+ *  @param[out] ts time returned in this variable.
+ *  @return 0 on success, -1 in failure.
+ */
+static inline int timespec_now_process_cpu(struct timespec *ts)
+{
+    return clock_gettime(CLOCK_PROCESS_CPUTIME_ID, ts);
+}
+
+
 /**
  *  Add two timespec values, normalizing the result.
  *  @param[out] sum = addend_a + addend_b
  *  @param[in] addend_a (already normalized)
  *  @param[in] addend_b (already normalized)
  */
-inline void timespec_add(   struct timespec *sum, 
-                            struct timespec *addend_a,
-                            struct timespec *addend_b)
+static inline void timespec_add(   struct timespec *sum, 
+                                   const struct timespec *addend_a,
+                                   const struct timespec *addend_b)
 {
     sum->tv_sec = addend_a->tv_sec + addend_b->tv_sec;
     sum->tv_nsec = addend_a->tv_nsec + addend_b->tv_nsec;
@@ -107,9 +144,9 @@ inline void timespec_add(   struct timespec *sum,
  *  @param[in] minuend (already normalized)
  *  @param[in] subtrahend (already normalized)
  */
-inline void timespec_subtract(  struct timespec *difference,
-                                struct timespec *minuend,
-                                struct timespec *subtrahend)
+static inline void timespec_subtract(  struct timespec *difference,
+                                       const struct timespec *minuend,
+                                       const struct timespec *subtrahend)
 {
     difference->tv_sec = minuend->tv_sec - subtrahend->tv_sec;
     difference->tv_nsec = minuend->tv_nsec - subtrahend->tv_nsec;
@@ -122,13 +159,18 @@ inline void timespec_subtract(  struct timespec *difference,
 
 /**
  *  Fill in a timespec struct given milliseconds.
+ *  Negative values are normalized like any other.
  *  @param[out] ts
  *  @param[in] ms
  */
-inline void  timespec_from_ms(struct timespec *ts, int ms)
+static inline void  timespec_from_ms(struct timespec *ts, int ms)
 {
     ts->tv_sec = ms / MS_IN_SECOND;
     ts->tv_nsec = (ms % MS_IN_SECOND) * NS_IN_MS;
+    if (ts->tv_nsec < 0){
+        ts->tv_sec--;
+        ts->tv_nsec += NS_IN_SECOND;
+    }
 }
 
 
@@ -143,7 +185,8 @@ inline void  timespec_from_ms(struct timespec *ts, int ms)
  *  @param[in] b (already normalized)
  *  @return -1, 0, or 1
  */
-inline int timespec_compare(struct timespec *a, struct timespec *b)
+TIME_UTILITIES_PURE
+static inline int timespec_compare(const struct timespec *a, const struct timespec *b)
 {
     if (a->tv_sec > b->tv_sec){
         return 1;
@@ -168,7 +211,7 @@ inline int timespec_compare(struct timespec *a, struct timespec *b)
  *  We assume nothing about how unnormalized the timespec is.
  *  @param[in|out] ts structure that will be normalized.
  */
-inline void timespec_normalize(struct timespec *ts)
+static inline void timespec_normalize(struct timespec *ts)
 {
     while (ts->tv_nsec >= NS_IN_SECOND) {
         ts->tv_sec++;
@@ -181,6 +224,64 @@ inline void timespec_normalize(struct timespec *ts)
 }
 
 
+/*
+ *  By value forms of the arithmetic. The operands and result travel
+ *  in registers, nothing can alias, and the functions are marked 
+ *  const, so the compiler is free to fold, merge and vectorize 
+ *  them. They also work directly on const data and on expressions, 
+ *  e.g. timespec_sum(start, timeout).
+ */
+
+/**
+ *  Add two normalized timespec values.
+ *  @return a + b, normalized.
+ */
+TIME_UTILITIES_CONST
+static inline struct timespec timespec_sum(struct timespec a, struct timespec b)
+{
+    struct timespec sum;
+    sum.tv_sec = a.tv_sec + b.tv_sec;
+    sum.tv_nsec = a.tv_nsec + b.tv_nsec;
+    if (sum.tv_nsec >= NS_IN_SECOND){
+        sum.tv_sec++;
+        sum.tv_nsec -= NS_IN_SECOND;
+    }
+    return sum;
+}
+
+
+/**
+ *  Subtract two normalized timespec values.
+ *  @return a - b, normalized.
+ */
+TIME_UTILITIES_CONST
+static inline struct timespec timespec_diff(struct timespec a, struct timespec b)
+{
+    struct timespec difference;
+    difference.tv_sec = a.tv_sec - b.tv_sec;
+    difference.tv_nsec = a.tv_nsec - b.tv_nsec;
+    if (difference.tv_nsec < 0){
+        difference.tv_sec--;
+        difference.tv_nsec += NS_IN_SECOND;
+    }
+    return difference;
+}
+
+
+/**
+ *  Compare two normalized timespec values, like timespec_compare,
+ *  without branches.
+ *  @return -1, 0, or 1
+ */
+TIME_UTILITIES_CONST
+static inline int timespec_cmp(struct timespec a, struct timespec b)
+{
+    int sec = (a.tv_sec > b.tv_sec) - (a.tv_sec < b.tv_sec);
+    int nsec = (a.tv_nsec > b.tv_nsec) - (a.tv_nsec < b.tv_nsec);
+    return sec ? sec : nsec;
+}
+
+
 /*
  *  The struct timeval structure is not part of POSIX, however it is 
  *  used a lot in Linux / BSD / *nix code, and the structure is very 
@@ -196,7 +297,7 @@ inline void timespec_normalize(struct timespec *ts)
  *  @param[out] tv
  *  @param[in] ts
  */
-inline void timespec_to_timeval(struct timeval *tv, const struct timespec *ts)
+static inline void timespec_to_timeval(struct timeval *tv, const struct timespec *ts)
 {
     tv->tv_sec = ts->tv_sec;
     tv->tv_usec = ts->tv_nsec / 1000;
@@ -208,7 +309,7 @@ inline void timespec_to_timeval(struct timeval *tv, const struct timespec *ts)
  *  @param[out] ts
  *  @param[in] tv
  */
-inline void timeval_to_timespec(struct timespec *ts, const struct timeval *tv)
+static inline void timeval_to_timespec(struct timespec *ts, const struct timeval *tv)
 {
     ts->tv_sec = tv->tv_sec;
     ts->tv_nsec = tv->tv_usec * 1000;
@@ -220,7 +321,7 @@ inline void timeval_to_timespec(struct timespec *ts, const struct timeval *tv)
  *  @param[out] tv time returned in this variable.
  *  @return 0 on success, -1 in failure.
  */
-inline int timeval_now(struct timeval *tv)
+static inline int timeval_now(struct timeval *tv)
 {
     struct timespec ts;
     int rc;
@@ -235,7 +336,7 @@ inline int timeval_now(struct timeval *tv)
  *  @param[out] tv time returned in this variable.
  *  @return 0 on success, -1 in failure.
  */
-inline int timeval_now_monotonic(struct timeval *tv)
+static inline int timeval_now_monotonic(struct timeval *tv)
 {
     struct timespec ts;
     int rc;
@@ -250,7 +351,7 @@ inline int timeval_now_monotonic(struct timeval *tv)
  *  @param[out] tv time returned in this variable.
  *  @return 0 on success, -1 in failure.
  */
-inline int timeval_now_monotonic_raw(struct timeval *tv)
+static inline int timeval_now_monotonic_raw(struct timeval *tv)
 {
     struct timespec ts;
     int rc;
@@ -260,15 +361,45 @@ inline int timeval_now_monotonic_raw(struct timeval *tv)
 }
 
 
+/**
+ *  Get the CPU time used so far by the calling thread.
+ *  @param[out] tv time returned in this variable.
+ *  @return 0 on success, -1 in failure.
+ */
+static inline int timeval_now_thread_cpu(struct timeval *tv)
+{
+    struct timespec ts;
+    int rc;
+    rc = clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    timespec_to_timeval(tv, &ts);
+    return rc;
+}
+
+
+/**
+ *  Get the CPU time used so far by the whole process.
+ *  @param[out] tv time returned in this variable.
+ *  @return 0 on success, -1 in failure.
+ */
+static inline int timeval_now_process_cpu(struct timeval *tv)
+{
+    struct timespec ts;
+    int rc;
+    rc = clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    timespec_to_timeval(tv, &ts);
+    return rc;
+}
+
+
 /**
  *  Add two timeval values, normalizing the result.
  *  @param[out] sum = addend_a + addend_b
  *  @param[in] addend_a (already normalized)
  *  @param[in] addend_b (already normalized)
  */
-inline void timeval_add(struct timeval *sum, 
-                        struct timeval *addend_a,
-                        struct timeval *addend_b)
+static inline void timeval_add(struct timeval *sum, 
+                               const struct timeval *addend_a,
+                               const struct timeval *addend_b)
 {
     sum->tv_sec = addend_a->tv_sec + addend_b->tv_sec;
     sum->tv_usec = addend_a->tv_usec + addend_b->tv_usec;
@@ -285,9 +416,9 @@ inline void timeval_add(struct timeval *sum,
  *  @param[in] minuend (already normalized)
  *  @param[in] subtrahend (already normalized)
  */
-inline void timeval_subtract(  struct timeval *difference,
-                                struct timeval *minuend,
-                                struct timeval *subtrahend)
+static inline void timeval_subtract(  struct timeval *difference,
+                                       const struct timeval *minuend,
+                                       const struct timeval *subtrahend)
 {
     difference->tv_sec = minuend->tv_sec - subtrahend->tv_sec;
     difference->tv_usec = minuend->tv_usec - subtrahend->tv_usec;
@@ -300,13 +431,18 @@ inline void timeval_subtract(  struct timeval *difference,
 
 /**
  *  Fill in a timeval struct given milliseconds.
+ *  Negative values are normalized like any other.
  *  @param[out] tv
  *  @param[in] ms
  */
-inline void  timeval_from_ms(struct timeval *tv, int ms)
+static inline void  timeval_from_ms(struct timeval *tv, int ms)
 {
     tv->tv_sec = ms / MS_IN_SECOND;
     tv->tv_usec = (ms % MS_IN_SECOND) * US_IN_MS;
+    if (tv->tv_usec < 0){
+        tv->tv_sec--;
+        tv->tv_usec += US_IN_SECOND;
+    }
 }
 
 
@@ -321,7 +457,8 @@ inline void  timeval_from_ms(struct timeval *tv, int ms)
  *  @param[in] b (already normalized)
  *  @return -1, 0, or 1
  */
-inline int timeval_compare(struct timeval *a, struct timeval *b)
+TIME_UTILITIES_PURE
+static inline int timeval_compare(const struct timeval *a, const struct timeval *b)
 {
     if (a->tv_sec > b->tv_sec){
         return 1;
@@ -346,7 +483,7 @@ inline int timeval_compare(struct timeval *a, struct timeval *b)
  *  We assume nothing about how unnormalized the timeval is.
  *  @param[in|out] ts structure that will be normalized.
  */
-inline void timeval_normalize(struct timeval *tv)
+static inline void timeval_normalize(struct timeval *tv)
 {
     while (tv->tv_usec >= US_IN_SECOND) {
         tv->tv_sec++;
@@ -358,6 +495,56 @@ inline void timeval_normalize(struct timeval *tv)
     }
 }
 
+
+/**
+ *  Add two normalized timeval values.
+ *  @return a + b, normalized.
+ */
+TIME_UTILITIES_CONST
+static inline struct timeval timeval_sum(struct timeval a, struct timeval b)
+{
+    struct timeval sum;
+    sum.tv_sec = a.tv_sec + b.tv_sec;
+    sum.tv_usec = a.tv_usec + b.tv_usec;
+    if (sum.tv_usec >= US_IN_SECOND){
+        sum.tv_sec++;
+        sum.tv_usec -= US_IN_SECOND;
+    }
+    return sum;
+}
+
+
+/**
+ *  Subtract two normalized timeval values.
+ *  @return a - b, normalized.
+ */
+TIME_UTILITIES_CONST
+static inline struct timeval timeval_diff(struct timeval a, struct timeval b)
+{
+    struct timeval difference;
+    difference.tv_sec = a.tv_sec - b.tv_sec;
+    difference.tv_usec = a.tv_usec - b.tv_usec;
+    if (difference.tv_usec < 0){
+        difference.tv_sec--;
+        difference.tv_usec += US_IN_SECOND;
+    }
+    return difference;
+}
+
+
+/**
+ *  Compare two normalized timeval values, like timeval_compare,
+ *  without branches.
+ *  @return -1, 0, or 1
+ */
+TIME_UTILITIES_CONST
+static inline int timeval_cmp(struct timeval a, struct timeval b)
+{
+    int sec = (a.tv_sec > b.tv_sec) - (a.tv_sec < b.tv_sec);
+    int usec = (a.tv_usec > b.tv_usec) - (a.tv_usec < b.tv_usec);
+    return sec ? sec : usec;
+}
+
 #endif /* USING_TIMEVAL */
 
 
@@ -41,13 +41,19 @@
 #define TIME_UTILITIES_HPP__
 
 
-#include <iostream>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
 #include <ctime>
 
 #ifdef USING_TIMEVAL
 #include <sys/time.h>
 #endif
 
+#ifdef TIME_UTILITIES_USE_VDSO
+#include "vdso_clock.hpp"
+#endif
+
 
 /**
  *  Various time conversions.
@@ -57,6 +63,26 @@
 #define MS_IN_SECOND    (1000L)
 #define NS_IN_MS        (1000L * 1000L)
 #define US_IN_MS        (1000L)
+#define SEC_IN_DAY      (86400L)
+
+
+/**
+ *  Broken down UTC calendar time, like struct tm but with natural 
+ *  ranges: the real year, month 1-12, day 1-31, day_of_year 1-366.
+ *  weekday counts from Sunday = 0, as in struct tm.
+ */
+struct CCivilTime
+{
+    int64_t year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    int second;
+    long nsec;
+    int weekday;
+    int day_of_year;
+};
 
 
 /**
@@ -145,24 +171,42 @@ class CTimeSpec
 
         /**
          *  Static factory returning a CTimeSpec that represents "now"
-         *  in wall clock time. See CLOCK_REALTIME.
+         *  on an arbitrary clock, e.g. CLOCK_BOOTTIME, a coarse clock,
+         *  or a clock from clock_getcpuclockid(). All the other Now*
+         *  factories go through here.
+         *  @param clock clock to read. If the read fails the result 
+         *  is zero.
          */
-        static CTimeSpec Now()
+        static CTimeSpec NowForClock(clockid_t clock)
         {
             struct timespec ts;
-            clock_gettime(CLOCK_REALTIME, &ts);
+#ifdef TIME_UTILITIES_USE_VDSO
+            if (CVdsoClock::GetTime(clock, &ts) != 0) {
+#else
+            if (clock_gettime(clock, &ts) != 0) {
+#endif
+                ts.tv_sec = 0;
+                ts.tv_nsec = 0;
+            }
             return CTimeSpec {ts};
         }
 
+        /**
+         *  Static factory returning a CTimeSpec that represents "now"
+         *  in wall clock time. See CLOCK_REALTIME.
+         */
+        static CTimeSpec Now()
+        {
+            return NowForClock(CLOCK_REALTIME);
+        }
+
         /**
          *  Static factory returning a CTimeSpec that represents "now"
          *  in monotonic time. See CLOCK_MONOTONIC.
          */
         static CTimeSpec NowMonotonic()
         {
-            struct timespec ts;
-            clock_gettime(CLOCK_MONOTONIC, &ts);
-            return CTimeSpec {ts};
+            return NowForClock(CLOCK_MONOTONIC);
         }
 
         /**
@@ -171,20 +215,284 @@ class CTimeSpec
          */
         static CTimeSpec NowMonotonicRaw()
         {
-            struct timespec ts;
-            clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
-            return CTimeSpec {ts};
+            return NowForClock(CLOCK_MONOTONIC_RAW);
+        }
+
+        /**
+         *  Static factory returning a CTimeSpec that represents the CPU
+         *  time consumed so far by the calling thread. 
+         *  See CLOCK_THREAD_CPUTIME_ID.
+         */
+        static CTimeSpec NowThreadCpu()
+        {
+            return NowForClock(CLOCK_THREAD_CPUTIME_ID);
+        }
+
+        /**
+         *  Static factory returning a CTimeSpec that represents the CPU
+         *  time consumed so far by all threads in the process. 
+         *  See CLOCK_PROCESS_CPUTIME_ID.
+         */
+        static CTimeSpec NowProcessCpu()
+        {
+            return NowForClock(CLOCK_PROCESS_CPUTIME_ID);
         }
 
         /**
          *  Utility function to return a copy of the internal 
          *  timespec structure.
          */
-        struct timespec c_timespec()
+        struct timespec c_timespec() const
         {
             return ts;
         }
 
+        /**
+         *  Calendar fields of this time in UTC (proleptic Gregorian,
+         *  no leap seconds, like gmtime()).
+         *
+         *  Each thread caches the date of the last day it broke down,
+         *  so for the common case of many times on the same day this
+         *  is a subtraction, a compare and a couple of divisions.
+         */
+        CCivilTime Civil() const
+        {
+            struct DayCache {
+                int64_t start;
+                CCivilTime date;
+                bool valid;
+            };
+            static thread_local DayCache cache = {0, CCivilTime(), false};
+
+            int64_t sec = ts.tv_sec;
+            int64_t into_day = sec - cache.start;
+
+            if (!cache.valid || into_day < 0 || into_day >= SEC_IN_DAY) {
+                int64_t days = FloorDiv(sec, SEC_IN_DAY);
+                int64_t year;
+                unsigned month, day;
+                CivilFromDays(days, &year, &month, &day);
+
+                cache.start = days * SEC_IN_DAY;
+                cache.date.year = year;
+                cache.date.month = (int)month;
+                cache.date.day = (int)day;
+                cache.date.weekday = (int)(days - FloorDiv(days + 4, 7) * 7 + 4);
+                cache.date.day_of_year = (int)(days - DaysFromCivil(year, 1, 1)) + 1;
+                cache.valid = true;
+                into_day = sec - cache.start;
+            }
+
+            CCivilTime civil = cache.date;
+            int seconds = (int)into_day;
+            civil.hour = seconds / 3600;
+            civil.minute = seconds / 60 % 60;
+            civil.second = seconds % 60;
+            civil.nsec = ts.tv_nsec;
+            return civil;
+        }
+
+        /**
+         *  Individual UTC calendar fields, see Civil(). Fetch Civil()
+         *  once when several fields are needed.
+         */
+        int64_t Year() const        { return Civil().year; }
+        int Month() const           { return Civil().month; }
+        int Day() const             { return Civil().day; }
+        int Hour() const            { return Civil().hour; }
+        int Minute() const          { return Civil().minute; }
+        int Second() const          { return Civil().second; }
+        int Weekday() const         { return Civil().weekday; }
+        int DayOfYear() const       { return Civil().day_of_year; }
+
+        /**
+         *  This time plus a number of calendar days, keeping the 
+         *  time of day. In UTC a day is always SEC_IN_DAY seconds.
+         */
+        CTimeSpec AddDays(int64_t days) const
+        {
+            return CTimeSpec(ts.tv_sec + days * SEC_IN_DAY, ts.tv_nsec);
+        }
+
+        /**
+         *  This time plus a number of calendar months, keeping the 
+         *  time of day. A day of month that does not exist in the 
+         *  target month is clamped to its last day, so Jan 31 plus 
+         *  one month is Feb 28 (or 29).
+         */
+        CTimeSpec AddMonths(int64_t months) const
+        {
+            return CTimeSpec(AddMonthsToSeconds(ts.tv_sec, months), ts.tv_nsec);
+        }
+
+        /**
+         *  This time plus a number of calendar years, keeping the 
+         *  time of day. Feb 29 becomes Feb 28 in non leap years.
+         */
+        CTimeSpec AddYears(int64_t years) const
+        {
+            return AddMonths(years * 12);
+        }
+
+        /**
+         *  Midnight UTC starting the day this time falls on.
+         */
+        CTimeSpec FloorToDay() const
+        {
+            return CTimeSpec(FloorDiv(ts.tv_sec, SEC_IN_DAY) * SEC_IN_DAY, 0);
+        }
+
+        /**
+         *  Midnight UTC starting the week this time falls on.
+         *  @param first_weekday day weeks start on, Sunday = 0. 
+         *  The default is Monday, as in ISO 8601.
+         */
+        CTimeSpec FloorToWeek(int first_weekday = 1) const
+        {
+            return CTimeSpec(FloorToWeekSeconds(ts.tv_sec, first_weekday), 0);
+        }
+
+        /**
+         *  Midnight UTC on the first day of the month this time 
+         *  falls in. FloorToMonth().AddMonths(1) is the start of 
+         *  next month.
+         */
+        CTimeSpec FloorToMonth() const
+        {
+            return CTimeSpec(FloorToMonthSeconds(ts.tv_sec), 0);
+        }
+
+        /**
+         *  Midnight UTC on January 1st of the year this time falls in.
+         */
+        CTimeSpec FloorToYear() const
+        {
+            int64_t year;
+            unsigned month, day;
+            CivilFromDays(FloorDiv(ts.tv_sec, SEC_IN_DAY), &year, &month, &day);
+            return CTimeSpec(DaysFromCivil(year, 1, 1) * SEC_IN_DAY, 0);
+        }
+
+        /**
+         *  Number of midnights (UTC) crossed going from "from" to 
+         *  "to", i.e. the difference of their calendar dates. 
+         *  Negative if "to" is on an earlier date.
+         */
+        static int64_t DaysBetween(const CTimeSpec& from, const CTimeSpec& to)
+        {
+            return FloorDiv(to.ts.tv_sec, SEC_IN_DAY) - FloorDiv(from.ts.tv_sec, SEC_IN_DAY);
+        }
+
+        /**
+         *  Array versions of the calendar arithmetic, working in place.
+         *  The loop bodies are straight line integer code, so the
+         *  compiler is free to unroll and vectorize them.
+         */
+        static void AddDays(CTimeSpec *times, size_t count, int64_t days)
+        {
+            int64_t delta = days * SEC_IN_DAY;
+            for (size_t i = 0; i < count; i++)
+                times[i].ts.tv_sec += delta;
+        }
+
+        static void AddMonths(CTimeSpec *times, size_t count, int64_t months)
+        {
+            for (size_t i = 0; i < count; i++)
+                times[i].ts.tv_sec = AddMonthsToSeconds(times[i].ts.tv_sec, months);
+        }
+
+        static void FloorToDay(CTimeSpec *times, size_t count)
+        {
+            for (size_t i = 0; i < count; i++) {
+                times[i].ts.tv_sec = FloorDiv(times[i].ts.tv_sec, SEC_IN_DAY) * SEC_IN_DAY;
+                times[i].ts.tv_nsec = 0;
+            }
+        }
+
+        static void FloorToWeek(CTimeSpec *times, size_t count, int first_weekday = 1)
+        {
+            for (size_t i = 0; i < count; i++) {
+                times[i].ts.tv_sec = FloorToWeekSeconds(times[i].ts.tv_sec, first_weekday);
+                times[i].ts.tv_nsec = 0;
+            }
+        }
+
+        static void FloorToMonth(CTimeSpec *times, size_t count)
+        {
+            for (size_t i = 0; i < count; i++) {
+                times[i].ts.tv_sec = FloorToMonthSeconds(times[i].ts.tv_sec);
+                times[i].ts.tv_nsec = 0;
+            }
+        }
+
+        /**
+         *  days[i] = DaysBetween(from[i], to[i])
+         */
+        static void DaysBetween(const CTimeSpec *from, const CTimeSpec *to, 
+                                int64_t *days, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+                days[i] = DaysBetween(from[i], to[i]);
+        }
+
+        /**
+         *  True for Gregorian leap years.
+         */
+        static bool IsLeapYear(int64_t year)
+        {
+            return (year % 4 == 0) & ((year % 100 != 0) | (year % 400 == 0));
+        }
+
+        /**
+         *  Number of days in a month (1-12) of a year.
+         */
+        static unsigned DaysInMonth(int64_t year, unsigned month)
+        {
+            //
+            //  30 or 31 alternate, with the phase flipping in August;
+            //  February is the only special case.
+            //
+            return month == 2 ? 28 + IsLeapYear(year) : 30 + ((month ^ (month >> 3)) & 1);
+        }
+
+        /**
+         *  Days since 1970-01-01 of a proleptic Gregorian date.
+         *  Howard Hinnant's days_from_civil, exact for any year that
+         *  fits, with no table lookups and no loops.
+         *  @param year full year, e.g. 2016.
+         *  @param month 1-12.
+         *  @param day 1-31.
+         */
+        static int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day)
+        {
+            year -= month <= 2;
+            int64_t era = FloorDiv(year, 400);
+            unsigned year_of_era = (unsigned)(year - era * 400);
+            unsigned day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+            return era * 146097 + (int64_t)day_of_era - 719468;
+        }
+
+        /**
+         *  Proleptic Gregorian date of a count of days since 
+         *  1970-01-01. Inverse of DaysFromCivil().
+         */
+        static void CivilFromDays(int64_t days, int64_t *year, unsigned *month, unsigned *day)
+        {
+            days += 719468;
+            int64_t era = FloorDiv(days, 146097);
+            unsigned day_of_era = (unsigned)(days - era * 146097);
+            unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 
+                                    - day_of_era / 146096) / 365;
+            unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 
+                                                 - year_of_era / 100);
+            unsigned mp = (5 * day_of_year + 2) / 153;
+
+            *day = day_of_year - (153 * mp + 2) / 5 + 1;
+            *month = mp < 10 ? mp + 3 : mp - 9;
+            *year = (int64_t)year_of_era + era * 400 + (*month <= 2);
+        }
+
         /**
          *  Adds a CTimeSpec to this one. 
          *  Guarantees the result is normalized.
@@ -246,6 +554,8 @@ class CTimeSpec
         {
             if (ts.tv_sec < rhs.ts.tv_sec)
                 return true;
+            else if (ts.tv_sec != rhs.ts.tv_sec)
+                return false;
             else if (ts.tv_nsec < rhs.ts.tv_nsec)
                 return true;
             else 
@@ -260,6 +570,8 @@ class CTimeSpec
         {
             if (ts.tv_sec > rhs.ts.tv_sec)
                 return true;
+            else if (ts.tv_sec != rhs.ts.tv_sec)
+                return false;
             else if (ts.tv_nsec > rhs.ts.tv_nsec)
                 return true;
             else 
@@ -295,6 +607,50 @@ class CTimeSpec
         }
 
     private:
+        static int64_t AddMonthsToSeconds(int64_t sec, int64_t months)
+        {
+            int64_t days = FloorDiv(sec, SEC_IN_DAY);
+            int64_t time_of_day = sec - days * SEC_IN_DAY;
+            int64_t year;
+            unsigned month, day;
+
+            CivilFromDays(days, &year, &month, &day);
+
+            int64_t total = year * 12 + (month - 1) + months;
+            int64_t new_year = FloorDiv(total, 12);
+            unsigned new_month = (unsigned)(total - new_year * 12) + 1;
+            unsigned last = DaysInMonth(new_year, new_month);
+            unsigned new_day = day < last ? day : last;
+
+            return DaysFromCivil(new_year, new_month, new_day) * SEC_IN_DAY + time_of_day;
+        }
+
+        static int64_t FloorToWeekSeconds(int64_t sec, int first_weekday)
+        {
+            int64_t days = FloorDiv(sec, SEC_IN_DAY);
+            int64_t back = days + 4 - first_weekday;
+            back -= FloorDiv(back, 7) * 7;
+            return (days - back) * SEC_IN_DAY;
+        }
+
+        static int64_t FloorToMonthSeconds(int64_t sec)
+        {
+            int64_t days = FloorDiv(sec, SEC_IN_DAY);
+            int64_t year;
+            unsigned month, day;
+            CivilFromDays(days, &year, &month, &day);
+            return (days - (day - 1)) * SEC_IN_DAY;
+        }
+
+        /**
+         *  Division rounding toward negative infinity.
+         */
+        static int64_t FloorDiv(int64_t n, int64_t d)
+        {
+            int64_t q = n / d;
+            return q - ((n % d != 0) && ((n < 0) != (d < 0)));
+        }
+
         /**
          *  The internal data struct this class is wrapping.
          */
@@ -445,24 +801,42 @@ class CTimeVal
         
         /**
          *  Static factory returning a CTimeVal that represents "now"
-         *  in wall clock time. See CLOCK_REALTIME.
+         *  on an arbitrary clock, e.g. CLOCK_BOOTTIME, a coarse clock,
+         *  or a clock from clock_getcpuclockid(). All the other Now*
+         *  factories go through here.
+         *  @param clock clock to read. If the read fails the result 
+         *  is zero.
          */
-        static CTimeVal Now()
+        static CTimeVal NowForClock(clockid_t clock)
         {
             struct timespec ts;
-            clock_gettime(CLOCK_REALTIME, &ts);
+#ifdef TIME_UTILITIES_USE_VDSO
+            if (CVdsoClock::GetTime(clock, &ts) != 0) {
+#else
+            if (clock_gettime(clock, &ts) != 0) {
+#endif
+                ts.tv_sec = 0;
+                ts.tv_nsec = 0;
+            }
             return CTimeVal {ts};
         }
 
+        /**
+         *  Static factory returning a CTimeVal that represents "now"
+         *  in wall clock time. See CLOCK_REALTIME.
+         */
+        static CTimeVal Now()
+        {
+            return NowForClock(CLOCK_REALTIME);
+        }
+
         /**
          *  Static factory returning a CTimeVal that represents "now"
          *  in monotonic time. See CLOCK_MONOTONIC.
          */
         static CTimeVal NowMonotonic()
         {
-            struct timespec ts;
-            clock_gettime(CLOCK_MONOTONIC, &ts);
-            return CTimeVal {ts};
+            return NowForClock(CLOCK_MONOTONIC);
         }
 
         /**
@@ -471,16 +845,34 @@ class CTimeVal
          */
         static CTimeVal NowMonotonicRaw()
         {
-            struct timespec ts;
-            clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
-            return CTimeVal {ts};
+            return NowForClock(CLOCK_MONOTONIC_RAW);
+        }
+
+        /**
+         *  Static factory returning a CTimeVal that represents the CPU
+         *  time consumed so far by the calling thread. 
+         *  See CLOCK_THREAD_CPUTIME_ID.
+         */
+        static CTimeVal NowThreadCpu()
+        {
+            return NowForClock(CLOCK_THREAD_CPUTIME_ID);
+        }
+
+        /**
+         *  Static factory returning a CTimeVal that represents the CPU
+         *  time consumed so far by all threads in the process. 
+         *  See CLOCK_PROCESS_CPUTIME_ID.
+         */
+        static CTimeVal NowProcessCpu()
+        {
+            return NowForClock(CLOCK_PROCESS_CPUTIME_ID);
         }
 
         /**
          *  Utility function to return a copy of the internal 
          *  timeval structure.
          */
-        struct timeval c_timeval()
+        struct timeval c_timeval() const
         {
             return tv;
         }
@@ -546,6 +938,8 @@ class CTimeVal
         {
             if (tv.tv_sec < rhs.tv.tv_sec)
                 return true;
+            else if (tv.tv_sec != rhs.tv.tv_sec)
+                return false;
             else if (tv.tv_usec < rhs.tv.tv_usec)
                 return true;
             else 
@@ -560,6 +954,8 @@ class CTimeVal
         {
             if (tv.tv_sec > rhs.tv.tv_sec)
                 return true;
+            else if (tv.tv_sec != rhs.tv.tv_sec)
+                return false;
             else if (tv.tv_usec > rhs.tv.tv_usec)
                 return true;
             else 
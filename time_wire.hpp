@@ -0,0 +1,389 @@
+/**
+ *  @file
+ *
+ *  Compact binary encodings of CTimeSpec for RPC payloads and logs:
+ *
+ *  - Compact: zigzag varint seconds, then varint nanoseconds. 2 to
+ *    15 bytes, 10 for a current wall clock time.
+ *  - Timestamp / Duration: the body of a protobuf 
+ *    google.protobuf.Timestamp or Duration message, so the bytes 
+ *    can be embedded in or read from protobuf messages directly.
+ *  - Delta: zigzag varint nanoseconds from a base time, 1 to 9 bytes
+ *    for anything within 292 years of the base; a column of nearby 
+ *    timestamps costs a few bytes each.
+ *
+ *  Encoders write to a caller buffer of at least TIME_WIRE_MAX bytes
+ *  (per value) and return the bytes written. Decoders return the 
+ *  bytes consumed, or 0 if the input is truncated or malformed.
+ *
+ *  This header requires C++11 support.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef TIME_WIRE_HPP__
+#define TIME_WIRE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "time_utilities.hpp"
+
+
+/**
+ *  Longest encoding of one value: a protobuf Duration with both 
+ *  fields negative is two tags and two 10 byte varints.
+ */
+#define TIME_WIRE_MAX  (22)
+
+
+/**
+ *  Longest varint, a 64 bit value.
+ */
+#define VARINT_MAX  (10)
+
+
+class CTimeWire
+{
+    public:
+
+        /**
+         *  Write v as a base 128 varint, low group first.
+         *  @return bytes written, 1 to VARINT_MAX.
+         */
+        static size_t EncodeVarint(uint8_t *out, uint64_t v)
+        {
+            uint8_t *p = out;
+            while (v >= 0x80) {
+                *p++ = (uint8_t)(v | 0x80);
+                v >>= 7;
+            }
+            *p++ = (uint8_t)v;
+            return (size_t)(p - out);
+        }
+
+        /**
+         *  Read a varint.
+         *  @return bytes consumed, 0 if truncated or longer than 
+         *  VARINT_MAX bytes.
+         */
+        static size_t DecodeVarint(const uint8_t *in, size_t size, uint64_t *v)
+        {
+            //
+            //  With 8 bytes in hand, find the terminating byte and
+            //  gather the 7 bit groups without a loop.
+            //
+            if (size >= 8) {
+                uint64_t word = Load64(in);
+                uint64_t stops = ~word & 0x8080808080808080ULL;
+                if (stops) {
+                    size_t length = (size_t)(__builtin_ctzll(stops) + 1) / 8;
+                    if (length < 8)
+                        word &= (1ULL << (length * 8)) - 1;
+                    *v = Gather7(word);
+                    return length;
+                }
+            }
+
+            uint64_t result = 0;
+            for (size_t i = 0; i < size && i < VARINT_MAX; i++) {
+                result |= (uint64_t)(in[i] & 0x7f) << (7 * i);
+                if (!(in[i] & 0x80)) {
+                    *v = result;
+                    return i + 1;
+                }
+            }
+            return 0;
+        }
+
+        /**
+         *  Bytes EncodeVarint() would write for v.
+         */
+        static size_t VarintSize(uint64_t v)
+        {
+            //  (bits * 9 + 64) / 64 is ceil(bits / 7) for 1 to 64 bits.
+            int bits = 64 - __builtin_clzll(v | 1);
+            return (size_t)(bits * 9 + 64) / 64;
+        }
+
+        /**
+         *  Map signed to unsigned so small magnitudes of either sign 
+         *  make short varints: 0, -1, 1, -2 ... become 0, 1, 2, 3 ...
+         */
+        static uint64_t ZigZag(int64_t v)
+        {
+            return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+        }
+
+        static int64_t UnZigZag(uint64_t v)
+        {
+            return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+        }
+
+        /**
+         *  Compact: zigzag varint seconds, varint nanoseconds.
+         */
+        static size_t EncodeCompact(uint8_t *out, const CTimeSpec& value)
+        {
+            struct timespec ts = value.c_timespec();
+            size_t n = EncodeVarint(out, ZigZag(ts.tv_sec));
+            return n + EncodeVarint(out + n, (uint64_t)ts.tv_nsec);
+        }
+
+        static size_t DecodeCompact(const uint8_t *in, size_t size, CTimeSpec *value)
+        {
+            uint64_t sec, nsec;
+            size_t n = DecodeVarint(in, size, &sec);
+            if (!n)
+                return 0;
+            size_t m = DecodeVarint(in + n, size - n, &nsec);
+            if (!m || nsec >= NS_IN_SECOND)
+                return 0;
+            *value = CTimeSpec((time_t)UnZigZag(sec), (long)nsec);
+            return n + m;
+        }
+
+        /**
+         *  Body of a protobuf Timestamp: field 1 int64 seconds, field 2
+         *  int32 nanos in [0, 1e9), zero fields omitted as proto3 does.
+         */
+        static size_t EncodeTimestamp(uint8_t *out, const CTimeSpec& value)
+        {
+            struct timespec ts = value.c_timespec();
+            return EncodeMessage(out, ts.tv_sec, ts.tv_nsec);
+        }
+
+        /**
+         *  Read a whole Timestamp message body of "size" bytes. 
+         *  Fields may come in any order, the last of a repeated field
+         *  wins and unknown fields are skipped, as protobuf parsers do.
+         *  @return size, or 0 if malformed or nanos out of range.
+         */
+        static size_t DecodeTimestamp(const uint8_t *in, size_t size, CTimeSpec *value)
+        {
+            int64_t sec;
+            int64_t nsec;
+            if (!DecodeMessage(in, size, &sec, &nsec) || nsec < 0 || nsec >= NS_IN_SECOND)
+                return 0;
+            *value = CTimeSpec((time_t)sec, (long)nsec);
+            return size;
+        }
+
+        /**
+         *  Body of a protobuf Duration: seconds and nanos carry the 
+         *  same sign, so -0.5s is {0, -500000000}, not {-1, 500000000}.
+         */
+        static size_t EncodeDuration(uint8_t *out, const CTimeSpec& value)
+        {
+            struct timespec ts = value.c_timespec();
+            int64_t sec = ts.tv_sec;
+            int64_t nsec = ts.tv_nsec;
+            if (sec < 0 && nsec > 0) {
+                sec++;
+                nsec -= NS_IN_SECOND;
+            }
+            return EncodeMessage(out, sec, nsec);
+        }
+
+        static size_t DecodeDuration(const uint8_t *in, size_t size, CTimeSpec *value)
+        {
+            int64_t sec;
+            int64_t nsec;
+            if (!DecodeMessage(in, size, &sec, &nsec) || 
+                nsec <= -NS_IN_SECOND || nsec >= NS_IN_SECOND ||
+                (sec < 0 && nsec > 0) || (sec > 0 && nsec < 0))
+                return 0;
+            *value = CTimeSpec((time_t)sec, (long)nsec);
+            return size;
+        }
+
+        /**
+         *  Delta: zigzag varint of value - base in nanoseconds.
+         *  @return bytes written, 0 if the two are more than 292 
+         *  years apart.
+         */
+        static size_t EncodeDelta(uint8_t *out, const CTimeSpec& value, const CTimeSpec& base)
+        {
+            int64_t delta;
+            if (!DeltaNs(value, base, &delta))
+                return 0;
+            return EncodeVarint(out, ZigZag(delta));
+        }
+
+        static size_t DecodeDelta(const uint8_t *in, size_t size, const CTimeSpec& base, 
+                                  CTimeSpec *value)
+        {
+            uint64_t v;
+            size_t n = DecodeVarint(in, size, &v);
+            if (n)
+                *value = AddNs(base, UnZigZag(v));
+            return n;
+        }
+
+        /**
+         *  Delta encode a column against one base.
+         *  @param out room for count * VARINT_MAX bytes.
+         *  @return bytes written, 0 if any value is out of range.
+         */
+        static size_t EncodeDeltas(uint8_t *out, const CTimeSpec *values, size_t count, 
+                                   const CTimeSpec& base)
+        {
+            uint8_t *p = out;
+            for (size_t i = 0; i < count; i++) {
+                size_t n = EncodeDelta(p, values[i], base);
+                if (!n)
+                    return 0;
+                p += n;
+            }
+            return (size_t)(p - out);
+        }
+
+        /**
+         *  Decode a column written by EncodeDeltas().
+         *  @return bytes consumed, 0 if the input runs out early.
+         */
+        static size_t DecodeDeltas(const uint8_t *in, size_t size, const CTimeSpec& base, 
+                                   CTimeSpec *values, size_t count)
+        {
+            const uint8_t *p = in;
+            const uint8_t *end = in + size;
+
+            for (size_t i = 0; i < count; i++) {
+                uint64_t v;
+                size_t n = DecodeVarint(p, (size_t)(end - p), &v);
+                if (!n)
+                    return 0;
+                p += n;
+                values[i] = AddNs(base, UnZigZag(v));
+            }
+            return (size_t)(p - in);
+        }
+
+    private:
+        static uint64_t Load64(const uint8_t *in)
+        {
+            uint64_t word;
+            memcpy(&word, in, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            word = __builtin_bswap64(word);
+#endif
+            return word;
+        }
+
+        /**
+         *  Squeeze the low 7 bits of each of 8 bytes into 56 bits, 
+         *  pairs, then quads, then halves at a time.
+         */
+        static uint64_t Gather7(uint64_t x)
+        {
+            x &= 0x7f7f7f7f7f7f7f7fULL;
+            x = ((x & 0x7f007f007f007f00ULL) >> 1) | (x & 0x007f007f007f007fULL);
+            x = ((x & 0x3fff00003fff0000ULL) >> 2) | (x & 0x00003fff00003fffULL);
+            x = ((x & 0x0fffffff00000000ULL) >> 4) | (x & 0x000000000fffffffULL);
+            return x;
+        }
+
+        static size_t EncodeMessage(uint8_t *out, int64_t sec, int64_t nsec)
+        {
+            uint8_t *p = out;
+            if (sec) {
+                *p++ = 0x08;
+                p += EncodeVarint(p, (uint64_t)sec);
+            }
+            if (nsec) {
+                *p++ = 0x10;
+                p += EncodeVarint(p, (uint64_t)nsec);
+            }
+            return (size_t)(p - out);
+        }
+
+        static bool DecodeMessage(const uint8_t *in, size_t size, int64_t *sec, int64_t *nsec)
+        {
+            const uint8_t *p = in;
+            const uint8_t *end = in + size;
+
+            *sec = 0;
+            *nsec = 0;
+            while (p != end) {
+                uint64_t key, v;
+                size_t n = DecodeVarint(p, (size_t)(end - p), &key);
+                if (!n)
+                    return false;
+                p += n;
+
+                switch (key & 7) {
+                    case 0:
+                        n = DecodeVarint(p, (size_t)(end - p), &v);
+                        if (!n)
+                            return false;
+                        p += n;
+                        if (key == 0x08)
+                            *sec = (int64_t)v;
+                        else if (key == 0x10)
+                            *nsec = (int32_t)v;
+                        break;
+                    case 1:
+                        if (end - p < 8)
+                            return false;
+                        p += 8;
+                        break;
+                    case 2:
+                        n = DecodeVarint(p, (size_t)(end - p), &v);
+                        if (!n || v > (uint64_t)(end - p - n))
+                            return false;
+                        p += n + v;
+                        break;
+                    case 5:
+                        if (end - p < 4)
+                            return false;
+                        p += 4;
+                        break;
+                    default:
+                        return false;
+                }
+                if ((key >> 3) == 0 || ((key >> 3) <= 2 && (key & 7) != 0))
+                    return false;
+            }
+            return true;
+        }
+
+        static bool DeltaNs(const CTimeSpec& value, const CTimeSpec& base, int64_t *delta)
+        {
+            struct timespec a = value.c_timespec();
+            struct timespec b = base.c_timespec();
+            __int128 ns = ((__int128)a.tv_sec - b.tv_sec) * NS_IN_SECOND + (a.tv_nsec - b.tv_nsec);
+            if (ns < INT64_MIN || ns > INT64_MAX)
+                return false;
+            *delta = (int64_t)ns;
+            return true;
+        }
+
+        static CTimeSpec AddNs(const CTimeSpec& base, int64_t delta)
+        {
+            struct timespec b = base.c_timespec();
+            return CTimeSpec(b.tv_sec + delta / NS_IN_SECOND, b.tv_nsec + delta % NS_IN_SECOND);
+        }
+};
+
+
+#endif
@@ -0,0 +1,332 @@
+/**
+ *  @file
+ *
+ *  Characterize the clocks available to time_utilities on this host.
+ *  For every clock, on every CPU the process may run on, measure the
+ *  cost of a read, the reported and observed resolution, and how 
+ *  often consecutive reads went backwards. Then bound the offset of
+ *  each clock between the first CPU and every other CPU, and print a
+ *  recommendation of which Now* factory to use.
+ *
+ *  Usage:
+ *  ./clock_characterize [-n reads] [-r rounds]
+ *
+ *      -n  reads per clock per CPU (default 1000000)
+ *      -r  ping-pong rounds per CPU pair (default 20000)
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "time_utilities.hpp"
+#include "tsc_clock.hpp"
+#include "cross_core.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_TSC
+#endif
+
+
+/**
+ *  One clock under test.
+ */
+struct ClockSource
+{
+    const char *name;
+    clockid_t id;
+    bool tsc;
+    /**
+     *  The time_utilities factory reading this clock, if any.
+     */
+    const char *factory;
+};
+
+
+static const ClockSource clock_sources[] = {
+    {"CLOCK_REALTIME",          CLOCK_REALTIME,         false, "CTimeSpec::Now()"},
+    {"CLOCK_REALTIME_COARSE",   CLOCK_REALTIME_COARSE,  false, nullptr},
+    {"CLOCK_MONOTONIC",         CLOCK_MONOTONIC,        false, "CTimeSpec::NowMonotonic()"},
+    {"CLOCK_MONOTONIC_COARSE",  CLOCK_MONOTONIC_COARSE, false, nullptr},
+    {"CLOCK_MONOTONIC_RAW",     CLOCK_MONOTONIC_RAW,    false, "CTimeSpec::NowMonotonicRaw()"},
+    {"CLOCK_BOOTTIME",          CLOCK_BOOTTIME,         false, nullptr},
+#ifdef HAVE_TSC
+    {"TSC",                     0,                      true,  nullptr},
+#endif
+};
+
+#define NUM_CLOCKS  (sizeof(clock_sources) / sizeof(clock_sources[0]))
+
+
+/**
+ *  Per clock, per CPU measurements. Costs and resolutions in ns.
+ */
+struct ReadStats
+{
+    double cost;
+    double resolution;
+    double distinct;
+    uint64_t violations;
+};
+
+
+/**
+ *  Aggregate of ReadStats over all CPUs.
+ */
+struct ClockSummary
+{
+    double cost_max;
+    double resolution_max;
+    uint64_t violations;
+    bool cross_core_ok;
+    uint64_t cross_core_violations;
+};
+
+
+static inline int64_t ReadClock(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (int64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+}
+
+
+#ifdef HAVE_TSC
+static inline int64_t ReadTsc()
+{
+    return (int64_t)CTscClock::Read();
+}
+#endif
+
+
+/**
+ *  Read a clock back to back "reads" times.
+ *  @param ns_per_unit converts clock units into ns.
+ */
+template <typename ReadFn>
+static ReadStats MeasureReads(ReadFn read, long reads, double ns_per_unit)
+{
+    ReadStats stats;
+    int64_t previous = read();
+    int64_t smallest_step = INT64_MAX;
+    long changes = 0;
+
+    stats.violations = 0;
+
+    CTimeSpec start = CTimeSpec::NowMonotonicRaw();
+    for (long i = 0; i < reads; i++) {
+        int64_t now = read();
+        int64_t step = now - previous;
+        if (step < 0) {
+            stats.violations++;
+        }
+        else if (step > 0) {
+            changes++;
+            if (step < smallest_step)
+                smallest_step = step;
+        }
+        previous = now;
+    }
+    struct timespec elapsed = (CTimeSpec::NowMonotonicRaw() - start).c_timespec();
+
+    stats.cost = ((double)elapsed.tv_sec * NS_IN_SECOND + elapsed.tv_nsec) / reads;
+    stats.resolution = smallest_step == INT64_MAX ? 0 : smallest_step * ns_per_unit;
+    stats.distinct = (double)changes / reads;
+    return stats;
+}
+
+
+static void Usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [-n reads] [-r rounds]\n", program);
+    exit(1);
+}
+
+
+int main(int argc, char **argv)
+{
+    long reads = 1000000;
+    long rounds = 20000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                reads = atol(optarg);
+                break;
+            case 'r':
+                rounds = atol(optarg);
+                break;
+            default:
+                Usage(argv[0]);
+        }
+    }
+    if (reads <= 0 || rounds <= 0)
+        Usage(argv[0]);
+
+    std::vector<int> cpus = AllowedCpus();
+    if (cpus.empty()) {
+        fprintf(stderr, "no usable CPUs\n");
+        return 1;
+    }
+
+    double tsc_ns_per_tick = 0;
+#ifdef HAVE_TSC
+    tsc_ns_per_tick = NS_IN_SECOND / CTscClock::Instance().TicksPerSecond();
+    printf("TSC: %.3f GHz, invariant: %s\n", 
+           1.0 / tsc_ns_per_tick, CTscClock::Invariant() ? "yes" : "no");
+#endif
+
+    ClockSummary summary[NUM_CLOCKS];
+
+    printf("\n%-24s %5s %10s %10s %12s %9s %10s\n", 
+           "clock", "cpu", "ns/call", "getres ns", "observed ns", "distinct", "backwards");
+
+    for (size_t c = 0; c < NUM_CLOCKS; c++) {
+        const ClockSource &source = clock_sources[c];
+        ClockSummary &sum = summary[c];
+        memset(&sum, 0, sizeof(sum));
+        sum.cross_core_ok = true;
+
+        long getres = 0;
+        if (!source.tsc) {
+            struct timespec res;
+            if (clock_getres(source.id, &res) == 0)
+                getres = res.tv_sec * NS_IN_SECOND + res.tv_nsec;
+        }
+
+        for (int cpu : cpus) {
+            ReadStats stats;
+            PinToCpu(cpu);
+#ifdef HAVE_TSC
+            if (source.tsc)
+                stats = MeasureReads(ReadTsc, reads, tsc_ns_per_tick);
+            else
+#endif
+                stats = MeasureReads([&]() { return ReadClock(source.id); }, reads, 1.0);
+
+            printf("%-24s %5d %10.1f %10ld %12.1f %8.1f%% %10llu\n", 
+                   source.name, cpu, stats.cost, getres, stats.resolution, 
+                   stats.distinct * 100, (unsigned long long)stats.violations);
+
+            sum.cost_max = std::max(sum.cost_max, stats.cost);
+            sum.resolution_max = std::max(sum.resolution_max, stats.resolution);
+            sum.violations += stats.violations;
+        }
+    }
+
+    if (cpus.size() > 1) {
+        printf("\nCross-core offsets relative to cpu %d (ns)\n", cpus[0]);
+        printf("%-24s %5s %14s %14s %10s %10s\n", 
+               "clock", "cpu", "offset min", "offset max", "rtt min", "backwards");
+
+        for (size_t c = 0; c < NUM_CLOCKS; c++) {
+            const ClockSource &source = clock_sources[c];
+            double scale = source.tsc ? tsc_ns_per_tick : 1.0;
+
+            for (size_t i = 1; i < cpus.size(); i++) {
+                CrossCoreResult r;
+#ifdef HAVE_TSC
+                if (source.tsc)
+                    r = MeasureCrossCore(cpus[0], cpus[i], rounds, ReadTsc);
+                else
+#endif
+                    r = MeasureCrossCore(cpus[0], cpus[i], rounds, 
+                                         [&]() { return ReadClock(source.id); });
+
+                printf("%-24s %5d %14.0f %14.0f %10.0f %10llu\n", 
+                       source.name, cpus[i], r.offset_min * scale, r.offset_max * scale,
+                       r.round_trip_min * scale, (unsigned long long)r.violations);
+
+                if (!r.Synchronized())
+                    summary[c].cross_core_ok = false;
+                summary[c].cross_core_violations += r.violations;
+            }
+        }
+    }
+    else {
+        printf("\nOnly one CPU available, skipping cross-core measurements.\n");
+    }
+
+    //
+    //  Recommendation. Only clocks that never went backwards, on one
+    //  CPU or between CPUs, are candidates. Among the monotonic 
+    //  factories pick the cheapest, preferring NowMonotonic() unless
+    //  NowMonotonicRaw() is clearly (more than 10%) cheaper, since 
+    //  NTP frequency correction is usually what people want.
+    //
+    printf("\nRecommendation:\n");
+
+    const ClockSummary &realtime = summary[0];
+    const ClockSummary &monotonic = summary[2];
+    const ClockSummary &monotonic_raw = summary[4];
+    bool monotonic_ok = monotonic.violations == 0 && monotonic.cross_core_violations == 0;
+    bool raw_ok = monotonic_raw.violations == 0 && monotonic_raw.cross_core_violations == 0;
+
+    if (monotonic_ok && (!raw_ok || monotonic.cost_max <= monotonic_raw.cost_max * 1.1)) {
+        printf("  intervals:  CTimeSpec::NowMonotonic()     (%.1f ns/call)\n", 
+               monotonic.cost_max);
+    }
+    else if (raw_ok) {
+        printf("  intervals:  CTimeSpec::NowMonotonicRaw()  (%.1f ns/call, "
+               "NowMonotonic() costs %.1f)\n", monotonic_raw.cost_max, monotonic.cost_max);
+    }
+    else {
+        printf("  intervals:  no monotonic clock behaved monotonically on this host!\n");
+    }
+
+    printf("  wall clock: CTimeSpec::Now()              (%.1f ns/call)\n", realtime.cost_max);
+
+    //
+    //  A read costing several hundred ns means the vDSO is not in 
+    //  use (no usable clocksource), so every read is a syscall.
+    //
+    if (monotonic.cost_max > 200) {
+        printf("  note:       clock reads look like syscalls (%.0f ns); if ~%.0f ms "
+               "granularity is enough, CLOCK_MONOTONIC_COARSE costs %.1f ns\n", 
+               monotonic.cost_max, summary[3].resolution_max / NS_IN_MS, summary[3].cost_max);
+    }
+
+#ifdef HAVE_TSC
+    const ClockSummary &tsc = summary[NUM_CLOCKS - 1];
+    if (CTscClock::Invariant() && tsc.violations == 0 && tsc.cross_core_ok && 
+        tsc.cross_core_violations == 0) {
+        printf("  TSC:        invariant and consistent across %s (%.1f ns/call), "
+               "a candidate for CTscClock,\n"
+               "              confirm with tsc_sync_check\n", 
+               cpus.size() > 1 ? "CPUs" : "reads (one CPU only)", tsc.cost_max);
+    }
+    else {
+        printf("  TSC:        not safe to use as a clock on this host\n");
+    }
+#endif
+
+    return 0;
+}
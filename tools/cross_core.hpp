@@ -0,0 +1,179 @@
+/**
+ *  @file
+ *
+ *  Helpers shared by the measurement tools for pinning threads to 
+ *  CPUs and for bounding the offset between a clock as read on two 
+ *  different CPUs.
+ *
+ *  The offset measurement is the usual ping-pong. The local CPU 
+ *  reads t1 and pings, the remote CPU reads t2 and pongs, the local 
+ *  CPU reads t3. If the remote clock is the local clock plus some 
+ *  offset, causality gives
+ *
+ *      t2 - t3 <= offset <= t2 - t1
+ *
+ *  Intersecting those bounds over many rounds gives a tight window.
+ *  If the window excludes zero the clocks are provably out of step.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef CROSS_CORE_HPP__
+#define CROSS_CORE_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <sched.h>
+#include <pthread.h>
+
+
+/**
+ *  List of CPUs this process is allowed to run on.
+ */
+inline std::vector<int> AllowedCpus()
+{
+    std::vector<int> cpus;
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return cpus;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set))
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+
+/**
+ *  Pin the calling thread to a single CPU.
+ *  @return 0 on success, an errno value on failure.
+ */
+inline int PinToCpu(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+
+/**
+ *  Result of a ping-pong run between two CPUs. All values are in 
+ *  the units of the clock being read (ns, or ticks for the TSC).
+ */
+struct CrossCoreResult
+{
+    /**
+     *  The remote clock minus the local clock lies within 
+     *  [offset_min, offset_max].
+     */
+    int64_t offset_min;
+    int64_t offset_max;
+
+    /**
+     *  Shortest t3 - t1 seen, which limits how tight the 
+     *  window can get.
+     */
+    int64_t round_trip_min;
+
+    /**
+     *  Rounds in which the remote read was outside [t1, t3], i.e.
+     *  time was seen to go backwards when moving between CPUs.
+     */
+    uint64_t violations;
+
+    uint64_t rounds;
+
+    /**
+     *  True if zero offset is consistent with every round.
+     */
+    bool Synchronized() const
+    {
+        return offset_min <= 0 && offset_max >= 0;
+    }
+};
+
+
+/**
+ *  Bound the offset of "read" between two CPUs.
+ *  @param local_cpu CPU the calling side is pinned to.
+ *  @param remote_cpu CPU the responding thread is pinned to.
+ *  @param rounds number of ping-pong exchanges.
+ *  @param read callable returning the current clock value as int64_t.
+ *
+ *  The calling thread's affinity is changed to local_cpu.
+ */
+template <typename ReadFn>
+CrossCoreResult MeasureCrossCore(int local_cpu, int remote_cpu, 
+                                 uint64_t rounds, ReadFn read)
+{
+    CrossCoreResult result;
+    std::atomic<uint64_t> sequence {0};
+    std::atomic<int64_t> remote_time {0};
+
+    result.offset_min = INT64_MIN;
+    result.offset_max = INT64_MAX;
+    result.round_trip_min = INT64_MAX;
+    result.violations = 0;
+    result.rounds = rounds;
+
+    std::thread remote([&]() {
+        PinToCpu(remote_cpu);
+        for (uint64_t i = 0; i < rounds; i++) {
+            while (sequence.load(std::memory_order_acquire) != 2 * i + 1)
+                ;
+            remote_time.store(read(), std::memory_order_relaxed);
+            sequence.store(2 * i + 2, std::memory_order_release);
+        }
+    });
+
+    PinToCpu(local_cpu);
+
+    for (uint64_t i = 0; i < rounds; i++) {
+        int64_t t1 = read();
+        sequence.store(2 * i + 1, std::memory_order_release);
+        while (sequence.load(std::memory_order_acquire) != 2 * i + 2)
+            ;
+        int64_t t3 = read();
+        int64_t t2 = remote_time.load(std::memory_order_relaxed);
+
+        if (t2 - t3 > result.offset_min)
+            result.offset_min = t2 - t3;
+        if (t2 - t1 < result.offset_max)
+            result.offset_max = t2 - t1;
+        if (t3 - t1 < result.round_trip_min)
+            result.round_trip_min = t3 - t1;
+        if (t2 < t1 || t2 > t3)
+            result.violations++;
+    }
+
+    remote.join();
+    return result;
+}
+
+
+#endif
@@ -0,0 +1,469 @@
+/**
+ *  @file
+ *
+ *  Wakeup latency and jitter of timed sleeps, in the manner of 
+ *  rt-tests' cyclictest, for qualifying hosts.
+ *
+ *  One measurement thread per CPU, each pinned, sleeps to absolute 
+ *  deadlines "interval" apart with clock_nanosleep(TIMER_ABSTIME) and
+ *  records how late it woke up. At the end it prints, per thread, 
+ *  min/avg/max and percentiles in us, and with -H a per us histogram
+ *  in cyclictest's --histogram format, so existing plotting scripts
+ *  work on it.
+ *
+ *  Usage:
+ *  ./cyclictest [-i interval_us] [-l loops] [-D seconds] [-p priority]
+ *               [-y policy] [-a cpus] [-c clock] [-H max_us] [-m] [-q]
+ *
+ *      -i  wakeup interval (default 1000us)
+ *      -l  wakeups per thread, 0 to run for -D or until SIGINT 
+ *          (default 0)
+ *      -D  seconds to run when -l is 0 (default 10, 0 for no limit)
+ *      -p  real time priority; above 0 selects SCHED_FIFO unless -y 
+ *          says otherwise (default 0)
+ *      -y  scheduling policy: other, batch, idle, fifo or rr
+ *      -a  CPUs to measure on, e.g. "0,2-3" (default all allowed)
+ *      -c  clock: monotonic (default) or realtime
+ *      -H  dump a histogram of 0 .. max_us - 1 us buckets
+ *      -m  lock all memory (mlockall) before measuring
+ *      -q  print only the summary, no per thread lines
+ *
+ *  Real time policies need CAP_SYS_NICE (or root). Exit status is 0 
+ *  after a run, 1 if the scheduling setup failed, 2 on usage errors.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "time_utilities.hpp"
+#include "latency_histogram.hpp"
+#include "cross_core.hpp"
+
+
+/**
+ *  What every measurement thread is told to do.
+ */
+struct Settings
+{
+    CTimeSpec interval;
+    long loops;
+    clockid_t clock;
+    int policy;
+    int priority;
+    int histogram_us;
+};
+
+
+/**
+ *  What one measurement thread saw. Latencies in ns.
+ */
+struct ThreadResult
+{
+    int cpu;
+    pid_t tid;
+    int error;
+    uint64_t cycles;
+    uint64_t overruns;
+    uint64_t last;
+    std::vector<uint64_t> histogram;
+    uint64_t overflows;
+    CLatencyHistogram latencies;
+};
+
+
+static std::atomic<bool> stop_requested(false);
+
+
+static void OnSignal(int)
+{
+    stop_requested.store(true);
+}
+
+
+static void Usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [-i interval_us] [-l loops] [-D seconds] [-p priority]\n"
+                    "       %*s [-y policy] [-a cpus] [-c clock] [-H max_us] [-m] [-q]\n",
+            program, (int)strlen(program), "");
+    exit(2);
+}
+
+
+/**
+ *  Parse "0,2-3" into CPU numbers.
+ *  @return false on a malformed list.
+ */
+static bool ParseCpuList(const char *text, std::vector<int> *cpus)
+{
+    const char *p = text;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0 || first >= CPU_SETSIZE)
+            return false;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first || last >= CPU_SETSIZE)
+                return false;
+            p = end;
+        }
+        for (long cpu = first; cpu <= last; cpu++)
+            cpus->push_back((int)cpu);
+        if (*p == ',')
+            p++;
+        else if (*p)
+            return false;
+    }
+    return !cpus->empty();
+}
+
+
+static bool ParsePolicy(const char *text, int *policy)
+{
+    static const struct { const char *name; int policy; } policies[] = {
+        {"other", SCHED_OTHER}, {"batch", SCHED_BATCH}, {"idle", SCHED_IDLE},
+        {"fifo", SCHED_FIFO}, {"rr", SCHED_RR},
+    };
+    for (const auto &entry : policies) {
+        if (strcmp(text, entry.name) == 0) {
+            *policy = entry.policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+static const char *PolicyName(int policy)
+{
+    switch (policy) {
+        case SCHED_FIFO:  return "fifo";
+        case SCHED_RR:    return "rr";
+        case SCHED_BATCH: return "batch";
+        case SCHED_IDLE:  return "idle";
+        default:          return "other";
+    }
+}
+
+
+static uint64_t ToNs(const CTimeSpec& duration)
+{
+    struct timespec ts = duration.c_timespec();
+    if (ts.tv_sec < 0)
+        return 0;
+    return (uint64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+}
+
+
+/**
+ *  Body of one measurement thread: pin, set the policy, then sleep
+ *  to each deadline and record how late the wakeup was. A deadline
+ *  already passed on wakeup (the thread was held off for more than
+ *  an interval) counts as an overrun and is skipped, as cyclictest 
+ *  does, rather than answered with a burst of immediate wakeups.
+ */
+static void Measure(const Settings& settings, ThreadResult *result)
+{
+    result->tid = (pid_t)syscall(SYS_gettid);
+    result->error = PinToCpu(result->cpu);
+    if (result->error)
+        return;
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = settings.priority;
+    result->error = pthread_setschedparam(pthread_self(), settings.policy, &param);
+    if (result->error)
+        return;
+
+    CTimeSpec next = CTimeSpec::NowForClock(settings.clock) + settings.interval;
+
+    for (long i = 0; settings.loops == 0 || i < settings.loops; i++) {
+        if (stop_requested.load(std::memory_order_relaxed))
+            break;
+
+        struct timespec deadline = next.c_timespec();
+        int rc;
+        while ((rc = clock_nanosleep(settings.clock, TIMER_ABSTIME, &deadline, NULL)) == EINTR) {
+            if (stop_requested.load(std::memory_order_relaxed))
+                return;
+        }
+        if (rc != 0) {
+            result->error = rc;
+            return;
+        }
+
+        CTimeSpec now = CTimeSpec::NowForClock(settings.clock);
+        uint64_t latency = ToNs(now - next);
+
+        result->latencies.Record(latency);
+        result->last = latency;
+        result->cycles++;
+        if (settings.histogram_us > 0) {
+            uint64_t us = latency / 1000;
+            if (us < (uint64_t)settings.histogram_us)
+                result->histogram[us]++;
+            else
+                result->overflows++;
+        }
+
+        next += settings.interval;
+        while (now > next) {
+            next += settings.interval;
+            result->overruns++;
+        }
+    }
+}
+
+
+/**
+ *  The histogram in cyclictest's --histogram layout: one row per us
+ *  with a column per thread, then the summary comment lines.
+ */
+static void DumpHistogram(const std::vector<ThreadResult*>& results, int buckets)
+{
+    printf("# Histogram\n");
+    for (int us = 0; us < buckets; us++) {
+        bool any = false;
+        for (const ThreadResult *r : results)
+            any = any || r->histogram[us] != 0;
+        if (!any)
+            continue;
+        printf("%06d", us);
+        for (const ThreadResult *r : results)
+            printf(" %06llu", (unsigned long long)r->histogram[us]);
+        printf("\n");
+    }
+
+    printf("# Total:");
+    for (const ThreadResult *r : results)
+        printf(" %09llu", (unsigned long long)r->cycles);
+    printf("\n# Min Latencies:");
+    for (const ThreadResult *r : results)
+        printf(" %05llu", (unsigned long long)(r->latencies.Min() / 1000));
+    printf("\n# Avg Latencies:");
+    for (const ThreadResult *r : results)
+        printf(" %05llu", (unsigned long long)(r->latencies.Mean() / 1000));
+    printf("\n# Max Latencies:");
+    for (const ThreadResult *r : results)
+        printf(" %05llu", (unsigned long long)(r->latencies.Max() / 1000));
+    printf("\n# Histogram Overflows:");
+    for (const ThreadResult *r : results)
+        printf(" %05llu", (unsigned long long)r->overflows);
+    printf("\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    Settings settings;
+    settings.interval = CTimeSpec(0, 1000 * 1000);
+    settings.loops = 0;
+    settings.clock = CLOCK_MONOTONIC;
+    settings.policy = -1;
+    settings.priority = 0;
+    settings.histogram_us = 0;
+
+    double duration_s = 10;
+    bool lock_memory = false;
+    bool quiet = false;
+    std::vector<int> cpus;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:l:D:p:y:a:c:H:mqh")) != -1) {
+        switch (opt) {
+            case 'i': {
+                long us = atol(optarg);
+                if (us <= 0)
+                    Usage(argv[0]);
+                settings.interval = CTimeSpec((time_t)(us / US_IN_SECOND), 
+                                              (long)(us % US_IN_SECOND) * 1000);
+                break;
+            }
+            case 'l':
+                settings.loops = atol(optarg);
+                break;
+            case 'D':
+                duration_s = atof(optarg);
+                break;
+            case 'p':
+                settings.priority = atoi(optarg);
+                break;
+            case 'y':
+                if (!ParsePolicy(optarg, &settings.policy))
+                    Usage(argv[0]);
+                break;
+            case 'a':
+                if (!ParseCpuList(optarg, &cpus))
+                    Usage(argv[0]);
+                break;
+            case 'c':
+                if (strcmp(optarg, "monotonic") == 0)
+                    settings.clock = CLOCK_MONOTONIC;
+                else if (strcmp(optarg, "realtime") == 0)
+                    settings.clock = CLOCK_REALTIME;
+                else
+                    Usage(argv[0]);
+                break;
+            case 'H':
+                settings.histogram_us = atoi(optarg);
+                if (settings.histogram_us <= 0)
+                    Usage(argv[0]);
+                break;
+            case 'm':
+                lock_memory = true;
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            default:
+                Usage(argv[0]);
+        }
+    }
+    if (settings.loops < 0 || duration_s < 0 || settings.priority < 0)
+        Usage(argv[0]);
+
+    if (settings.policy < 0)
+        settings.policy = settings.priority > 0 ? SCHED_FIFO : SCHED_OTHER;
+    if ((settings.policy == SCHED_FIFO || settings.policy == SCHED_RR) && settings.priority == 0)
+        settings.priority = 1;
+    if (settings.policy != SCHED_FIFO && settings.policy != SCHED_RR)
+        settings.priority = 0;
+
+    if (cpus.empty())
+        cpus = AllowedCpus();
+    if (cpus.empty()) {
+        fprintf(stderr, "no usable CPUs\n");
+        return 1;
+    }
+
+    if (lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        fprintf(stderr, "mlockall: %s\n", strerror(errno));
+        return 1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    //
+    //  Results are allocated, histogram included, before any thread
+    //  starts, so nothing is allocated while measuring.
+    //
+    std::vector<ThreadResult*> results;
+    for (int cpu : cpus) {
+        ThreadResult *r = new ThreadResult();
+        r->cpu = cpu;
+        r->histogram.assign(settings.histogram_us > 0 ? settings.histogram_us : 0, 0);
+        results.push_back(r);
+    }
+
+    printf("# policy: %s/%d, interval: %lld us, clock: %s, threads: %zu\n", 
+           PolicyName(settings.policy), settings.priority, 
+           (long long)(ToNs(settings.interval) / 1000),
+           settings.clock == CLOCK_MONOTONIC ? "monotonic" : "realtime", results.size());
+    fflush(stdout);
+
+    std::vector<std::thread> threads;
+    for (ThreadResult *r : results)
+        threads.emplace_back(Measure, std::cref(settings), r);
+
+    if (settings.loops == 0 && duration_s > 0) {
+        CTimeSpec end = CTimeSpec::NowMonotonic() + 
+                        CTimeSpec((time_t)duration_s, (long)((duration_s - (time_t)duration_s) * NS_IN_SECOND));
+        while (!stop_requested.load() && CTimeSpec::NowMonotonic() < end)
+            usleep(10000);
+        stop_requested.store(true);
+    }
+    for (std::thread &t : threads)
+        t.join();
+
+    int status = 0;
+    for (const ThreadResult *r : results) {
+        if (r->error) {
+            fprintf(stderr, "cpu %d: %s%s\n", r->cpu, strerror(r->error), 
+                    r->error == EPERM ? " (real time policies need CAP_SYS_NICE)" : "");
+            status = 1;
+        }
+    }
+
+    if (settings.histogram_us > 0)
+        DumpHistogram(results, settings.histogram_us);
+
+    if (!quiet) {
+        for (size_t i = 0; i < results.size(); i++) {
+            const ThreadResult *r = results[i];
+            printf("T:%2zu (%6d) P:%2d I:%lld C:%8llu Min:%7llu Act:%5llu Avg:%5llu Max:%8llu\n",
+                   i, (int)r->tid, settings.priority, (long long)(ToNs(settings.interval) / 1000),
+                   (unsigned long long)r->cycles, (unsigned long long)(r->latencies.Min() / 1000),
+                   (unsigned long long)(r->last / 1000), (unsigned long long)(r->latencies.Mean() / 1000),
+                   (unsigned long long)(r->latencies.Max() / 1000));
+        }
+    }
+
+    //
+    //  Percentiles come from CLatencyHistogram buckets, so they can
+    //  read up to 6.25% high; min, avg and max are exact.
+    //
+    printf("\n%4s %5s %10s %9s %9s %9s %9s %9s %9s %9s %9s\n", 
+           "cpu", "tid", "cycles", "min us", "avg us", "p50 us", "p99 us", 
+           "p99.9 us", "p99.99 us", "max us", "overruns");
+    CLatencyHistogram all;
+    for (const ThreadResult *r : results) {
+        printf("%4d %5d %10llu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9llu\n", 
+               r->cpu, (int)r->tid, (unsigned long long)r->cycles, 
+               r->latencies.Min() / 1e3, r->latencies.Mean() / 1e3, 
+               r->latencies.Percentile(50) / 1e3, r->latencies.Percentile(99) / 1e3, 
+               r->latencies.Percentile(99.9) / 1e3, r->latencies.Percentile(99.99) / 1e3, 
+               r->latencies.Max() / 1e3, (unsigned long long)r->overruns);
+        all.Merge(r->latencies);
+    }
+    if (results.size() > 1) {
+        printf("%4s %5s %10llu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", 
+               "all", "", (unsigned long long)all.Count(), all.Min() / 1e3, all.Mean() / 1e3, 
+               all.Percentile(50) / 1e3, all.Percentile(99) / 1e3, 
+               all.Percentile(99.9) / 1e3, all.Percentile(99.99) / 1e3, all.Max() / 1e3);
+    }
+
+    for (ThreadResult *r : results)
+        delete r;
+    return status;
+}
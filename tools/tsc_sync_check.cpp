@@ -0,0 +1,149 @@
+/**
+ *  @file
+ *
+ *  Verify that the timestamp counter is synchronized across every
+ *  pair of CPUs this process may run on, and therefore that 
+ *  CTscClock (tsc_clock.hpp) can be used as a clock on this host.
+ *
+ *  For every pair of CPUs two pinned threads ping-pong through a
+ *  shared cache line and bound the counter offset between them
+ *  (see cross_core.hpp). The counter is considered safe when it is
+ *  invariant, every pair's offset window contains zero, and no 
+ *  read on one CPU was ever seen behind an earlier read on another.
+ *
+ *  Usage:
+ *  ./tsc_sync_check [-r rounds] [-t tolerance_ns]
+ *
+ *      -r  ping-pong rounds per CPU pair (default 100000)
+ *      -t  also require every offset bound to be within this many 
+ *          ns of zero (default 0, meaning only causality is checked)
+ *
+ *  Exit status is 0 when the conversion is safe, 1 when it is not,
+ *  and 2 on usage errors.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+
+#include "time_utilities.hpp"
+#include "tsc_clock.hpp"
+#include "cross_core.hpp"
+
+
+static void Usage(const char *program)
+{
+    fprintf(stderr, "usage: %s [-r rounds] [-t tolerance_ns]\n", program);
+    exit(2);
+}
+
+
+static int64_t ReadCounter()
+{
+    return (int64_t)CTscClock::Read();
+}
+
+
+int main(int argc, char **argv)
+{
+    long rounds = 100000;
+    double tolerance_ns = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:t:h")) != -1) {
+        switch (opt) {
+            case 'r':
+                rounds = atol(optarg);
+                break;
+            case 't':
+                tolerance_ns = atof(optarg);
+                break;
+            default:
+                Usage(argv[0]);
+        }
+    }
+    if (rounds <= 0 || tolerance_ns < 0)
+        Usage(argv[0]);
+
+    if (!CTscClock::Supported()) {
+        printf("no hardware counter on this architecture: UNSAFE\n");
+        return 1;
+    }
+
+    const CTscClock &tsc = CTscClock::Instance();
+    double ns_per_tick = NS_IN_SECOND / tsc.TicksPerSecond();
+    bool invariant = CTscClock::Invariant();
+    bool safe = invariant;
+
+    printf("counter: %.3f MHz, invariant: %s\n", 
+           tsc.TicksPerSecond() / 1e6, invariant ? "yes" : "no");
+
+    std::vector<int> cpus = AllowedCpus();
+    if (cpus.size() < 2) {
+        printf("only %zu CPU available, nothing to compare\n", cpus.size());
+    }
+    else {
+        printf("\n%5s %5s %14s %14s %10s %10s\n", 
+               "cpu", "cpu", "offset min ns", "offset max ns", "rtt ns", "backwards");
+    }
+
+    double worst_offset = 0;
+
+    for (size_t i = 0; i < cpus.size(); i++) {
+        for (size_t j = i + 1; j < cpus.size(); j++) {
+            CrossCoreResult r = MeasureCrossCore(cpus[i], cpus[j], rounds, ReadCounter);
+            double lo = r.offset_min * ns_per_tick;
+            double hi = r.offset_max * ns_per_tick;
+            bool pair_ok = r.Synchronized() && r.violations == 0;
+
+            if (tolerance_ns > 0 && (lo < -tolerance_ns || hi > tolerance_ns))
+                pair_ok = false;
+
+            printf("%5d %5d %14.1f %14.1f %10.1f %10llu%s\n", 
+                   cpus[i], cpus[j], lo, hi, r.round_trip_min * ns_per_tick,
+                   (unsigned long long)r.violations, pair_ok ? "" : "  <-- out of sync");
+
+            if (!pair_ok)
+                safe = false;
+
+            //
+            //  The true offset is somewhere in [lo, hi], the largest
+            //  possible magnitude is what bounds the error of 
+            //  comparing counter values taken on different CPUs.
+            //
+            double magnitude = std::max(-lo, hi);
+            if (magnitude > worst_offset)
+                worst_offset = magnitude;
+        }
+    }
+
+    if (cpus.size() >= 2)
+        printf("\nworst case cross-CPU offset: %.1f ns\n", worst_offset);
+
+    printf("TSC to CTimeSpec conversion: %s\n", safe ? "SAFE" : "UNSAFE");
+    return safe ? 0 : 1;
+}
@@ -0,0 +1,238 @@
+/**
+ *  @file
+ *
+ *  Reading the CPU timestamp counter and converting it to CTimeSpec.
+ *
+ *  On x86 this is the TSC, on aarch64 the generic timer's virtual 
+ *  count. Anywhere else the class falls back to CLOCK_MONOTONIC_RAW
+ *  in nanoseconds, so code using it still works, just not faster.
+ *
+ *  Converted times are on the CLOCK_MONOTONIC_RAW time line: the 
+ *  counter is calibrated against that clock once, and ticks are 
+ *  turned into nanoseconds with a 32.32 fixed point multiply, the 
+ *  same way the kernel does it for its clocksources.
+ *
+ *  The counter is only a usable clock if it is invariant (constant 
+ *  rate in all P and C states) and synchronized between CPUs. The 
+ *  former is checked by Invariant(), the latter cannot be checked 
+ *  cheaply at run time, use tools/tsc_sync_check on the host.
+ *
+ *  This header requires C++11 support.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef TSC_CLOCK_HPP__
+#define TSC_CLOCK_HPP__
+
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+
+#include "time_utilities.hpp"
+
+
+/**
+ *  Calibrated timestamp counter.
+ */
+class CTscClock
+{
+    public:
+
+        /**
+         *  ctor - calibrates the counter against CLOCK_MONOTONIC_RAW.
+         *  @param calibration_ms how long to calibrate for. Longer is 
+         *  more accurate, the error is roughly 50ns / calibration time.
+         */
+        explicit CTscClock(unsigned int calibration_ms = 20)
+        {
+            uint64_t start_ticks = 0, end_ticks = 0;
+            CTimeSpec start = Sample(&start_ticks);
+            CTimeSpec end;
+
+            do {
+                end = Sample(&end_ticks);
+            } while (end - start < CTimeSpec(calibration_ms));
+
+            struct timespec elapsed = (end - start).c_timespec();
+            uint64_t elapsed_ns = (uint64_t)elapsed.tv_sec * NS_IN_SECOND + elapsed.tv_nsec;
+
+            ticks_per_second = (double)(end_ticks - start_ticks) * NS_IN_SECOND / elapsed_ns;
+            mult = (uint64_t)(((unsigned __int128)elapsed_ns << 32) / (end_ticks - start_ticks));
+            base_ticks = end_ticks;
+            base = end;
+        }
+
+        /**
+         *  The clock shared by the whole process, calibrated the 
+         *  first time it is asked for.
+         */
+        static const CTscClock& Instance()
+        {
+            static const CTscClock instance;
+            return instance;
+        }
+
+        /**
+         *  True if Read() uses a hardware counter rather than 
+         *  falling back to clock_gettime().
+         */
+        static bool Supported()
+        {
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /**
+         *  True if the counter runs at a constant rate regardless of
+         *  frequency scaling and sleep states. On x86 this is CPUID 
+         *  leaf 0x80000007 EDX bit 8, the aarch64 generic timer is 
+         *  architecturally constant rate.
+         */
+        static bool Invariant()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            unsigned int eax, ebx, ecx, edx;
+            if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+                return false;
+            return (edx & (1u << 8)) != 0;
+#elif defined(__aarch64__)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /**
+         *  Current raw counter value. Not ordered with respect to 
+         *  surrounding loads and stores.
+         */
+        static uint64_t Read()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#elif defined(__aarch64__)
+            uint64_t ticks;
+            __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+            return ticks;
+#else
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+            return (uint64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+#endif
+        }
+
+        /**
+         *  Counter frequency measured during calibration.
+         */
+        double TicksPerSecond() const
+        {
+            return ticks_per_second;
+        }
+
+        /**
+         *  Convert a tick count into a duration.
+         */
+        CTimeSpec TicksToDuration(uint64_t ticks) const
+        {
+            uint64_t ns = (uint64_t)(((unsigned __int128)ticks * mult) >> 32);
+            return CTimeSpec((time_t)(ns / NS_IN_SECOND), (long)(ns % NS_IN_SECOND));
+        }
+
+        /**
+         *  Convert a non negative duration into a tick count.
+         */
+        uint64_t DurationToTicks(const CTimeSpec& duration) const
+        {
+            struct timespec ts = duration.c_timespec();
+            unsigned __int128 ns = (unsigned __int128)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+            return (uint64_t)((ns << 32) / mult);
+        }
+
+        /**
+         *  Convert a counter value into a CLOCK_MONOTONIC_RAW time.
+         */
+        CTimeSpec ToTimeSpec(uint64_t ticks) const
+        {
+            if (ticks >= base_ticks)
+                return base + TicksToDuration(ticks - base_ticks);
+            else
+                return base - TicksToDuration(base_ticks - ticks);
+        }
+
+        /**
+         *  "now" on the CLOCK_MONOTONIC_RAW time line, read from 
+         *  the counter.
+         */
+        CTimeSpec Now() const
+        {
+            return ToTimeSpec(Read());
+        }
+
+    private:
+        /**
+         *  Read CLOCK_MONOTONIC_RAW and the counter as close together 
+         *  as possible: bracket the clock read with counter reads, 
+         *  keep the tightest of a few tries, and use its midpoint.
+         */
+        static CTimeSpec Sample(uint64_t *ticks)
+        {
+            uint64_t best_gap = UINT64_MAX;
+            CTimeSpec best;
+
+            for (int i = 0; i < 5; i++) {
+                uint64_t before = Read();
+                CTimeSpec now = CTimeSpec::NowMonotonicRaw();
+                uint64_t after = Read();
+                if (after - before < best_gap) {
+                    best_gap = after - before;
+                    best = now;
+                    *ticks = before + (after - before) / 2;
+                }
+            }
+            return best;
+        }
+
+        /**
+         *  Nanoseconds per tick, 32.32 fixed point.
+         */
+        uint64_t mult;
+
+        /**
+         *  A counter value and the CLOCK_MONOTONIC_RAW time it 
+         *  corresponds to.
+         */
+        uint64_t base_ticks;
+        CTimeSpec base;
+
+        double ticks_per_second;
+};
+
+
+#endif
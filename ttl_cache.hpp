@@ -0,0 +1,457 @@
+/**
+ *  @file
+ *
+ *  Hash map whose entries expire, with expiry spread over the 
+ *  operations instead of done in one stop the world sweep.
+ *
+ *  Three mechanisms, cheapest first:
+ *  - Lazy: Get() never returns an expired entry, and erases it.
+ *  - Queues: every Put() files the key under the time bucket it 
+ *    expires in, on a ring of queues. Each operation then works off
+ *    a few keys from the buckets that are due (the sweep budget), so
+ *    memory is reclaimed at the rate entries expire, without a pause.
+ *  - Sampling: optionally, each Put() also looks at a few entries at
+ *    random and erases the expired ones, which catches up while the 
+ *    queues lag behind a burst of expiries.
+ *
+ *  Entries expire at ttl after their Put(). Time comes from the 
+ *  caller or, by default, from CLOCK_MONOTONIC_COARSE: a few ns to 
+ *  read, and ticking at the scheduler rate, which is plenty for TTLs.
+ *
+ *  Not thread safe.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef TTL_CACHE_HPP__
+#define TTL_CACHE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "time_utilities.hpp"
+
+
+/**
+ *  Counters of what a CTtlCache has done.
+ */
+struct CTtlCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t puts = 0;
+
+    /**
+     *  Expired entries erased by Get(), by the queue sweep and by
+     *  sampling.
+     */
+    uint64_t expired_on_access = 0;
+    uint64_t expired_by_sweep = 0;
+    uint64_t expired_by_sample = 0;
+
+    /**
+     *  Queued keys the sweep found already overwritten or erased,
+     *  and keys put back because their expiry was beyond the ring.
+     */
+    uint64_t stale = 0;
+    uint64_t requeued = 0;
+};
+
+
+template <typename Key, typename Value, typename Hash = std::hash<Key> >
+class CTtlCache
+{
+    public:
+
+        /**
+         *  @param granularity width of a queue's time bucket, > 0. 
+         *  Entries are reclaimed by the sweep up to this late.
+         *  @param num_queues queues on the ring; TTLs beyond 
+         *  granularity * num_queues are queued again on the way.
+         */
+        explicit CTtlCache(const CTimeSpec& granularity = CTimeSpec(0, 10 * NS_IN_MS), 
+                           size_t num_queues = 1024)
+            : granularity_ns(ToNs(granularity) > 0 ? ToNs(granularity) : 1), 
+              queues(num_queues ? num_queues : 1), cursor(INT64_MIN), queued(0), 
+              sweep_budget(4), sample_count(0), rng(0x9e3779b97f4a7c15ULL)
+        {
+        }
+
+        /**
+         *  Queued keys (or empty buckets) each operation works off.
+         *  0 leaves reclaiming to Get() and Expire().
+         */
+        void SetSweepBudget(size_t keys)
+        {
+            sweep_budget = keys;
+        }
+
+        /**
+         *  Entries each Put() samples at random, 0 (the default) 
+         *  for none.
+         */
+        void SetSampleCount(size_t entries)
+        {
+            sample_count = entries;
+        }
+
+        /**
+         *  Size the table for entries up front, so inserts never pay
+         *  for a rehash.
+         */
+        void Reserve(size_t entries)
+        {
+            map.reserve(entries);
+        }
+
+        /**
+         *  Insert or replace an entry.
+         *  @param ttl how long from now the entry lives.
+         */
+        void Put(const Key& key, const Value& value, const CTimeSpec& ttl, const CTimeSpec& now)
+        {
+            int64_t now_ns = ToNs(now);
+            Sweep(now_ns, sweep_budget);
+
+            Entry &entry = map[key];
+            entry.value = value;
+            entry.expires = now_ns + ToNs(ttl);
+            int64_t tick = QueueTick(entry.expires);
+            if (entry.queued_tick != tick) {
+                entry.queued_tick = tick;
+                queues[Slot(tick)].push_back(key);
+                queued++;
+            }
+            stats.puts++;
+
+            if (sample_count)
+                Sample(now_ns);
+        }
+
+        void Put(const Key& key, const Value& value, const CTimeSpec& ttl)
+        {
+            Put(key, value, ttl, Now());
+        }
+
+        /**
+         *  Look an entry up.
+         *  @return false, leaving value alone, if there is no entry
+         *  or it has expired.
+         */
+        bool Get(const Key& key, Value *value, const CTimeSpec& now)
+        {
+            int64_t now_ns = ToNs(now);
+            Sweep(now_ns, sweep_budget);
+
+            typename Map::iterator it = map.find(key);
+            if (it == map.end()) {
+                stats.misses++;
+                return false;
+            }
+            if (it->second.expires <= now_ns) {
+                map.erase(it);
+                stats.expired_on_access++;
+                stats.misses++;
+                return false;
+            }
+            *value = it->second.value;
+            stats.hits++;
+            return true;
+        }
+
+        bool Get(const Key& key, Value *value)
+        {
+            return Get(key, value, Now());
+        }
+
+        /**
+         *  @return false if there was no entry, expired or not.
+         */
+        bool Erase(const Key& key)
+        {
+            return map.erase(key) != 0;
+        }
+
+        /**
+         *  Work off due queued keys outside of Put() and Get(), e.g.
+         *  when idle.
+         *  @param budget most keys (or empty buckets) to look at.
+         *  @return entries expired.
+         */
+        size_t Expire(const CTimeSpec& now, size_t budget)
+        {
+            uint64_t before = stats.expired_by_sweep;
+            Sweep(ToNs(now), budget);
+            return (size_t)(stats.expired_by_sweep - before);
+        }
+
+        /**
+         *  Entries held, including expired ones not yet reclaimed.
+         */
+        size_t Size() const
+        {
+            return map.size();
+        }
+
+        /**
+         *  Keys waiting on the queues, including stale ones.
+         */
+        size_t Queued() const
+        {
+            return queued;
+        }
+
+        /**
+         *  How far the sweep is behind now; more than a granularity
+         *  or two means the budget is too small for the expiry rate.
+         */
+        CTimeSpec SweepLag(const CTimeSpec& now) const
+        {
+            if (cursor == INT64_MIN)
+                return CTimeSpec(0, 0);
+            int64_t lag = ToNs(now) - cursor * granularity_ns;
+            if (lag < 0)
+                lag = 0;
+            return CTimeSpec((time_t)(lag / NS_IN_SECOND), (long)(lag % NS_IN_SECOND));
+        }
+
+        const CTtlCacheStats& Stats() const
+        {
+            return stats;
+        }
+
+        void ResetStats()
+        {
+            stats = CTtlCacheStats();
+        }
+
+        void Clear()
+        {
+            map.clear();
+            for (std::deque<Key> &queue : queues)
+                queue.clear();
+            deferred.clear();
+            queued = 0;
+            cursor = INT64_MIN;
+        }
+
+        /**
+         *  The clock used when no time is passed.
+         */
+        static CTimeSpec Now()
+        {
+#ifdef CLOCK_MONOTONIC_COARSE
+            return CTimeSpec::NowForClock(CLOCK_MONOTONIC_COARSE);
+#else
+            return CTimeSpec::NowMonotonic();
+#endif
+        }
+
+    private:
+
+        struct Entry
+        {
+            Value value;
+            int64_t expires = 0;
+
+            /**
+             *  Tick of the queue holding the live copy of the key.
+             */
+            int64_t queued_tick = INT64_MIN;
+        };
+
+        typedef std::unordered_map<Key, Entry, Hash> Map;
+
+        static int64_t ToNs(const CTimeSpec& value)
+        {
+            struct timespec ts = value.c_timespec();
+            return (int64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+        }
+
+        int64_t FloorTick(int64_t ns) const
+        {
+            int64_t tick = ns / granularity_ns;
+            return (ns % granularity_ns < 0) ? tick - 1 : tick;
+        }
+
+        size_t Slot(int64_t tick) const
+        {
+            int64_t slot = tick % (int64_t)queues.size();
+            return (size_t)(slot < 0 ? slot + (int64_t)queues.size() : slot);
+        }
+
+        /**
+         *  Queue for an expiry time: the first bucket starting at or
+         *  after it, kept within one turn of the ring from the cursor.
+         */
+        int64_t QueueTick(int64_t expires) const
+        {
+            int64_t tick = FloorTick(expires);
+            if (tick * granularity_ns < expires)
+                tick++;
+            if (tick < cursor)
+                tick = cursor;
+            if (tick - cursor >= (int64_t)queues.size())
+                tick = cursor + (int64_t)queues.size() - 1;
+            return tick;
+        }
+
+        /**
+         *  Work through due buckets, at most budget keys or empty 
+         *  buckets. The queue of bucket t is due once now reaches
+         *  the start of t, when everything filed under it expired.
+         */
+        void Sweep(int64_t now_ns, size_t budget)
+        {
+            int64_t now_tick = FloorTick(now_ns);
+            if (cursor == INT64_MIN || queued == 0) {
+                if (cursor < now_tick)
+                    cursor = now_tick;
+                return;
+            }
+
+            //
+            //  A whole turn of the ring or more behind, everything 
+            //  queued is due: sweep one turn ending at now instead 
+            //  of every empty bucket in between.
+            //
+            if (now_tick - cursor >= (int64_t)queues.size())
+                cursor = now_tick - (int64_t)queues.size() + 1;
+
+            while (budget && cursor <= now_tick) {
+                std::deque<Key> &queue = queues[Slot(cursor)];
+                if (queue.empty()) {
+                    cursor++;
+                    budget--;
+                    if (!deferred.empty()) {
+                        std::deque<Key> &next = queues[Slot(cursor)];
+                        next.insert(next.end(), deferred.begin(), deferred.end());
+                        deferred.clear();
+                    }
+                    continue;
+                }
+                for (; budget && !queue.empty(); budget--) {
+                    Key key = queue.back();
+                    queue.pop_back();
+                    queued--;
+                    Reap(key, now_ns);
+                }
+            }
+        }
+
+        /**
+         *  Handle a key taken off the queue of the bucket at cursor.
+         */
+        void Reap(const Key& key, int64_t now_ns)
+        {
+            typename Map::iterator it = map.find(key);
+            if (it == map.end()) {
+                stats.stale++;
+                return;
+            }
+
+            Entry &entry = it->second;
+            if (entry.expires <= now_ns) {
+                map.erase(it);
+                stats.expired_by_sweep++;
+            } else if (entry.queued_tick <= cursor && Slot(entry.queued_tick) == Slot(cursor)) {
+                //
+                //  The live copy (filed at or, after a catch up, 
+                //  before the cursor), expiring beyond the ring, so 
+                //  file it further on.
+                //
+                int64_t tick = QueueTick(entry.expires);
+                if (tick == cursor)
+                    tick++;
+                entry.queued_tick = tick;
+                if (Slot(tick) == Slot(cursor))
+                    deferred.push_back(key);
+                else
+                    queues[Slot(tick)].push_back(key);
+                queued++;
+                stats.requeued++;
+            } else {
+                stats.stale++;
+            }
+        }
+
+        /**
+         *  Look at sample_count entries from a random hash bucket on,
+         *  visiting at most 4 * sample_count buckets so a table left
+         *  sparse by a burst of expiries costs no more.
+         */
+        void Sample(int64_t now_ns)
+        {
+            size_t buckets = map.bucket_count();
+            size_t visits = 4 * sample_count < buckets ? 4 * sample_count : buckets;
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+
+            size_t seen = 0;
+            for (size_t i = 0; i < visits && seen < sample_count; i++) {
+                size_t bucket = (size_t)((rng + i) % buckets);
+                typename Map::local_iterator it = map.begin(bucket);
+                while (it != map.end(bucket) && seen < sample_count) {
+                    seen++;
+                    if (it->second.expires <= now_ns) {
+                        Key key = it->first;
+                        ++it;
+                        map.erase(key);
+                        stats.expired_by_sample++;
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+        }
+
+        int64_t granularity_ns;
+        Map map;
+
+        /**
+         *  Ring of queues of keys, one per bucket of granularity_ns,
+         *  and the bucket the sweep is at. Deques, so a busy bucket 
+         *  grows a block at a time instead of copying itself.
+         */
+        std::vector<std::deque<Key> > queues;
+
+        /**
+         *  Keys requeued onto the bucket being swept, which only a 
+         *  one queue ring does; they join it once the cursor moves.
+         */
+        std::deque<Key> deferred;
+        int64_t cursor;
+        size_t queued;
+
+        size_t sweep_budget;
+        size_t sample_count;
+        uint64_t rng;
+        CTtlCacheStats stats;
+};
+
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ *  @file
+ *
+ *  Unit test code of busy_delay.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_busy_delay.cpp -o unit_test_busy_delay
+ *
+ *  To test:
+ *  ./unit_test_busy_delay
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+
+#include "time_utilities.hpp"
+#include "busy_delay.hpp"
+
+
+static uint64_t ElapsedNs(const CTimeSpec& start)
+{
+    struct timespec ts = (CTimeSpec::NowMonotonicRaw() - start).c_timespec();
+    return (uint64_t)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+}
+
+
+/**
+ *  Delays are never short, and the best of a few tries is close;
+ *  the slack allows for an interrupt or a preemption on a busy 
+ *  test machine.
+ */
+static void CheckDelays(const CBusyDelay& delay)
+{
+    const uint64_t delays[] = {1000, 10000, 100000, 1000000};
+
+    assert(delay.ReadCostNs() > 0);
+
+    for (uint64_t ns : delays) {
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < 20; i++) {
+            CTimeSpec start = CTimeSpec::NowMonotonicRaw();
+            delay.DelayNs(ns);
+            uint64_t elapsed = ElapsedNs(start);
+            assert(elapsed + 50 >= ns);
+            if (elapsed < best)
+                best = elapsed;
+        }
+        assert(best < ns + ns / 10 + 5000);
+
+        CTimeSpec start = CTimeSpec::NowMonotonicRaw();
+        delay.DelayFor(CTimeSpec(0, (long)ns));
+        assert(ElapsedNs(start) + 50 >= ns);
+    }
+
+    //
+    //  Nothing to wait for.
+    //
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 20; i++) {
+        CTimeSpec start = CTimeSpec::NowMonotonicRaw();
+        delay.DelayFor(CTimeSpec(-1, 0));
+        delay.DelayFor(CTimeSpec(0, 0));
+        delay.DelayNs(0);
+        uint64_t elapsed = ElapsedNs(start);
+        if (elapsed < best)
+            best = elapsed;
+    }
+    assert(best < 5000);
+}
+
+
+int main()
+{
+    std::cout << "Unit testing busy_delay.hpp" << std::endl;
+
+    const CBusyDelay &shared = CBusyDelay::Instance();
+    assert(&shared == &CBusyDelay::Instance());
+    CheckDelays(shared);
+
+    CBusyDelay raw(false);
+    assert(!raw.UsesTsc());
+    CheckDelays(raw);
+
+    CBusyDelay::Pause();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
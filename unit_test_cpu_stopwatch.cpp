@@ -0,0 +1,134 @@
+/**
+ *  @file
+ *
+ *  Unit test code of cpu_stopwatch.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_cpu_stopwatch.cpp -o unit_test_cpu_stopwatch
+ *
+ *  To test:
+ *  ./unit_test_cpu_stopwatch
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+#include <ctime>
+
+#include "time_utilities.hpp"
+#include "cpu_stopwatch.hpp"
+
+
+static void BurnCpu(unsigned int ms)
+{
+    CTimeSpec end = CTimeSpec::NowThreadCpu() + CTimeSpec(ms);
+    volatile unsigned long sink = 0;
+
+    while (CTimeSpec::NowThreadCpu() < end) {
+        sink = sink + 1;
+    }
+}
+
+
+static void Sleep(unsigned int ms)
+{
+    struct timespec ts = CTimeSpec(ms).c_timespec();
+    while (nanosleep(&ts, &ts) != 0)
+        ;
+}
+
+
+void TestBusy()
+{
+    CCpuStopwatch stopwatch;
+    BurnCpu(30);
+    CCpuTimes times = stopwatch.Elapsed();
+
+    std::cout << "busy:  wall " << times.wall << " cpu " << times.cpu << std::endl;
+    assert(times.cpu >= CTimeSpec(30));
+    assert(times.wall >= times.cpu);
+}
+
+
+void TestSleeping()
+{
+    CCpuStopwatch stopwatch;
+    Sleep(50);
+    CCpuTimes times = stopwatch.Elapsed();
+
+    std::cout << "sleep: wall " << times.wall << " cpu " << times.cpu << std::endl;
+    assert(times.wall >= CTimeSpec(50));
+    assert(times.cpu < CTimeSpec(10));
+    assert(times.OffCpu() >= CTimeSpec(40));
+}
+
+
+void TestRestart()
+{
+    CCpuStopwatch stopwatch;
+    Sleep(20);
+    stopwatch.Restart();
+    assert(stopwatch.Wall() < CTimeSpec(20));
+}
+
+
+void TestScoped()
+{
+    CCpuTimes total;
+
+    for (int i = 0; i < 3; i++) {
+        CScopedCpuStopwatch scope {total};
+        BurnCpu(10);
+        Sleep(10);
+    }
+
+    std::cout << "scoped: wall " << total.wall << " cpu " << total.cpu << std::endl;
+    assert(total.cpu >= CTimeSpec(30));
+    assert(total.wall >= CTimeSpec(60));
+    assert(total.OffCpu() >= CTimeSpec(20));
+}
+
+
+void TestOffCpuClamped()
+{
+    CCpuTimes times;
+    times.wall = CTimeSpec(0, 10);
+    times.cpu = CTimeSpec(0, 20);
+    assert(times.OffCpu() == CTimeSpec());
+}
+
+
+int main()
+{
+    std::cout << "Unit testing cpu_stopwatch.hpp" << std::endl;
+
+    TestBusy();
+    TestSleeping();
+    TestRestart();
+    TestScoped();
+    TestOffCpuClamped();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ *  @file
+ *
+ *  Unit test code of fixed_timestep.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_fixed_timestep.cpp -o unit_test_fixed_timestep
+ *
+ *  To test:
+ *  ./unit_test_fixed_timestep
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+
+#include "time_utilities.hpp"
+#include "fixed_timestep.hpp"
+
+
+static CTimeSpec Ms(int64_t ms)
+{
+    return CTimeSpec((time_t)(ms / 1000), (long)(ms % 1000) * 1000000L);
+}
+
+
+void TestSteps()
+{
+    CFixedTimestep timestep(Ms(10));
+    assert(timestep.Valid());
+    assert(timestep.Step() == Ms(10));
+
+    assert(timestep.Frame(Ms(1000)) == 0);
+    assert(timestep.Frames() == 0);
+
+    assert(timestep.Frame(Ms(1010)) == 1);
+    assert(timestep.Alpha() == 0);
+
+    //
+    //  15ms frames: 1, 2, 1, 2 updates, alpha 0.5, 0, 0.5, 0.
+    //
+    assert(timestep.Frame(Ms(1025)) == 1 && timestep.Alpha() == 0.5);
+    assert(timestep.Frame(Ms(1040)) == 2 && timestep.Alpha() == 0);
+    assert(timestep.Frame(Ms(1055)) == 1 && timestep.Remainder() == Ms(5));
+    assert(timestep.Frame(Ms(1070)) == 2 && timestep.Remainder() == Ms(0));
+
+    //
+    //  Short frames only accumulate.
+    //
+    assert(timestep.Frame(Ms(1073)) == 0 && timestep.Remainder() == Ms(3));
+    assert(timestep.Frame(Ms(1079)) == 0 && timestep.Remainder() == Ms(9));
+    assert(timestep.Frame(Ms(1080)) == 1 && timestep.Alpha() == 0);
+
+    assert(timestep.Steps() == 8 && timestep.Frames() == 8);
+    assert(timestep.SimulatedTime() == Ms(80));
+    assert(timestep.FrameTimes().Count() == 8);
+    assert(timestep.FrameTimes().Max() == 15 * NS_IN_MS);
+
+    //
+    //  A clock going backwards is a zero length frame.
+    //
+    assert(timestep.Frame(Ms(1000)) == 0 && timestep.Remainder() == Ms(0));
+    assert(timestep.Frame(Ms(1010)) == 1);
+}
+
+
+/**
+ *  Integer accumulation: after any number of frames, simulated time
+ *  plus the remainder is exactly the real time elapsed.
+ */
+void TestNoDrift()
+{
+    //
+    //  A 60 Hz step that is not a whole number of ns, rounded, fed 
+    //  with frames of a 144 Hz display.
+    //
+    CTimeSpec step(0, 16666667);
+    CFixedTimestep timestep(step);
+    const int64_t frame_ns = 6944444;
+    int64_t now = 0;
+
+    timestep.Frame(CTimeSpec(0, 0));
+    for (int i = 0; i < 1000000; i++) {
+        now += frame_ns + (i % 3);
+        timestep.Frame(CTimeSpec((time_t)(now / NS_IN_SECOND), (long)(now % NS_IN_SECOND)));
+        assert(timestep.Alpha() >= 0 && timestep.Alpha() < 1);
+    }
+
+    assert(timestep.SimulatedTime() + timestep.Remainder() == 
+           CTimeSpec((time_t)(now / NS_IN_SECOND), (long)(now % NS_IN_SECOND)));
+    assert(timestep.SimulatedTime() == 
+           CTimeSpec((time_t)((int64_t)timestep.Steps() * 16666667 / NS_IN_SECOND), 
+                     (long)((int64_t)timestep.Steps() * 16666667 % NS_IN_SECOND)));
+    assert(timestep.DroppedSteps() == 0 && timestep.ClampedFrames() == 0);
+}
+
+
+void TestOverload()
+{
+    //
+    //  Default clamp is max_steps steps: an 80ms stall runs 5.
+    //
+    CFixedTimestep clamped(Ms(10), 5);
+    clamped.Frame(Ms(0));
+    assert(clamped.Frame(Ms(83)) == 5);
+    assert(clamped.ClampedFrames() == 1 && clamped.DroppedSteps() == 0);
+    assert(clamped.Remainder() == Ms(0));
+    assert(clamped.FrameTimes().Max() == 83 * NS_IN_MS);
+
+    //
+    //  With a longer clamp the steps beyond max_steps are dropped,
+    //  the fraction of a step is kept.
+    //
+    CFixedTimestep dropping(Ms(10), 5, Ms(1000));
+    dropping.Frame(Ms(0));
+    assert(dropping.Frame(Ms(83)) == 5);
+    assert(dropping.DroppedSteps() == 3 && dropping.ClampedFrames() == 0);
+    assert(dropping.Remainder() == Ms(3));
+    assert(dropping.Frame(Ms(2000)) == 5);
+    assert(dropping.ClampedFrames() == 1 && dropping.DroppedSteps() == 3 + 95);
+
+    //
+    //  Sustained overload: every frame takes 25ms of 10ms steps at 
+    //  most 2 per frame; the loop stays at 2 instead of growing.
+    //
+    CFixedTimestep sustained(Ms(10), 2, Ms(1000));
+    sustained.Frame(Ms(0));
+    for (int i = 1; i <= 100; i++)
+        assert(sustained.Frame(Ms(25 * i)) == 2);
+    assert(sustained.DroppedSteps() == 50);
+}
+
+
+void TestRun()
+{
+    CFixedTimestep timestep(Ms(20));
+    int updates = 0;
+    CTimeSpec simulated(0, 0);
+    auto update = [&](const CTimeSpec& dt) { updates++; simulated += dt; };
+
+    assert(timestep.Run(Ms(0), update) == 0);
+    assert(timestep.Run(Ms(50), update) == 2);
+    assert(updates == 2 && simulated == Ms(40) && timestep.Alpha() == 0.5);
+
+    timestep.Reset();
+    assert(timestep.Steps() == 0 && timestep.FrameTimes().Count() == 0);
+    assert(timestep.Run(Ms(100), update) == 0);
+    assert(timestep.Run(Ms(120), update) == 1);
+
+    CFixedTimestep invalid(CTimeSpec(0, 0));
+    assert(!invalid.Valid());
+    assert(invalid.Frame(Ms(0)) == 0 && invalid.Frame(Ms(100)) == 0);
+}
+
+
+int main()
+{
+    std::cout << "Unit testing fixed_timestep.hpp" << std::endl;
+
+    TestSteps();
+    TestNoDrift();
+    TestOverload();
+    TestRun();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,167 @@
+/**
+ *  @file
+ *
+ *  Unit test code of latency_histogram.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 -pthread unit_test_latency_histogram.cpp -o unit_test_latency_histogram
+ *
+ *  To test:
+ *  ./unit_test_latency_histogram
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "time_utilities.hpp"
+#include "latency_histogram.hpp"
+
+
+void TestBuckets()
+{
+    //
+    //  Buckets tile the whole range with no gaps or overlaps.
+    //
+    assert(CLatencyHistogram::BucketLower(0) == 0);
+    for (int i = 1; i < CLatencyHistogram::NUM_BUCKETS; i++) {
+        assert(CLatencyHistogram::BucketLower(i) == CLatencyHistogram::BucketUpper(i - 1) + 1);
+    }
+    assert(CLatencyHistogram::BucketUpper(CLatencyHistogram::NUM_BUCKETS - 1) == UINT64_MAX);
+
+    uint64_t values[] = {0, 1, 15, 16, 17, 31, 32, 33, 1000, 999999, 
+                         1000000000ULL, 0x8000000000000000ULL, UINT64_MAX};
+    for (uint64_t v : values) {
+        int i = CLatencyHistogram::BucketIndex(v);
+        assert(CLatencyHistogram::BucketLower(i) <= v);
+        assert(CLatencyHistogram::BucketUpper(i) >= v);
+        //
+        //  Relative width of a bucket is at most 1/16.
+        //
+        uint64_t width = CLatencyHistogram::BucketUpper(i) - CLatencyHistogram::BucketLower(i);
+        assert(width <= v / 16);
+    }
+}
+
+
+void TestStatistics()
+{
+    CLatencyHistogram h;
+
+    assert(h.Count() == 0);
+    assert(h.Min() == 0 && h.Max() == 0 && h.Mean() == 0);
+    assert(h.Percentile(50) == 0);
+
+    for (uint64_t v = 1; v <= 1000; v++) {
+        h.Record(v * 1000);
+    }
+
+    assert(h.Count() == 1000);
+    assert(h.Min() == 1000);
+    assert(h.Max() == 1000000);
+    assert(h.Mean() == 500500);
+
+    uint64_t p50 = h.Percentile(50);
+    uint64_t p99 = h.Percentile(99);
+    assert(p50 >= 500000 && p50 <= 500000 + 500000 / 16);
+    assert(p99 >= 990000 && p99 <= 1000000);
+    assert(h.Percentile(100) == 1000000);
+    assert(h.Percentile(0) <= 1000 + 1000 / 16);
+
+    h.Reset();
+    assert(h.Count() == 0);
+    assert(h.Max() == 0);
+}
+
+
+void TestDurations()
+{
+    CLatencyHistogram h;
+
+    h.Record(CTimeSpec(1, 500));
+    h.Record(CTimeSpec(-1, 0));
+    assert(h.Count() == 2);
+    assert(h.Min() == 0);
+    assert(h.Max() == 1000000500ULL);
+}
+
+
+void TestMerge()
+{
+    CLatencyHistogram a, b;
+
+    a.Record(10);
+    a.Record(20);
+    b.Record(5);
+    b.Record(5000);
+
+    a.Merge(b);
+    assert(a.Count() == 4);
+    assert(a.Min() == 5);
+    assert(a.Max() == 5000);
+    assert(a.Sum() == 5035);
+}
+
+
+void TestConcurrent()
+{
+    CLatencyHistogram h;
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&h, t]() {
+            for (int i = 0; i < 100000; i++)
+                h.Record((uint64_t)(t * 100000 + i));
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    assert(h.Count() == 400000);
+    assert(h.Min() == 0);
+    assert(h.Max() == 399999);
+
+    uint64_t total = 0;
+    for (int i = 0; i < CLatencyHistogram::NUM_BUCKETS; i++)
+        total += h.BucketCount(i);
+    assert(total == 400000);
+}
+
+
+int main()
+{
+    std::cout << "Unit testing latency_histogram.hpp" << std::endl;
+
+    TestBuckets();
+    TestStatistics();
+    TestDurations();
+    TestMerge();
+    TestConcurrent();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
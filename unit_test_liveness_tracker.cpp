@@ -0,0 +1,234 @@
+/**
+ *  @file
+ *
+ *  Unit test code of liveness_tracker.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_liveness_tracker.cpp -o unit_test_liveness_tracker
+ *
+ *  To test:
+ *  ./unit_test_liveness_tracker
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+
+#include "time_utilities.hpp"
+#include "liveness_tracker.hpp"
+
+
+static CTimeSpec Ms(int64_t ms)
+{
+    return CTimeSpec((time_t)(ms / 1000), (long)(ms % 1000) * 1000000L);
+}
+
+
+/**
+ *  Collects what a sweep expired.
+ */
+struct Collect
+{
+    std::vector<uint32_t> *ids;
+
+    void operator()(uint32_t id)
+    {
+        ids->push_back(id);
+    }
+};
+
+
+void TestBasics()
+{
+    //
+    //  One second timeout, 100ms buckets.
+    //
+    CLivenessTracker tracker(10, Ms(1000), Ms(100));
+    std::vector<uint32_t> expired;
+    Collect collect {&expired};
+
+    assert(tracker.Valid());
+    assert(tracker.Capacity() == 10 && tracker.Size() == 0);
+    assert(!tracker.Touch(10, Ms(0)));
+    assert(!tracker.Tracked(10));
+
+    assert(tracker.Touch(1, Ms(10050)));
+    assert(tracker.Touch(2, Ms(10050)));
+    assert(tracker.Touch(3, Ms(10150)));
+    assert(tracker.Size() == 3 && tracker.Tracked(1) && !tracker.Tracked(4));
+
+    //
+    //  Never early, at most one bucket late.
+    //
+    assert(tracker.Expire(Ms(11049), collect) == 0);
+    assert(tracker.Expire(Ms(11100), collect) == 2);
+    assert(expired.size() == 2 && !tracker.Tracked(1) && !tracker.Tracked(2));
+    assert(tracker.Size() == 1);
+
+    //
+    //  Touching again keeps it alive.
+    //
+    assert(tracker.Touch(3, Ms(11000)));
+    assert(tracker.Expire(Ms(11200), collect) == 0);
+    assert(tracker.Expire(Ms(12100), collect) == 1);
+    assert(expired.back() == 3 && tracker.Size() == 0);
+
+    //
+    //  Removed entities never expire.
+    //
+    assert(tracker.Touch(4, Ms(13000)));
+    assert(tracker.Remove(4) && !tracker.Remove(4));
+    assert(tracker.Expire(Ms(20000), collect) == 0);
+
+    //
+    //  A jump of many wheel turns expires everything once.
+    //
+    for (uint32_t id = 0; id < 10; id++)
+        assert(tracker.Touch(id, Ms(21000 + id * 97)));
+    expired.clear();
+    assert(tracker.Expire(Ms(1000000), collect) == 10);
+    assert(tracker.Size() == 0 && expired.size() == 10);
+
+    assert(!CLivenessTracker(0, Ms(1000), Ms(100)).Valid());
+    assert(!CLivenessTracker(10, Ms(1000), Ms(0)).Valid());
+    assert(!CLivenessTracker(10, Ms(1000), Ms(0)).Touch(1, Ms(0)));
+}
+
+
+/**
+ *  Buckets the wheel reuses before a sweep are expired, not mixed 
+ *  into the new turn.
+ */
+void TestWheelReuse()
+{
+    CLivenessTracker tracker(4, Ms(300), Ms(100));
+    std::vector<uint32_t> expired;
+    Collect collect {&expired};
+
+    assert(tracker.Touch(0, Ms(0)));
+    assert(tracker.Touch(1, Ms(5000)));
+    assert(tracker.Expire(Ms(5000), collect) == 1);
+    assert(expired.size() == 1 && expired[0] == 0 && tracker.Tracked(1));
+}
+
+
+/**
+ *  The callback may touch and remove while the sweep runs.
+ */
+void TestReentrantCallback()
+{
+    struct Rearm
+    {
+        CLivenessTracker *tracker;
+        CTimeSpec now;
+        size_t *calls;
+
+        void operator()(uint32_t id)
+        {
+            (*calls)++;
+            if (id == 0)
+                tracker->Touch(id, now);
+            else if (id == 1)
+                tracker->Remove(2);
+        }
+    };
+
+    CLivenessTracker tracker(4, Ms(1000), Ms(100));
+    for (uint32_t id = 0; id < 4; id++)
+        tracker.Touch(id, Ms(0));
+
+    size_t calls = 0;
+    Rearm rearm {&tracker, Ms(5000), &calls};
+    assert(tracker.Expire(Ms(5000), rearm) == calls);
+    assert(tracker.Tracked(0) && tracker.Size() == 1);
+    assert(tracker.Expire(Ms(5500), rearm) == 0);
+    assert(tracker.Expire(Ms(6100), rearm) == 1);
+}
+
+
+/**
+ *  Against a brute force scan of last seen times.
+ */
+void TestAgainstScan()
+{
+    const uint32_t ids = 200;
+    const int64_t timeout = 700, granularity = 50;
+    CLivenessTracker tracker(ids, Ms(timeout), Ms(granularity));
+    std::vector<int64_t> last(ids, -1);
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    int64_t now = 1000;
+
+    for (int step = 0; step < 20000; step++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        now += (int64_t)(state % 7);
+        uint32_t id = (uint32_t)((state >> 8) % ids);
+        if ((state >> 40) % 20 == 0) {
+            assert(tracker.Remove(id) == (last[id] >= 0));
+            last[id] = -1;
+        } else {
+            tracker.Touch(id, Ms(now));
+            last[id] = now;
+        }
+
+        if ((state >> 48) % 16 == 0) {
+            if ((state >> 52) % 64 == 0)
+                now += 5000;
+            std::vector<uint32_t> expired;
+            Collect collect {&expired};
+            tracker.Expire(Ms(now), collect);
+            for (uint32_t e : expired) {
+                assert(last[e] >= 0 && now >= last[e] + timeout);
+                last[e] = -1;
+            }
+            size_t live = 0;
+            for (uint32_t i = 0; i < ids; i++) {
+                if (last[i] >= 0) {
+                    live++;
+                    assert(tracker.Tracked(i));
+                    assert(now < last[i] + timeout + granularity);
+                }
+            }
+            assert(tracker.Size() == live);
+        }
+    }
+}
+
+
+int main()
+{
+    std::cout << "Unit testing liveness_tracker.hpp" << std::endl;
+
+    TestBasics();
+    TestWheelReuse();
+    TestReentrantCallback();
+    TestAgainstScan();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,191 @@
+/**
+ *  @file
+ *
+ *  Unit test code of message_pacer.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_message_pacer.cpp -o unit_test_message_pacer
+ *
+ *  To test:
+ *  ./unit_test_message_pacer
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+
+#include "time_utilities.hpp"
+#include "message_pacer.hpp"
+
+
+static CTimeSpec Ns(int64_t ns)
+{
+    return CTimeSpec((time_t)(ns / NS_IN_SECOND), (long)(ns % NS_IN_SECOND));
+}
+
+
+/**
+ *  The n-th release is at exactly floor(n * per / messages), however
+ *  many messages in, with no drift from a rounded interval.
+ */
+void TestExactSchedule()
+{
+    const struct { uint64_t messages; int64_t per_ns; } rates[] = {
+        {3, NS_IN_SECOND}, {7, 1000}, {1000003, NS_IN_SECOND}, {3, 1}, {1, 5 * NS_IN_SECOND},
+    };
+
+    for (const auto &rate : rates) {
+        CMessagePacer pacer(rate.messages, Ns(rate.per_ns));
+        assert(pacer.Valid());
+        pacer.Start(Ns(1000));
+
+        for (uint64_t n = 0; n < 1000000; n++) {
+            int64_t due = 1000 + (int64_t)((unsigned __int128)n * rate.per_ns / rate.messages);
+            assert(pacer.NextRelease() == Ns(due));
+
+            //
+            //  Step to the due time, unless several are due at once.
+            //
+            if (n + 1 < 1000000) {
+                int64_t following = 1000 + (int64_t)((unsigned __int128)(n + 1) * rate.per_ns / 
+                                                     rate.messages);
+                if (following == due)
+                    assert(pacer.Due(Ns(due), 1000000) >= 2);
+                else
+                    assert(pacer.Due(Ns(due)) == 1);
+                n = pacer.Released() - 1;
+            }
+        }
+    }
+
+    CMessagePacer three(3);
+    three.Start(Ns(0));
+    assert(three.Due(Ns(0)) == 1);
+    assert(three.Due(Ns(333333332)) == 0);
+    assert(three.Due(Ns(333333333)) == 1);
+    assert(three.NextRelease() == Ns(666666666));
+
+    assert(!CMessagePacer(0).Valid());
+    assert(!CMessagePacer(10, Ns(0)).Valid());
+    assert(CMessagePacer(0).Wait() == 0);
+}
+
+
+void TestBehind()
+{
+    CMessagePacer pacer(1000);
+    pacer.Start(Ns(0));
+
+    //
+    //  10ms late: ten messages due, released in batches.
+    //
+    assert(pacer.Due(Ns(9 * NS_IN_MS), 4) == 4);
+    assert(pacer.Due(Ns(9 * NS_IN_MS), 100) == 6);
+    assert(pacer.Due(Ns(9 * NS_IN_MS), 100) == 0);
+    assert(pacer.Released() == 10 && pacer.Batched() == 2);
+    assert(pacer.NextRelease() == Ns(10 * NS_IN_MS));
+    assert(pacer.Lateness().Max() == 9 * NS_IN_MS);
+
+    //
+    //  Skipping the backlog instead.
+    //
+    pacer.SetMaxLag(Ns(5 * NS_IN_MS));
+    assert(pacer.Due(Ns(1000 * NS_IN_MS), 100) == 1);
+    assert(pacer.Rebased() == 1);
+    assert(pacer.NextRelease() == Ns(1001 * NS_IN_MS));
+
+    pacer.Start(Ns(0));
+    assert(pacer.Released() == 0 && pacer.Rebased() == 0 && pacer.Lateness().Count() == 0);
+}
+
+
+/**
+ *  Released exactly on time, the achieved rate is exact too.
+ */
+void TestAchievedRate()
+{
+    CMessagePacer pacer(100000);
+    pacer.Start(Ns(0));
+    assert(pacer.AchievedRate() == 0);
+
+    for (int64_t n = 0; n < 2000; n++)
+        assert(pacer.Due(Ns(n * 10000)) == 1);
+
+    assert(pacer.Released() == 2000 && pacer.Releases() == 2000);
+    assert(pacer.AchievedRate() == 2000.0 * NS_IN_SECOND / (1999.0 * 10000));
+    assert(pacer.Lateness().Max() == 0);
+    assert(pacer.JitterNs() == 0);
+
+    //
+    //  Late releases can only lower it.
+    //
+    assert(pacer.Due(Ns(2000 * 10000 + 5000)) == 1);
+    assert(pacer.AchievedRate() < 2001.0 * NS_IN_SECOND / (2000.0 * 10000));
+}
+
+
+/**
+ *  Real sleeps: 2000 messages at 100k/s. Only what holds however 
+ *  late the wakeups are; a preempted wakeup can stretch the run 
+ *  arbitrarily, so the rate has no lower bound here.
+ */
+void TestWait()
+{
+    CMessagePacer pacer(100000);
+    CTimeSpec start = CTimeSpec::NowMonotonic();
+    pacer.Start();
+
+    uint64_t sent = 0;
+    while (sent < 2000) {
+        size_t count = pacer.Wait(64);
+        assert(count >= 1);
+        sent += count;
+    }
+    CTimeSpec elapsed = CTimeSpec::NowMonotonic() - start;
+
+    assert(pacer.Released() == sent);
+    assert(elapsed >= Ns(19990000));
+    //
+    //  Message n is never released before its due time, n * 10us.
+    //
+    assert(pacer.AchievedRate() > 0);
+    assert(pacer.AchievedRate() <= (double)sent * NS_IN_SECOND / ((double)(sent - 1) * 10000));
+    assert(pacer.Lateness().Count() == pacer.Releases());
+    assert(pacer.JitterNs() >= 0);
+}
+
+
+int main()
+{
+    std::cout << "Unit testing message_pacer.hpp" << std::endl;
+
+    TestExactSchedule();
+    TestBehind();
+    TestAchievedRate();
+    TestWait();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
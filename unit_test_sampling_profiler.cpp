@@ -0,0 +1,155 @@
+/**
+ *  @file
+ *
+ *  Unit test code of sampling_profiler.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 -rdynamic -pthread unit_test_sampling_profiler.cpp -o unit_test_sampling_profiler
+ *
+ *  To test:
+ *  ./unit_test_sampling_profiler
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cassert>
+#include <ctime>
+#include <thread>
+
+#include "time_utilities.hpp"
+#include "sampling_profiler.hpp"
+
+
+static volatile unsigned long sink;
+
+
+/**
+ *  Wall clock limit on each burn, in case samples never arrive.
+ */
+#define BURN_DEADLINE_S     (30)
+
+
+/**
+ *  Spin until the profiler has seen "samples" timer expirations 
+ *  (recorded or dropped), or the deadline passes. CPU time timers 
+ *  only advance while the thread runs, so this is independent of 
+ *  how much the host is loaded.
+ */
+__attribute__((noinline)) void BurnCpuInMain(const CSamplingProfiler& profiler, size_t samples)
+{
+    CTimeSpec deadline = CTimeSpec::NowMonotonic() + CTimeSpec(BURN_DEADLINE_S * 1000);
+    while (profiler.Samples() + profiler.Dropped() < samples &&
+           CTimeSpec::NowMonotonic() < deadline) {
+        for (int i = 0; i < 1000; i++)
+            sink = sink + i;
+    }
+}
+
+
+__attribute__((noinline)) void BurnCpuInWorker(const CSamplingProfiler& profiler, size_t samples)
+{
+    CTimeSpec deadline = CTimeSpec::NowMonotonic() + CTimeSpec(BURN_DEADLINE_S * 1000);
+    while (profiler.Samples() + profiler.Dropped() < samples &&
+           CTimeSpec::NowMonotonic() < deadline) {
+        for (int i = 0; i < 1000; i++)
+            sink = sink + i;
+    }
+}
+
+
+void TestSamplingProfiler()
+{
+    CSamplingProfiler profiler {CTimeSpec(1)};
+    assert(profiler.Running());
+
+    //
+    //  A second profiler cannot start while the first runs.
+    //
+    {
+        CSamplingProfiler second {CTimeSpec(1)};
+        assert(!second.Running());
+    }
+
+    //
+    //  One thread at a time, so both get samples: the main thread 
+    //  uses no CPU while it waits in join().
+    //
+    std::thread worker([&]() {
+        assert(profiler.AddCurrentThread());
+        BurnCpuInWorker(profiler, 10);
+        profiler.RemoveCurrentThread();
+    });
+    worker.join();
+
+    BurnCpuInMain(profiler, 20);
+    profiler.Stop();
+
+    std::cout << profiler.Samples() << " samples, " 
+              << profiler.Dropped() << " dropped, "
+              << profiler.Overruns() << " overruns" << std::endl;
+    assert(profiler.Samples() >= 20);
+    assert(profiler.Dropped() == 0);
+
+    std::ostringstream collapsed;
+    profiler.WriteCollapsed(collapsed);
+    std::string out = collapsed.str();
+    assert(out.find("BurnCpuInMain") != std::string::npos);
+    assert(out.find("BurnCpuInWorker") != std::string::npos);
+
+    //
+    //  Every line is "frame;frame;... count".
+    //
+    std::istringstream lines(out);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t space = line.rfind(' ');
+        assert(space != std::string::npos);
+        assert(atoi(line.c_str() + space + 1) > 0);
+    }
+}
+
+
+void TestDropped()
+{
+    CSamplingProfiler profiler {CTimeSpec(1), 5};
+    assert(profiler.Running());
+
+    BurnCpuInMain(profiler, 8);
+    profiler.Stop();
+
+    assert(profiler.Dropped() > 0 && profiler.Samples() == 5);
+}
+
+
+int main()
+{
+    std::cout << "Unit testing sampling_profiler.hpp" << std::endl;
+
+    TestSamplingProfiler();
+    TestDropped();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,133 @@
+/**
+ *  @file
+ *
+ *  Unit test code of scope_breakdown.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_scope_breakdown.cpp -o unit_test_scope_breakdown
+ *
+ *  To test:
+ *  ./unit_test_scope_breakdown
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cassert>
+#include <ctime>
+
+#include "time_utilities.hpp"
+#include "scope_breakdown.hpp"
+
+
+static void BurnCpu(unsigned int ms)
+{
+    CTimeSpec end = CTimeSpec::NowThreadCpu() + CTimeSpec(ms);
+    volatile unsigned long sink = 0;
+
+    while (CTimeSpec::NowThreadCpu() < end) {
+        sink = sink + 1;
+    }
+}
+
+
+static void Sleep(unsigned int ms)
+{
+    struct timespec ts = CTimeSpec(ms).c_timespec();
+    while (nanosleep(&ts, &ts) != 0)
+        ;
+}
+
+
+void Busy()
+{
+    TIME_SCOPE_BREAKDOWN("Busy");
+    BurnCpu(10);
+}
+
+
+void Blocked()
+{
+    TIME_SCOPE_BREAKDOWN("Blocked");
+    Sleep(10);
+}
+
+
+void TestBreakdown()
+{
+    for (int i = 0; i < 5; i++) {
+        Busy();
+        Blocked();
+    }
+
+    CScopeStats &busy = CScopeRegistry::Instance().Get("Busy");
+    CScopeStats &blocked = CScopeRegistry::Instance().Get("Blocked");
+
+    assert(busy.Wall().Count() == 5);
+    assert(blocked.Wall().Count() == 5);
+
+    assert(busy.Cpu().Min() >= 10 * NS_IN_MS);
+    assert(blocked.Wall().Min() >= 10 * NS_IN_MS);
+    assert(blocked.Cpu().Max() < 5 * NS_IN_MS);
+    assert(blocked.OffCpu().Min() >= 5 * NS_IN_MS);
+
+    //
+    //  Sleeping is a voluntary context switch, every time.
+    //
+    assert(blocked.VoluntarySwitches() >= 5);
+
+    std::ostringstream report;
+    CScopeRegistry::Instance().WriteReport(report);
+    std::cout << report.str();
+    assert(report.str().find("Busy") != std::string::npos);
+    assert(report.str().find("Blocked") != std::string::npos);
+
+    CScopeRegistry::Instance().Reset();
+    assert(busy.Wall().Count() == 0);
+    assert(&CScopeRegistry::Instance().Get("Busy") == &busy);
+}
+
+
+void TestWithoutSwitches()
+{
+    CScopeStats &stats = CScopeRegistry::Instance().Get("NoSwitches");
+    {
+        CScopeBreakdown scope {stats, false};
+        Sleep(5);
+    }
+    assert(stats.Wall().Count() == 1);
+    assert(stats.VoluntarySwitches() == 0);
+}
+
+
+int main()
+{
+    std::cout << "Unit testing scope_breakdown.hpp" << std::endl;
+
+    TestBreakdown();
+    TestWithoutSwitches();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
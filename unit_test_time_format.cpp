@@ -0,0 +1,468 @@
+/**
+ *  @file
+ *
+ *  Unit test code of time_format.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_time_format.cpp -o unit_test_time_format
+ *
+ *  To test:
+ *  ./unit_test_time_format
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+#include <climits>
+#include <ctime>
+
+#ifdef TIME_UTILITIES_HAVE_FMT
+#include <fmt/format.h>
+#endif
+
+#define USING_TIMEVAL
+#include "time_utilities.hpp"
+#include "time_format.hpp"
+
+#if defined(TIME_UTILITIES_HAVE_STD_FORMAT) && !defined(__cpp_lib_format)
+#error "built as the std::format test, but <format> is missing"
+#endif
+
+
+static std::string Seconds(const CTimeSpec& value, int digits)
+{
+    char buffer[SECONDS_FORMAT_MAX];
+    size_t n = FormatSeconds(buffer, sizeof(buffer), value, digits);
+    assert(n > 0);
+    return std::string(buffer, n);
+}
+
+
+/**
+ *  Slow but obviously right: round the 128 bit nanosecond total
+ *  and print it digit by digit.
+ */
+static std::string ReferenceSeconds(const CTimeSpec& value, int digits)
+{
+    struct timespec ts = value.c_timespec();
+    __int128 ns = (__int128)ts.tv_sec * NS_IN_SECOND + ts.tv_nsec;
+    bool negative = ns < 0;
+    unsigned __int128 magnitude = negative ? -(unsigned __int128)ns : ns;
+    unsigned __int128 scale = 1;
+
+    for (int i = digits; i < 9; i++)
+        scale *= 10;
+    magnitude = (magnitude + scale / 2) / scale;
+
+    std::string text;
+    for (int i = 0; i < digits; i++) {
+        text.insert(text.begin(), (char)('0' + (int)(magnitude % 10)));
+        magnitude /= 10;
+    }
+    if (digits)
+        text.insert(text.begin(), '.');
+    do {
+        text.insert(text.begin(), (char)('0' + (int)(magnitude % 10)));
+        magnitude /= 10;
+    } while (magnitude);
+
+    bool zero = text.find_first_not_of("0.") == std::string::npos;
+    if (negative && !zero)
+        text.insert(text.begin(), '-');
+    return text;
+}
+
+
+void TestFormatSeconds()
+{
+    assert(Seconds(CTimeSpec(12, 345000000), 3) == "12.345");
+    assert(Seconds(CTimeSpec(12, 345000000), 9) == "12.345000000");
+    assert(Seconds(CTimeSpec(0, 0), 9) == "0.000000000");
+    assert(Seconds(CTimeSpec(0, 0), 0) == "0");
+    assert(Seconds(CTimeSpec(7, 0), 0) == "7");
+    assert(Seconds(CTimeSpec(0, 1), 9) == "0.000000001");
+
+    //
+    //  Rounding, half away from zero, carrying into the seconds.
+    //
+    assert(Seconds(CTimeSpec(1, 999999999), 3) == "2.000");
+    assert(Seconds(CTimeSpec(1, 500000000), 0) == "2");
+    assert(Seconds(CTimeSpec(1, 499999999), 0) == "1");
+    assert(Seconds(CTimeSpec(0, 1500), 6) == "0.000002");
+    assert(Seconds(CTimeSpec(0, 1499), 6) == "0.000001");
+
+    //
+    //  Negative values, and no negative zero.
+    //
+    assert(Seconds(CTimeSpec(0, -1), 9) == "-0.000000001");
+    assert(Seconds(CTimeSpec(0, -1), 6) == "0.000000");
+    assert(Seconds(CTimeSpec(-1, -500000000), 0) == "-2");
+    assert(Seconds(CTimeSpec(-3, 0), 2) == "-3.00");
+    assert(Seconds(CTimeSpec(-3, 250000000), 2) == "-2.75");
+
+    //
+    //  Extremes of time_t.
+    //
+    assert(Seconds(CTimeSpec(LLONG_MIN, 0), 9) == "-9223372036854775808.000000000");
+    assert(Seconds(CTimeSpec(LLONG_MAX, 999999999), 9) == "9223372036854775807.999999999");
+    assert(Seconds(CTimeSpec(LLONG_MAX, 999999999), 0) == "9223372036854775808");
+
+    //
+    //  Out of range digits are clamped.
+    //
+    assert(Seconds(CTimeSpec(1, 5), 42) == "1.000000005");
+    assert(Seconds(CTimeSpec(1, 5), -1) == "1");
+
+    char buffer[SECONDS_FORMAT_MAX];
+    size_t n = FormatSeconds(buffer, sizeof(buffer), CTimeVal(3, 250), 6);
+    assert(std::string(buffer, n) == "3.000250");
+}
+
+
+void TestAgainstReference()
+{
+    uint64_t state = 0x12345678abcdefULL;
+
+    for (int i = 0; i < 200000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        time_t sec = (time_t)state >> (state & 63);
+        long nsec = (long)((state >> 20) % NS_IN_SECOND);
+        int digits = (int)((state >> 50) % 10);
+
+        CTimeSpec value {sec, nsec};
+        assert(Seconds(value, digits) == ReferenceSeconds(value, digits));
+    }
+}
+
+
+void TestBufferTooSmall()
+{
+    char buffer[8];
+    memset(buffer, 'x', sizeof(buffer));
+
+    assert(FormatSeconds(buffer, 5, CTimeSpec(12, 345000000), 3) == 0);
+    assert(buffer[0] == 'x');
+    assert(FormatSeconds(buffer, 6, CTimeSpec(12, 345000000), 3) == 6);
+    assert(std::string(buffer, 6) == "12.345");
+}
+
+
+void TestExporter()
+{
+    char buffer[64];
+    CSecondsExporter exporter {buffer, sizeof(buffer), 3, '\n'};
+    CTimeSpec values[] = {CTimeSpec(1, 0), CTimeSpec(0, 250000000), CTimeSpec(-2, 0)};
+
+    assert(exporter.Add(values, 3) == 3);
+    assert(std::string(buffer, exporter.Size()) == "1.000\n0.250\n-2.000\n");
+
+    //
+    //  Fill it up, a value that does not fit leaves nothing behind.
+    //
+    size_t added = 0;
+    while (exporter.Add(CTimeSpec(123, 0)))
+        added++;
+    assert(added == (sizeof(buffer) - 19) / 8);
+    std::string out(buffer, exporter.Size());
+    assert(out.size() == 19 + added * 8);
+    assert(out.substr(out.size() - 8) == "123.000\n");
+
+    exporter.Clear();
+    assert(exporter.Size() == 0);
+    assert(exporter.Add(CTimeSpec(5, 0)));
+    assert(std::string(buffer, exporter.Size()) == "5.000\n");
+}
+
+
+static std::string Render(const CTimeFormat& format, const CTimeSpec& value)
+{
+    char buffer[256];
+    assert(format.MaxLength() <= sizeof(buffer));
+    size_t n = format.Format(buffer, sizeof(buffer), value);
+    return std::string(buffer, n);
+}
+
+
+void TestTimeFormat()
+{
+    //  2016-12-08 16:04:05.123456789, a Thursday
+    CTimeSpec A {1481213045, 123456789};
+
+    CTimeFormat iso {"%Y-%m-%dT%H:%M:%S.%NZ"};
+    assert(iso.Valid());
+    assert(Render(iso, A) == "2016-12-08T16:04:05.123456789Z");
+
+    assert(Render(CTimeFormat("%F %T.%3N"), A) == "2016-12-08 16:04:05.123");
+    assert(Render(CTimeFormat("%T.%6N"), A) == "16:04:05.123456");
+    assert(Render(CTimeFormat("%1N|%9N"), A) == "1|123456789");
+    assert(Render(CTimeFormat("%a %A %b %B"), A) == "Thu Thursday Dec December");
+    assert(Render(CTimeFormat("%u %w %j %y %e"), A) == "4 4 343 16  8");
+    assert(Render(CTimeFormat("%s%z %Z %%"), A) == "1481213045+0000 UTC %");
+    assert(Render(CTimeFormat("no specifiers"), A) == "no specifiers");
+    assert(Render(CTimeFormat(""), A) == "");
+
+    //
+    //  Fractions are truncated, as date(1) does, never rounded 
+    //  into the next second.
+    //
+    assert(Render(CTimeFormat("%S.%3N"), CTimeSpec(59, 999999999)) == "59.999");
+
+    //
+    //  Before the epoch and outside four digit years.
+    //
+    assert(Render(CTimeFormat("%F %T.%3N %s"), CTimeSpec(-1, 5000000)) == 
+           "1969-12-31 23:59:59.005 -1");
+    assert(Render(CTimeFormat("%Y"), CTimeSpec(253402300800LL, 0)) == "10000");
+    assert(Render(CTimeFormat("%Y"), CTimeSpec(-62198755200LL, 0)) == "-0001");
+
+    //
+    //  Bad patterns.
+    //
+    char buffer[64];
+    CTimeFormat bad {"%Q"};
+    assert(!bad.Valid());
+    assert(bad.Format(buffer, sizeof(buffer), A) == 0);
+    assert(!CTimeFormat("trailing %").Valid());
+    assert(!CTimeFormat("%0N").Valid());
+    std::string many;
+    for (int i = 0; i < CTimeFormat::MAX_OPS + 1; i++)
+        many += "%H";
+    assert(!CTimeFormat(many.c_str()).Valid());
+    std::string lengthy(CTimeFormat::MAX_LITERAL + 1, 'x');
+    assert(!CTimeFormat(lengthy.c_str()).Valid());
+
+    //
+    //  Too small a buffer writes nothing useful and returns 0.
+    //
+    assert(iso.Format(buffer, 29, A) == 0);
+    assert(iso.Format(buffer, 30, A) == 30);
+
+    assert(Render(CTimeFormat("%T.%6N"), CTimeSpec(CTimeVal(3, 250).c_timeval())) == 
+           "00:00:03.000250");
+    size_t n = iso.Format(buffer, sizeof(buffer), CTimeVal(0, 1));
+    assert(std::string(buffer, n) == "1970-01-01T00:00:00.000001000Z");
+}
+
+
+void TestTimeFormatAgainstStrftime()
+{
+    const char *patterns[] = {
+        "%Y-%m-%d %H:%M:%S",
+        "%a, %d %b %Y %T %z",
+        "%A %B %e %j %y %u %w",
+        "[%F %T] %%",
+    };
+    uint64_t state = 0xdeadbeefcafef00dULL;
+
+    for (const char *pattern : patterns) {
+        CTimeFormat format {pattern};
+        assert(format.Valid());
+
+        for (int i = 0; i < 20000; i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            //  Years 1000 to 9999, glibc does not pad %Y to 4 digits.
+            time_t sec = (time_t)(state % 284012524800ULL) - 30610224000LL;
+
+            struct tm tm;
+            gmtime_r(&sec, &tm);
+            char expected[256];
+            size_t length = strftime(expected, sizeof(expected), pattern, &tm);
+
+            assert(Render(format, CTimeSpec(sec, 0)) == std::string(expected, length));
+        }
+    }
+}
+
+
+static std::string Duration(const CTimeSpec& value)
+{
+    char buffer[DURATION_FORMAT_MAX];
+    size_t n = FormatDuration(buffer, sizeof(buffer), value);
+    assert(n > 0);
+    return std::string(buffer, n);
+}
+
+
+void TestFormatDuration()
+{
+    assert(Duration(CTimeSpec(0, 0)) == "0s");
+    assert(Duration(CTimeSpec(0, 1)) == "1ns");
+    assert(Duration(CTimeSpec(0, 999)) == "999ns");
+    assert(Duration(CTimeSpec(0, 1000)) == "1us");
+    assert(Duration(CTimeSpec(0, 3500)) == "3.5us");
+    assert(Duration(CTimeSpec(0, 250000000)) == "250ms");
+    assert(Duration(CTimeSpec(0, 1500001)) == "1.500001ms");
+    assert(Duration(CTimeSpec(1, 0)) == "1s");
+    assert(Duration(CTimeSpec(2, 500000000)) == "2.5s");
+    assert(Duration(CTimeSpec(90, 0)) == "1m30s");
+    assert(Duration(CTimeSpec(5400, 0)) == "1h30m0s");
+    assert(Duration(CTimeSpec(3600, 1)) == "1h0m0.000000001s");
+    assert(Duration(CTimeSpec(-1, 500000000)) == "-500ms");
+    assert(Duration(CTimeSpec(-90, 0)) == "-1m30s");
+    assert(Duration(CTimeSpec(LLONG_MIN, 0)) == "-2562047788015215h30m8s");
+    assert(Duration(CTimeSpec(LLONG_MAX, 999999999)) == "2562047788015215h30m7.999999999s");
+    assert(Duration(CTimeSpec(LLONG_MIN, 1)).size() <= DURATION_FORMAT_MAX);
+
+    char buffer[DURATION_FORMAT_MAX];
+    assert(FormatDuration(buffer, 4, CTimeSpec(0, 3500)) == 0);
+    assert(FormatDuration(buffer, 5, CTimeSpec(0, 3500)) == 5);
+    size_t n = FormatDuration(buffer, sizeof(buffer), CTimeVal(0, 250));
+    assert(std::string(buffer, n) == "250us");
+}
+
+
+static CTimeFormatSpec Spec(const std::string& text)
+{
+    CTimeFormatSpec spec;
+    bool ok;
+    std::string::const_iterator it = spec.Parse(text.begin(), text.end(), &ok);
+    assert(ok);
+    assert(it == text.end() || *it == '}');
+    return spec;
+}
+
+
+template <typename T>
+static std::string FormatToString(const T& value, const std::string& spec)
+{
+    std::string out;
+    FormatTo(std::back_inserter(out), value, Spec(spec));
+    return out;
+}
+
+
+void TestFormatTo()
+{
+    CTimeSpec A {1481213045, 123456789};
+
+    assert(FormatToString(A, "") == "(1481213045 sec, 123456789 nsec)");
+    assert(FormatToString(A, "r}") == "(1481213045 sec, 123456789 nsec)");
+    assert(FormatToString(A, "s") == "1481213045.123456789");
+    assert(FormatToString(A, ".3s") == "1481213045.123");
+    assert(FormatToString(A, "i") == "2016-12-08T16:04:05.123456789Z");
+    assert(FormatToString(A, ".0i") == "2016-12-08T16:04:05Z");
+    assert(FormatToString(CTimeSpec(5400, 0), "d") == "1h30m0s");
+
+    //
+    //  Raw matches operator<<, which it stands in for.
+    //
+    CTimeSpec values[] = {A, CTimeSpec(0, 0), CTimeSpec(-1, 5), CTimeSpec(LLONG_MIN, 999999999)};
+    for (const CTimeSpec &value : values) {
+        std::ostringstream os;
+        os << value;
+        assert(FormatToString(value, "") == os.str());
+    }
+
+    CTimeVal B {-3, 250};
+    std::ostringstream os;
+    os << B;
+    assert(FormatToString(B, "") == os.str());
+    assert(FormatToString(B, "s") == "-2.999750");
+    assert(FormatToString(B, ".2i") == "1969-12-31T23:59:57.00Z");
+    assert(FormatToString(B, "d") == "-2.99975s");
+
+    //
+    //  Through a plain pointer too.
+    //
+    char buffer[TIME_FORMAT_SPEC_MAX];
+    char *end = FormatTo(buffer, CTimeSpec(1, 0), Spec("s"));
+    assert(std::string(buffer, end) == "1.000000000");
+
+    char iso[ISO8601_FORMAT_MAX];
+    size_t n = FormatIso8601(iso, sizeof(iso), CTimeSpec(-62198755200LL, 5), 9);
+    assert(std::string(iso, n) == "-0001-01-01T00:00:00.000000005Z");
+    n = FormatIso8601(iso, sizeof(iso), CTimeSpec(LLONG_MAX, 999999999), 9);
+    assert(std::string(iso, n) == "292277026596-12-04T15:30:07.999999999Z");
+    assert(FormatIso8601(iso, 20, CTimeSpec(0, 0), 0) == 20);
+    assert(FormatIso8601(iso, 19, CTimeSpec(0, 0), 0) == 0);
+
+    //
+    //  Malformed specs.
+    //
+    const char *bad[] = {"x", ".s", ".3", ".3d", ".3r", "ss", ".10s"};
+    for (const char *text : bad) {
+        std::string spec_text(text);
+        CTimeFormatSpec spec;
+        bool ok;
+        spec.Parse(spec_text.begin(), spec_text.end(), &ok);
+        assert(!ok);
+    }
+
+#ifdef TIME_UTILITIES_HAVE_FMT
+    assert(fmt::format("{}", A) == "(1481213045 sec, 123456789 nsec)");
+    assert(fmt::format("[{:.3s}]", A) == "[1481213045.123]");
+    assert(fmt::format("{:i} {:d}", A, CTimeSpec(0, 3500)) == "2016-12-08T16:04:05.123456789Z 3.5us");
+    assert(fmt::format("{:.6s}", B) == "-2.999750");
+    bool threw = false;
+    try {
+        (void)fmt::format(fmt::runtime("{:q}"), A);
+    }
+    catch (const fmt::format_error&) {
+        threw = true;
+    }
+    assert(threw);
+#endif
+
+#ifdef __cpp_lib_format
+    assert(std::format("{}", A) == "(1481213045 sec, 123456789 nsec)");
+    assert(std::format("[{:.3s}]", A) == "[1481213045.123]");
+    assert(std::format("{:i} {:d}", A, CTimeSpec(0, 3500)) == "2016-12-08T16:04:05.123456789Z 3.5us");
+    assert(std::format("{:.6s}", B) == "-2.999750");
+    assert(std::format("{}", B) == os.str());
+    bool std_threw = false;
+    try {
+        (void)std::vformat("{:q}", std::make_format_args(A));
+    }
+    catch (const std::format_error&) {
+        std_threw = true;
+    }
+    assert(std_threw);
+#endif
+}
+
+
+int main()
+{
+    std::cout << "Unit testing time_format.hpp" << std::endl;
+
+    TestFormatSeconds();
+    TestAgainstReference();
+    TestBufferTooSmall();
+    TestFormatDuration();
+    TestTimeFormat();
+    TestFormatTo();
+    TestTimeFormatAgainstStrftime();
+    TestExporter();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
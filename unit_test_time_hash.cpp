@@ -0,0 +1,196 @@
+/**
+ *  @file
+ *
+ *  Unit test code of time_hash.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_time_hash.cpp -o unit_test_time_hash
+ *
+ *  To test:
+ *  ./unit_test_time_hash
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+
+#define USING_TIMEVAL
+#include "time_utilities.hpp"
+#include "time_hash.hpp"
+
+
+static uint64_t Next(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+
+/**
+ *  Flipping any one input bit flips each output bit about half
+ *  the time.
+ */
+void TestAvalanche()
+{
+    const int samples = 4000;
+    const int input_bits = 64 + 30;
+    std::vector<int> flips(input_bits * 64, 0);
+    uint64_t state = 0x0123456789abcdefULL;
+
+    for (int s = 0; s < samples; s++) {
+        int64_t sec = (int64_t)Next(&state);
+        int64_t nsec = (int64_t)(Next(&state) % NS_IN_SECOND);
+        uint64_t h = CTimeHash::Hash64(sec, nsec);
+
+        for (int bit = 0; bit < input_bits; bit++) {
+            uint64_t g = bit < 64 ? CTimeHash::Hash64(sec ^ (int64_t)(1ULL << bit), nsec)
+                                  : CTimeHash::Hash64(sec, nsec ^ (1LL << (bit - 64)));
+            uint64_t d = h ^ g;
+            for (int out = 0; out < 64; out++)
+                flips[bit * 64 + out] += (int)((d >> out) & 1);
+        }
+    }
+
+    for (int cell : flips) {
+        double p = (double)cell / samples;
+        assert(p > 0.42 && p < 0.58);
+    }
+}
+
+
+/**
+ *  Timestamps on a regular grid, which is what real keys look like,
+ *  spread evenly over a power of two table by the low bits alone.
+ */
+void TestLowBits()
+{
+    const size_t slots = 4096;
+    const CTimeSpec steps[] = {CTimeSpec(1, 0), CTimeSpec(0, 1000000), 
+                               CTimeSpec(0, 1), CTimeSpec(60, 0)};
+
+    for (const CTimeSpec &step : steps) {
+        std::vector<int> load(slots, 0);
+        CTimeSpec t {1481213045, 0};
+        for (size_t i = 0; i < slots * 4; i++) {
+            load[CTimeSpecHash()(t) & (slots - 1)]++;
+            t += step;
+        }
+        for (int l : load)
+            assert(l < 20);
+    }
+}
+
+
+void TestHashers()
+{
+    CTimeSpec a {1481213045, 123456789};
+    CTimeSpec b {1481213045, 123456790};
+
+    assert(CTimeSpecHash()(a) == CTimeSpecHash()(CTimeSpec(1481213045, 123456789)));
+    assert(CTimeSpecHash()(a) != CTimeSpecHash()(b));
+    assert(CTimeSpecHash(1)(a) != CTimeSpecHash(2)(a));
+    assert(std::hash<CTimeSpec>()(a) == CTimeSpecHash()(a));
+
+    CTimeVal tv {1481213045, 123456};
+    assert(std::hash<CTimeVal>()(tv) == CTimeValHash()(tv));
+    assert(CTimeValHash()(tv) != CTimeValHash()(CTimeVal(1481213045, 123457)));
+
+    //
+    //  Default hashers make the classes usable as keys.
+    //
+    std::unordered_set<CTimeSpec> seen;
+    seen.insert(a);
+    seen.insert(b);
+    seen.insert(a);
+    assert(seen.size() == 2);
+
+    std::unordered_map<CTimeVal, int> counts;
+    counts[tv]++;
+    counts[tv]++;
+    assert(counts.size() == 1 && counts[tv] == 2);
+}
+
+
+void TestBucketHash()
+{
+    //
+    //  Divides a second, whole seconds, and neither.
+    //
+    const int64_t units[] = {NS_IN_SECOND, 10 * NS_IN_MS, 60 * NS_IN_SECOND, 1500 * NS_IN_MS};
+
+    for (int64_t unit : units) {
+        CTimeSpecBucketHash hash(unit);
+        CTimeSpecBucketEqual equal(unit);
+        assert(hash.Unit() == unit);
+
+        const CTimeSpec starts[] = {CTimeSpec(0, 0), CTimeSpec(1481213040, 0), 
+                                    CTimeSpec(-3600, 0)};
+        for (const CTimeSpec &start : starts) {
+            CTimeSpec first = start;
+            CTimeSpec last = start + CTimeSpec(unit / NS_IN_SECOND, unit % NS_IN_SECOND - 1);
+            CTimeSpec next = start + CTimeSpec(unit / NS_IN_SECOND, unit % NS_IN_SECOND);
+            CTimeSpec before = start - CTimeSpec(0, 1);
+
+            assert(hash(first) == hash(last) && equal(first, last));
+            assert(!equal(first, next) && hash(first) != hash(next));
+            assert(!equal(before, first) && hash(before) != hash(first));
+        }
+    }
+
+    //
+    //  Per second counting with the unordered containers.
+    //
+    std::unordered_map<CTimeSpec, int, CTimeSpecBucketHash, CTimeSpecBucketEqual> per_second;
+    for (int i = 0; i < 1000; i++)
+        per_second[CTimeSpec(1481213045 + i / 250, (i % 250) * 4000000L)]++;
+    assert(per_second.size() == 4);
+    assert(per_second[CTimeSpec(1481213046, 999999999)] == 250);
+
+    //
+    //  Extremes take the exact 128 bit path without overflow.
+    //
+    CTimeSpecBucketHash odd(7);
+    assert(!CTimeSpecBucketHash(7).Same(CTimeSpec(INT64_MIN, 0), CTimeSpec(INT64_MAX, 0)));
+    assert(odd.Same(CTimeSpec(INT64_MAX, 999999994), CTimeSpec(INT64_MAX, 999999999)));
+}
+
+
+int main()
+{
+    std::cout << "Unit testing time_hash.hpp" << std::endl;
+
+    TestAvalanche();
+    TestLowBits();
+    TestHashers();
+    TestBucketHash();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
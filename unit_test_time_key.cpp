@@ -0,0 +1,180 @@
+/**
+ *  @file
+ *
+ *  Unit test code of time_key.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_time_key.cpp -o unit_test_time_key
+ *
+ *  To test:
+ *  ./unit_test_time_key
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <ctime>
+
+#define USING_TIMEVAL
+#include "time_utilities.h"
+#include "time_utilities.hpp"
+#include "time_key.hpp"
+
+
+static int Sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+
+void TestKeyLayout()
+{
+    uint8_t key[TIME_KEY_ALIGNED_SIZE];
+
+    CTimeKey::Encode(key, CTimeSpec(0, 0));
+    const uint8_t epoch[TIME_KEY_SIZE] = {0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    assert(memcmp(key, epoch, TIME_KEY_SIZE) == 0);
+
+    CTimeKey::Encode(key, CTimeSpec(-1, 1));
+    const uint8_t before[TIME_KEY_SIZE] = {0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0, 0, 0, 1};
+    assert(memcmp(key, before, TIME_KEY_SIZE) == 0);
+
+    CTimeKey::EncodeAligned(key, CTimeSpec(1481213045, 123456789));
+    const uint8_t aligned[TIME_KEY_ALIGNED_SIZE] = {0x80, 0, 0, 0, 0x58, 0x49, 0x84, 0x75, 
+                                                    0, 0, 0, 0, 0x07, 0x5b, 0xcd, 0x15};
+    assert(memcmp(key, aligned, TIME_KEY_ALIGNED_SIZE) == 0);
+
+    //
+    //  Round trips, and keys with nsec out of range are refused.
+    //
+    CTimeSpec values[] = {CTimeSpec(0, 0), CTimeSpec(-1, 1), CTimeSpec(LLONG_MIN, 0), 
+                          CTimeSpec(LLONG_MAX, 999999999), CTimeSpec(1481213045, 123456789)};
+    for (const CTimeSpec &value : values) {
+        CTimeSpec decoded;
+        CTimeKey::Encode(key, value);
+        assert(CTimeKey::Decode(key, &decoded) && decoded == value);
+        CTimeKey::EncodeAligned(key, value);
+        assert(CTimeKey::DecodeAligned(key, &decoded) && decoded == value);
+    }
+
+    CTimeSpec untouched {7, 7};
+    memset(key, 0xff, sizeof(key));
+    assert(!CTimeKey::Decode(key, &untouched));
+    assert(!CTimeKey::DecodeAligned(key, &untouched));
+    assert(untouched == CTimeSpec(7, 7));
+
+    CTimeVal tv_decoded;
+    CTimeKey::Encode(key, CTimeVal(-5, 250));
+    assert(CTimeKey::Decode(key, &tv_decoded) && tv_decoded == CTimeVal(-5, 250));
+    memset(key + 8, 0xff, 4);
+    assert(!CTimeKey::Decode(key, &tv_decoded));
+}
+
+
+/**
+ *  memcmp of the keys orders exactly as timespec_compare does.
+ */
+void TestKeyOrder()
+{
+    uint64_t state = 0x5555aaaa3333ccccULL;
+    const time_t edges[] = {LLONG_MIN, LLONG_MIN + 1, -1, 0, 1, LLONG_MAX - 1, LLONG_MAX};
+
+    for (int i = 0; i < 200000; i++) {
+        struct timespec a, b;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        a.tv_sec = (state & 3) == 0 ? edges[(state >> 2) % 7] : (time_t)state >> (state & 63);
+        a.tv_nsec = (long)((state >> 11) % NS_IN_SECOND);
+        b = a;
+        switch ((state >> 8) % 4) {
+            case 0: b.tv_nsec = (long)((state >> 30) % NS_IN_SECOND); break;
+            case 1: b.tv_sec = edges[(state >> 5) % 7]; break;
+            case 2: b.tv_sec = (time_t)(state * 0x9e3779b97f4a7c15ULL); break;
+            default: break;
+        }
+
+        uint8_t ka[TIME_KEY_SIZE], kb[TIME_KEY_SIZE];
+        CTimeKey::Encode(ka, CTimeSpec(a));
+        CTimeKey::Encode(kb, CTimeSpec(b));
+        assert(Sign(memcmp(ka, kb, TIME_KEY_SIZE)) == Sign(timespec_compare(&a, &b)));
+
+        uint8_t aa[TIME_KEY_ALIGNED_SIZE], ab[TIME_KEY_ALIGNED_SIZE];
+        CTimeKey::EncodeAligned(aa, CTimeSpec(a));
+        CTimeKey::EncodeAligned(ab, CTimeSpec(b));
+        assert(Sign(memcmp(aa, ab, TIME_KEY_ALIGNED_SIZE)) == Sign(timespec_compare(&a, &b)));
+    }
+}
+
+
+void TestBatchEncode()
+{
+    const size_t count = 100;
+    std::vector<CTimeSpec> values;
+    for (size_t i = 0; i < count; i++)
+        values.push_back(CTimeSpec((time_t)(i * 7919) - 50000, (long)(i * 104729)));
+
+    std::vector<uint8_t> keys(count * TIME_KEY_SIZE);
+    CTimeKey::Encode(keys.data(), values.data(), count);
+
+    //
+    //  Time prefixes of 20 byte records, the rest left alone.
+    //
+    const size_t stride = 20;
+    std::vector<uint8_t> records(count * stride, 0xee);
+    CTimeKey::Encode(records.data(), values.data(), count, stride);
+
+    std::vector<uint8_t> aligned(count * TIME_KEY_ALIGNED_SIZE);
+    CTimeKey::EncodeAligned(aligned.data(), values.data(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t key[TIME_KEY_ALIGNED_SIZE];
+        CTimeKey::Encode(key, values[i]);
+        assert(memcmp(&keys[i * TIME_KEY_SIZE], key, TIME_KEY_SIZE) == 0);
+        assert(memcmp(&records[i * stride], key, TIME_KEY_SIZE) == 0);
+        for (size_t j = TIME_KEY_SIZE; j < stride; j++)
+            assert(records[i * stride + j] == 0xee);
+
+        CTimeKey::EncodeAligned(key, values[i]);
+        assert(memcmp(&aligned[i * TIME_KEY_ALIGNED_SIZE], key, TIME_KEY_ALIGNED_SIZE) == 0);
+    }
+}
+
+
+int main()
+{
+    std::cout << "Unit testing time_key.hpp" << std::endl;
+
+    TestKeyLayout();
+    TestKeyOrder();
+    TestBatchEncode();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,297 @@
+/**
+ *  @file
+ *
+ *  Unit test code of time_parse.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_time_parse.cpp -o unit_test_time_parse
+ *
+ *  To test:
+ *  ./unit_test_time_parse
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <ctime>
+
+#define USING_TIMEVAL
+#include "time_utilities.hpp"
+#include "time_format.hpp"
+#include "time_parse.hpp"
+
+
+static CTimeParser::ParseResult Parse(const char *pattern, const char *text, CTimeSpec *result)
+{
+    CTimeParser parser {pattern};
+    assert(parser.Valid());
+    return parser.Parse(text, result);
+}
+
+
+#define ASSERT_PARSE(pattern_, text_, sec_, nsec_) \
+{\
+    CTimeSpec parsed_; \
+    assert(Parse(pattern_, text_, &parsed_) == CTimeParser::PARSE_OK); \
+    assert(parsed_ == CTimeSpec(sec_, nsec_)); \
+}
+
+
+#define ASSERT_PARSE_FAILS(pattern_, text_, result_) \
+{\
+    CTimeSpec parsed_ {7, 7}; \
+    assert(Parse(pattern_, text_, &parsed_) == CTimeParser::result_); \
+    assert(parsed_ == CTimeSpec(7, 7)); \
+}
+
+
+void TestParse()
+{
+    ASSERT_PARSE("%Y-%m-%dT%H:%M:%S.%NZ", "2016-12-08T16:04:05.123456789Z", 1481213045, 123456789);
+    ASSERT_PARSE("%F %T", "2016-12-08 16:04:05", 1481213045, 0);
+    ASSERT_PARSE("%F %T.%N", "2016-12-08 16:04:05.5", 1481213045, 500000000);
+    ASSERT_PARSE("%F %T.%3N", "2016-12-08 16:04:05.012", 1481213045, 12000000);
+    ASSERT_PARSE("%d/%b/%Y:%H:%M:%S %z", "08/Dec/2016:17:04:05 +0100", 1481213045, 0);
+    ASSERT_PARSE("%d/%b/%Y:%H:%M:%S %z", "08/dec/2016:11:34:05 -04:30", 1481213045, 0);
+    ASSERT_PARSE("%a, %d %B %Y %T %Z", "Thu, 08 December 2016 16:04:05 GMT", 1481213045, 0);
+    ASSERT_PARSE("%A %e %h %Y %I:%M:%S %p", "thursday  8 DEC 2016 04:04:05 PM", 1481213045, 0);
+    ASSERT_PARSE("%D %I:%M %p", "12/08/16 12:00 AM", 1481155200, 0);
+    ASSERT_PARSE("%D %I:%M %p", "12/08/16 12:00 pm", 1481198400, 0);
+    ASSERT_PARSE("%Y.%j", "2016.343", 1481155200, 0);
+    ASSERT_PARSE("%s.%6N", "1481213045.000250", 1481213045, 250000);
+    ASSERT_PARSE("%s", "-1", -1, 0);
+    ASSERT_PARSE("%T", "1:2:3", 3723, 0);
+    ASSERT_PARSE("[%T]%%", "[00:00:01]%", 1, 0);
+    ASSERT_PARSE("%Y %m %d", "2016   12\t08", 1481155200, 0);
+    ASSERT_PARSE("%Y-%m-%d %H:%M:%S", "2016-12-31 23:59:60", 1483228800, 0);
+    ASSERT_PARSE("%Y-%m-%d", "1969-12-31", -86400, 0);
+    ASSERT_PARSE("%y", "69", -31536000, 0);
+    ASSERT_PARSE("%y", "68", 3092601600LL, 0);
+
+    ASSERT_PARSE_FAILS("%F", "2016-02-30", PARSE_RANGE);
+    ASSERT_PARSE_FAILS("%F", "2015-13-01", PARSE_RANGE);
+    ASSERT_PARSE_FAILS("%T", "24:00:00", PARSE_RANGE);
+    ASSERT_PARSE_FAILS("%I %p", "13 PM", PARSE_RANGE);
+    ASSERT_PARSE_FAILS("%Y.%j", "2015.366", PARSE_RANGE);
+    ASSERT_PARSE_FAILS("%Y.%j", "2015.000", PARSE_RANGE);
+    ASSERT_PARSE_FAILS("%F", "2016-12-x8", PARSE_MISMATCH);
+    ASSERT_PARSE_FAILS("%F", "16-12-08", PARSE_MISMATCH);
+    ASSERT_PARSE_FAILS("%b", "Dex", PARSE_MISMATCH);
+    ASSERT_PARSE_FAILS("%z", "+1", PARSE_MISMATCH);
+    ASSERT_PARSE_FAILS("%Z", "CET", PARSE_MISMATCH);
+    ASSERT_PARSE_FAILS("%F", "", PARSE_MISMATCH);
+    ASSERT_PARSE_FAILS("%F", "2016-12-08 ", PARSE_TRAILING);
+    ASSERT_PARSE_FAILS("%3N", "1234", PARSE_TRAILING);
+
+    //
+    //  A prefix, leaving the rest of the line.
+    //
+    CTimeParser parser {"%F %T"};
+    const char *line = "2016-12-08 16:04:05 INFO started";
+    CTimeSpec parsed;
+    size_t used = 0;
+    assert(parser.Parse(line, strlen(line), &parsed, &used) == CTimeParser::PARSE_OK);
+    assert(used == 19);
+    assert(parsed == CTimeSpec(1481213045, 0));
+
+    //
+    //  Bad patterns.
+    //
+    CTimeParser bad {"%Q"};
+    assert(!bad.Valid());
+    assert(bad.Parse("", &parsed) == CTimeParser::PARSE_BAD_PATTERN);
+    assert(!CTimeParser("%").Valid());
+    assert(!CTimeParser(std::string(CTimeParser::MAX_LITERAL + 1, 'x').c_str()).Valid());
+}
+
+
+void TestBulkParse()
+{
+    CTimeParser parser {"%F %T.%3N"};
+    const char *texts[] = {
+        "2016-12-08 16:04:05.001",
+        "2016-12-08 16:04:05",
+        "2016-02-30 00:00:00.000",
+        "1970-01-01 00:00:00.999 ",
+        "1970-01-01 00:00:00.999 tail",
+    };
+    size_t lengths[] = {23, 19, 23, 23, 23};
+    CTimeSpec results[5];
+    uint8_t errors[5];
+
+    assert(parser.Parse(texts, lengths, 5, results, errors) == 3);
+    assert(errors[0] == CTimeParser::PARSE_OK);
+    assert(results[0] == CTimeSpec(1481213045, 1000000));
+    assert(errors[1] == CTimeParser::PARSE_MISMATCH);
+    assert(errors[2] == CTimeParser::PARSE_RANGE);
+    assert(errors[3] == CTimeParser::PARSE_OK);
+    assert(errors[4] == CTimeParser::PARSE_OK);
+    assert(results[4] == CTimeSpec(0, 999000000));
+
+    //
+    //  NUL terminated, no error array.
+    //
+    assert(parser.Parse(texts, NULL, 5, results, NULL) == 1);
+}
+
+
+/**
+ *  Render random times with CTimeFormat, then check both the 
+ *  parser and strptime + timegm read them back.
+ */
+void TestAgainstStrptime()
+{
+    const char *patterns[] = {
+        "%Y-%m-%d %H:%M:%S",
+        "%d/%b/%Y:%H:%M:%S",
+        "%a %B %d %T %Y",
+        "%y%m%d %H%M%S",
+        "%Y %j %T",
+    };
+    uint64_t state = 0x0123456789abcdefULL;
+
+    for (const char *pattern : patterns) {
+        CTimeFormat format {pattern};
+        CTimeParser parser {pattern};
+        assert(format.Valid() && parser.Valid());
+
+        for (int i = 0; i < 20000; i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            //  1969 to 2068, the range %y covers.
+            time_t sec = (time_t)(state % 3155760000ULL) - 31536000;
+
+            char text[128];
+            size_t n = format.Format(text, sizeof(text) - 1, CTimeSpec(sec, 0));
+            text[n] = '\0';
+
+            CTimeSpec parsed;
+            assert(parser.Parse(text, n, &parsed) == CTimeParser::PARSE_OK);
+            assert(parsed == CTimeSpec(sec, 0));
+
+            struct tm tm;
+            memset(&tm, 0, sizeof(tm));
+            const char *end = strptime(text, pattern, &tm);
+            assert(end && *end == '\0');
+            assert(timegm(&tm) == sec);
+        }
+    }
+}
+
+
+#define ASSERT_DURATION(text_, sec_, nsec_) \
+{\
+    CTimeSpec parsed_; \
+    assert(ParseDuration(text_, &parsed_) == CTimeParser::PARSE_OK); \
+    assert(parsed_ == CTimeSpec(sec_, nsec_)); \
+}
+
+
+#define ASSERT_DURATION_FAILS(text_, result_) \
+{\
+    CTimeSpec parsed_ {7, 7}; \
+    assert(ParseDuration(text_, &parsed_) == CTimeParser::result_); \
+    assert(parsed_ == CTimeSpec(7, 7)); \
+}
+
+
+void TestParseDuration()
+{
+    ASSERT_DURATION("0", 0, 0);
+    ASSERT_DURATION("-0", 0, 0);
+    ASSERT_DURATION("0s", 0, 0);
+    ASSERT_DURATION("1h30m", 5400, 0);
+    ASSERT_DURATION("250ms", 0, 250000000);
+    ASSERT_DURATION("3.5us", 0, 3500);
+    ASSERT_DURATION("3.5\xc2\xb5s", 0, 3500);
+    ASSERT_DURATION("3.5\xce\xbcs", 0, 3500);
+    ASSERT_DURATION("1ns", 0, 1);
+    ASSERT_DURATION("+1.5s", 1, 500000000);
+    ASSERT_DURATION("-1.5s", -2, 500000000);
+    ASSERT_DURATION(".5m", 30, 0);
+    ASSERT_DURATION("1.m", 60, 0);
+    ASSERT_DURATION("1h0m0.000000001s", 3600, 1);
+    ASSERT_DURATION("2m1m", 180, 0);
+    ASSERT_DURATION("1.0000000019s", 1, 1);
+    ASSERT_DURATION("0.000000000001h", 0, 3);
+    ASSERT_DURATION("1.00000000000000000000000000001s", 1, 0);
+    ASSERT_DURATION("9223372036854775807s", LLONG_MAX, 0);
+    ASSERT_DURATION("-9223372036854775807.999999999s", LLONG_MIN, 1);
+
+    ASSERT_DURATION_FAILS("", PARSE_MISMATCH);
+    ASSERT_DURATION_FAILS("-", PARSE_MISMATCH);
+    ASSERT_DURATION_FAILS("1", PARSE_MISMATCH);
+    ASSERT_DURATION_FAILS("s", PARSE_MISMATCH);
+    ASSERT_DURATION_FAILS(".s", PARSE_MISMATCH);
+    ASSERT_DURATION_FAILS("1d", PARSE_MISMATCH);
+    ASSERT_DURATION_FAILS("1 s", PARSE_MISMATCH);
+    ASSERT_DURATION_FAILS("1s ", PARSE_MISMATCH);
+    ASSERT_DURATION_FAILS("1h-1m", PARSE_MISMATCH);
+    ASSERT_DURATION_FAILS("9223372036854775808s", PARSE_RANGE);
+    ASSERT_DURATION_FAILS("99999999999999999999s", PARSE_RANGE);
+    ASSERT_DURATION_FAILS("2562047788015216h", PARSE_RANGE);
+
+    CTimeVal tv;
+    assert(ParseDuration("-1.0000019s", &tv) == CTimeParser::PARSE_OK);
+    assert(tv == CTimeVal(-1, -1));
+    assert(ParseDuration("250us", 3, &tv) == CTimeParser::PARSE_MISMATCH);
+
+    //
+    //  Everything FormatDuration writes reads back exactly.
+    //
+    uint64_t state = 0xfeedfacecafebeefULL;
+    for (int i = 0; i < 200000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        CTimeSpec value {(time_t)state >> (state & 63), (long)((state >> 20) % NS_IN_SECOND)};
+        if (value == CTimeSpec(LLONG_MIN, 0))
+            continue;
+
+        char text[DURATION_FORMAT_MAX];
+        size_t n = FormatDuration(text, sizeof(text), value);
+        CTimeSpec parsed;
+        assert(ParseDuration(text, n, &parsed) == CTimeParser::PARSE_OK);
+        assert(parsed == value);
+    }
+}
+
+
+int main()
+{
+    std::cout << "Unit testing time_parse.hpp" << std::endl;
+
+    TestParse();
+    TestBulkParse();
+    TestAgainstStrptime();
+    TestParseDuration();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -106,6 +106,12 @@ void test_ms_timespec(void)
 
     timespec_from_ms(&a, 99999);
     ASSERT_TS_VALID(a, 99, 999000000);
+
+    timespec_from_ms(&a, -1);
+    ASSERT_TS_VALID(a, -1, 999000000);
+
+    timespec_from_ms(&a, -1500);
+    ASSERT_TS_VALID(a, -2, 500000000);
 }
 
 
@@ -261,6 +267,12 @@ void test_ms_timeval(void)
 
     timeval_from_ms(&a, 99999);
     ASSERT_TV_VALID(a, 99, 999000);
+
+    timeval_from_ms(&a, -1);
+    ASSERT_TV_VALID(a, -1, 999000);
+
+    timeval_from_ms(&a, -1500);
+    ASSERT_TV_VALID(a, -2, 500000);
 }
 
 
@@ -350,6 +362,103 @@ void test_normalize_timeval()
 }
 
 
+void test_by_value_timespec(void)
+{
+    static const struct timespec table[] = {
+        {1, 10}, {2, 20}, {1, 999999999}, {1, 2}, {100, 1}, {-1, 999000000}
+    };
+    const int n = sizeof(table) / sizeof(table[0]);
+    struct timespec c;
+    int i, j;
+
+    c = timespec_sum(table[2], table[2]);
+    ASSERT_TS_VALID(c, 3, 999999998);
+    c = timespec_diff(table[4], table[0]);
+    ASSERT_TS_VALID(c, 98, 999999991);
+    assert(timespec_cmp(table[0], table[1]) == -1);
+    assert(timespec_cmp(table[2], table[3]) == 1);
+    assert(timespec_cmp(table[5], table[5]) == 0);
+
+    /*
+     *  Same results as the pointer API, which now takes const 
+     *  operands too.
+     */
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++) {
+            struct timespec sum, difference, by_value;
+
+            timespec_add(&sum, &table[i], &table[j]);
+            by_value = timespec_sum(table[i], table[j]);
+            ASSERT_TS_VALID(by_value, sum.tv_sec, sum.tv_nsec);
+
+            timespec_subtract(&difference, &table[i], &table[j]);
+            by_value = timespec_diff(table[i], table[j]);
+            ASSERT_TS_VALID(by_value, difference.tv_sec, difference.tv_nsec);
+
+            assert(timespec_cmp(table[i], table[j]) == timespec_compare(&table[i], &table[j]));
+        }
+    }
+}
+
+
+void test_by_value_timeval(void)
+{
+    static const struct timeval table[] = {
+        {1, 10}, {2, 20}, {1, 999999}, {1, 2}, {100, 1}, {-1, 999000}
+    };
+    const int n = sizeof(table) / sizeof(table[0]);
+    struct timeval c;
+    int i, j;
+
+    c = timeval_sum(table[2], table[2]);
+    ASSERT_TV_VALID(c, 3, 999998);
+    c = timeval_diff(table[4], table[0]);
+    ASSERT_TV_VALID(c, 98, 999991);
+    assert(timeval_cmp(table[0], table[1]) == -1);
+    assert(timeval_cmp(table[2], table[3]) == 1);
+    assert(timeval_cmp(table[5], table[5]) == 0);
+
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < n; j++) {
+            struct timeval sum, difference, by_value;
+
+            timeval_add(&sum, &table[i], &table[j]);
+            by_value = timeval_sum(table[i], table[j]);
+            ASSERT_TV_VALID(by_value, sum.tv_sec, sum.tv_usec);
+
+            timeval_subtract(&difference, &table[i], &table[j]);
+            by_value = timeval_diff(table[i], table[j]);
+            ASSERT_TV_VALID(by_value, difference.tv_sec, difference.tv_usec);
+
+            assert(timeval_cmp(table[i], table[j]) == timeval_compare(&table[i], &table[j]));
+        }
+    }
+}
+
+
+void test_now_cpu(void)
+{
+    struct timespec ts_thread;
+    struct timespec ts_process;
+    struct timeval tv_thread;
+    struct timeval tv_process;
+    int rc;
+
+    rc = timespec_now_thread_cpu(&ts_thread);
+    assert(rc == 0);
+    rc = timespec_now_process_cpu(&ts_process);
+    assert(rc == 0);
+    assert(ts_thread.tv_sec > 0 || ts_thread.tv_nsec > 0);
+    assert(timespec_compare(&ts_process, &ts_thread) >= 0);
+
+    rc = timeval_now_thread_cpu(&tv_thread);
+    assert(rc == 0);
+    rc = timeval_now_process_cpu(&tv_process);
+    assert(rc == 0);
+    assert(timeval_compare(&tv_process, &tv_thread) >= 0);
+}
+
+
 int main (void)
 {
     printf("Unit testing C based time utilities\n");
@@ -365,6 +474,11 @@ int main (void)
     test_ms_timeval();
     test_compare_timeval();
     test_normalize_timeval();
+
+    test_by_value_timespec();
+    test_by_value_timeval();
+
+    test_now_cpu();
     
     printf("Passed\n");
     return 0;
@@ -34,6 +34,7 @@
 #include <iostream>
 #include <cstdlib>
 #include <cassert>
+#include <cstdint>
 #include <ctime>
 #include <sys/time.h>
 
@@ -212,6 +213,15 @@ void TestCompareCTimeSpec()
     assert(A == B);
     assert(A <= B);
     assert(A >= B);
+
+    A = {5, 0};
+    B = {4, 10};
+    assert(A > B);
+    assert(!(A < B));
+    assert(!(A <= B));
+    assert(B < A);
+    assert(!(B > A));
+    assert(!(B >= A));
 }
 
 
@@ -232,6 +242,237 @@ void TestCompareCTimeSpec()
 }
 
 
+#define ASSERT_CIVIL_VALID(X_, y_, mo_, d_, h_, mi_, s_, wd_, yd_) \
+{\
+    CCivilTime X_ ## civil_ = X_.Civil(); \
+    assert(X_ ## civil_.year == y_);  \
+    assert(X_ ## civil_.month == mo_);  \
+    assert(X_ ## civil_.day == d_);  \
+    assert(X_ ## civil_.hour == h_);  \
+    assert(X_ ## civil_.minute == mi_);  \
+    assert(X_ ## civil_.second == s_);  \
+    assert(X_ ## civil_.weekday == wd_);  \
+    assert(X_ ## civil_.day_of_year == yd_);  \
+}
+
+
+void TestCivilCTimeSpec()
+{
+    CTimeSpec A {0, 0};
+    ASSERT_CIVIL_VALID(A, 1970, 1, 1, 0, 0, 0, 4, 1);
+
+    CTimeSpec B {-1, 999999999};
+    ASSERT_CIVIL_VALID(B, 1969, 12, 31, 23, 59, 59, 3, 365);
+    assert(B.Civil().nsec == 999999999);
+
+    CTimeSpec C {951782400, 0};
+    ASSERT_CIVIL_VALID(C, 2000, 2, 29, 0, 0, 0, 2, 60);
+
+    CTimeSpec D {4107542399, 5};
+    ASSERT_CIVIL_VALID(D, 2100, 2, 28, 23, 59, 59, 0, 59);
+
+    CTimeSpec E {-2203891200, 0};
+    ASSERT_CIVIL_VALID(E, 1900, 3, 1, 0, 0, 0, 4, 60);
+
+    CTimeSpec F {1481213045, 0};
+    assert(F.Year() == 2016);
+    assert(F.Month() == 12);
+    assert(F.Day() == 8);
+    assert(F.Hour() == 16);
+    assert(F.Minute() == 4);
+    assert(F.Second() == 5);
+    assert(F.Weekday() == 4);
+    assert(F.DayOfYear() == 343);
+
+    //
+    //  Against gmtime_r, hopping between days so the per thread 
+    //  cache is both hit and missed.
+    //
+    uint64_t state = 0x2545f4914f6cdd1dULL;
+    time_t previous = 0;
+
+    for (int i = 0; i < 200000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        time_t sec;
+        if (state & 1)
+            sec = previous + (time_t)(state >> 48) % 7200 - 3600;
+        else
+            sec = (time_t)(state % 200000000000ULL) - 100000000000LL;
+        previous = sec;
+
+        struct tm tm;
+        gmtime_r(&sec, &tm);
+        CCivilTime civil = CTimeSpec(sec, 0).Civil();
+
+        assert(civil.year == tm.tm_year + 1900LL);
+        assert(civil.month == tm.tm_mon + 1);
+        assert(civil.day == tm.tm_mday);
+        assert(civil.hour == tm.tm_hour);
+        assert(civil.minute == tm.tm_min);
+        assert(civil.second == tm.tm_sec);
+        assert(civil.weekday == tm.tm_wday);
+        assert(civil.day_of_year == tm.tm_yday + 1);
+    }
+
+    for (int64_t days = -1000000; days <= 1000000; days += 7) {
+        int64_t year;
+        unsigned month, day;
+        CTimeSpec::CivilFromDays(days, &year, &month, &day);
+        assert(CTimeSpec::DaysFromCivil(year, month, day) == days);
+    }
+}
+
+
+/**
+ *  AddMonths the slow way, through struct tm and timegm.
+ */
+static time_t ReferenceAddMonths(time_t sec, int months)
+{
+    struct tm tm;
+    gmtime_r(&sec, &tm);
+
+    int total = tm.tm_mon + months;
+    int year_shift = total >= 0 ? total / 12 : (total - 11) / 12;
+    tm.tm_year += year_shift;
+    tm.tm_mon = total - year_shift * 12;
+
+    int year = tm.tm_year + 1900;
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    static const int month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int last = month_days[tm.tm_mon] + (tm.tm_mon == 1 && leap);
+    if (tm.tm_mday > last)
+        tm.tm_mday = last;
+
+    return timegm(&tm);
+}
+
+
+void TestCalendarArithmeticCTimeSpec()
+{
+    //  2016-01-31 12:00:00.5
+    CTimeSpec A {1454241600, 500000000};
+
+    CTimeSpec B = A.AddMonths(1);
+    ASSERT_CIVIL_VALID(B, 2016, 2, 29, 12, 0, 0, 1, 60);
+    ASSERT_CTS_VALID(B, 1456747200, 500000000);
+
+    CTimeSpec C = A.AddMonths(13);
+    ASSERT_CIVIL_VALID(C, 2017, 2, 28, 12, 0, 0, 2, 59);
+
+    CTimeSpec D = A.AddMonths(-2);
+    ASSERT_CIVIL_VALID(D, 2015, 11, 30, 12, 0, 0, 1, 334);
+
+    CTimeSpec E = B.AddYears(1);
+    ASSERT_CIVIL_VALID(E, 2017, 2, 28, 12, 0, 0, 2, 59);
+    CTimeSpec F = B.AddYears(4);
+    ASSERT_CIVIL_VALID(F, 2020, 2, 29, 12, 0, 0, 6, 60);
+
+    CTimeSpec G = A.AddDays(-31);
+    ASSERT_CIVIL_VALID(G, 2015, 12, 31, 12, 0, 0, 4, 365);
+    ASSERT_CTS_VALID(G, 1451563200, 500000000);
+
+    assert(A.FloorToDay() == CTimeSpec(1454198400, 0));
+    assert(A.FloorToMonth() == CTimeSpec(1451606400, 0));
+    assert(A.FloorToYear() == CTimeSpec(1451606400, 0));
+    assert(A.FloorToMonth().AddMonths(1) == CTimeSpec(1454284800, 0));
+
+    //  Sunday 2016-01-31; weeks from Monday and from Sunday.
+    assert(A.FloorToWeek() == CTimeSpec(1453680000, 0));
+    assert(A.FloorToWeek(0) == CTimeSpec(1454198400, 0));
+
+    //  Before the epoch, the floors go down, not toward zero.
+    CTimeSpec H {-1, 999999999};
+    assert(H.FloorToDay() == CTimeSpec(-86400, 0));
+    assert(H.FloorToMonth() == CTimeSpec(-2678400, 0));
+    assert(H.FloorToWeek() == CTimeSpec(-259200, 0));
+
+    assert(CTimeSpec::DaysBetween(H, CTimeSpec(0, 0)) == 1);
+    assert(CTimeSpec::DaysBetween(CTimeSpec(0, 0), H) == -1);
+    assert(CTimeSpec::DaysBetween(A, A.FloorToDay()) == 0);
+    assert(CTimeSpec::DaysBetween(A, C) == 394);
+
+    assert(CTimeSpec::IsLeapYear(2000));
+    assert(!CTimeSpec::IsLeapYear(1900));
+    assert(CTimeSpec::IsLeapYear(-4));
+    for (unsigned m = 1; m <= 12; m++) {
+        static const unsigned month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        assert(CTimeSpec::DaysInMonth(2015, m) == month_days[m - 1]);
+    }
+    assert(CTimeSpec::DaysInMonth(2016, 2) == 29);
+
+    //
+    //  Against timegm, and the array versions against the scalar ones.
+    //
+    const size_t count = 4096;
+    CTimeSpec times[count];
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        times[i] = CTimeSpec((time_t)(state % 20000000000ULL) - 10000000000LL, 
+                             (long)(state >> 34) % 1000000000);
+    }
+
+    for (int months = -30; months <= 30; months += 7) {
+        CTimeSpec shifted[count];
+        for (size_t i = 0; i < count; i++)
+            shifted[i] = times[i];
+        CTimeSpec::AddMonths(shifted, count, months);
+
+        for (size_t i = 0; i < count; i++) {
+            struct timespec ts = times[i].c_timespec();
+            CTimeSpec expected(ReferenceAddMonths(ts.tv_sec, months), ts.tv_nsec);
+            assert(times[i].AddMonths(months) == expected);
+            assert(shifted[i] == expected);
+        }
+    }
+
+    CTimeSpec days[count], weeks[count], months[count], added[count];
+    int64_t between[count];
+    for (size_t i = 0; i < count; i++)
+        days[i] = weeks[i] = months[i] = added[i] = times[i];
+
+    CTimeSpec::FloorToDay(days, count);
+    CTimeSpec::FloorToWeek(weeks, count, 3);
+    CTimeSpec::FloorToMonth(months, count);
+    CTimeSpec::AddDays(added, count, -45);
+    CTimeSpec::DaysBetween(times, added, between, count);
+
+    for (size_t i = 0; i < count; i++) {
+        struct timespec ts = times[i].c_timespec();
+        struct tm tm;
+        gmtime_r(&ts.tv_sec, &tm);
+
+        assert(days[i] == times[i].FloorToDay());
+        assert(weeks[i] == times[i].FloorToWeek(3));
+        assert(months[i] == times[i].FloorToMonth());
+        assert(added[i] == times[i].AddDays(-45));
+        assert(between[i] == -45);
+
+        struct tm day_tm = tm;
+        day_tm.tm_hour = day_tm.tm_min = day_tm.tm_sec = 0;
+        assert(days[i] == CTimeSpec(timegm(&day_tm), 0));
+
+        struct tm week_tm = day_tm;
+        week_tm.tm_mday -= (tm.tm_wday + 7 - 3) % 7;
+        assert(weeks[i] == CTimeSpec(timegm(&week_tm), 0));
+
+        struct tm month_tm = day_tm;
+        month_tm.tm_mday = 1;
+        assert(months[i] == CTimeSpec(timegm(&month_tm), 0));
+
+        struct tm year_tm = month_tm;
+        year_tm.tm_mon = 0;
+        assert(times[i].FloorToYear() == CTimeSpec(timegm(&year_tm), 0));
+    }
+}
+
+
 void TestCtorsCTimeVal()
 {
     struct timeval a;
@@ -386,6 +627,46 @@ void TestCompareCTimeVal()
     assert(A == B);
     assert(A <= B);
     assert(A >= B);
+
+    A = {5, 0};
+    B = {4, 10};
+    assert(A > B);
+    assert(!(A < B));
+    assert(!(A <= B));
+    assert(B < A);
+    assert(!(B > A));
+    assert(!(B >= A));
+}
+
+
+void TestNow()
+{
+    CTimeSpec thread_start = CTimeSpec::NowThreadCpu();
+    CTimeSpec process_start = CTimeSpec::NowProcessCpu();
+    CTimeSpec end = thread_start + CTimeSpec(20);
+    volatile unsigned long sink = 0;
+
+    while (CTimeSpec::NowThreadCpu() < end) {
+        sink = sink + 1;
+    }
+
+    CTimeSpec thread_used = CTimeSpec::NowThreadCpu() - thread_start;
+    CTimeSpec process_used = CTimeSpec::NowProcessCpu() - process_start;
+    assert(thread_used >= CTimeSpec(20));
+    assert(process_used >= CTimeSpec(19));
+
+    //
+    //  An invalid clock reads as zero rather than garbage.
+    //
+    assert(CTimeSpec::NowForClock(CLOCK_BOOTTIME) > CTimeSpec());
+    assert(CTimeSpec::NowForClock((clockid_t)-1) == CTimeSpec());
+    assert(CTimeVal::NowForClock(CLOCK_MONOTONIC_COARSE) > CTimeVal());
+    assert(CTimeVal::NowForClock((clockid_t)-1) == CTimeVal());
+
+    CTimeVal tv_thread = CTimeVal::NowThreadCpu();
+    CTimeVal tv_process = CTimeVal::NowProcessCpu();
+    assert(tv_thread >= CTimeVal(20));
+    assert(tv_process >= tv_thread);
 }
 
 
@@ -441,6 +722,8 @@ int main()
     TestAddCTimeSpec();
     TestSubtractCTimeSpec();
     TestCompareCTimeSpec();
+    TestCivilCTimeSpec();
+    TestCalendarArithmeticCTimeSpec();
 
     TestCtorsCTimeVal();
     TestCoutOperatorCTimeVal();
@@ -448,6 +731,7 @@ int main()
     TestSubtractCTimeVal();
     TestCompareCTimeVal();
 
+    TestNow();
     TestConversions();
 
     std::cout << "passed" << std::endl;
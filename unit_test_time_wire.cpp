@@ -0,0 +1,284 @@
+/**
+ *  @file
+ *
+ *  Unit test code of time_wire.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_time_wire.cpp -o unit_test_time_wire
+ *
+ *  To test:
+ *  ./unit_test_time_wire
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <ctime>
+
+#include "time_utilities.hpp"
+#include "time_wire.hpp"
+
+
+/**
+ *  Scalar varint decode, the obvious way.
+ */
+static size_t ReferenceDecodeVarint(const uint8_t *in, size_t size, uint64_t *v)
+{
+    uint64_t result = 0;
+    for (size_t i = 0; i < size && i < VARINT_MAX; i++) {
+        result |= (uint64_t)(in[i] & 0x7f) << (7 * i);
+        if (!(in[i] & 0x80)) {
+            *v = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+
+void TestVarint()
+{
+    uint8_t buffer[VARINT_MAX + 8];
+
+    assert(CTimeWire::EncodeVarint(buffer, 0) == 1 && buffer[0] == 0);
+    assert(CTimeWire::EncodeVarint(buffer, 300) == 2 && buffer[0] == 0xac && buffer[1] == 0x02);
+    assert(CTimeWire::EncodeVarint(buffer, UINT64_MAX) == VARINT_MAX);
+
+    assert(CTimeWire::ZigZag(0) == 0);
+    assert(CTimeWire::ZigZag(-1) == 1);
+    assert(CTimeWire::ZigZag(1) == 2);
+    assert(CTimeWire::ZigZag(INT64_MIN) == UINT64_MAX);
+    assert(CTimeWire::UnZigZag(UINT64_MAX) == INT64_MIN);
+
+    //
+    //  Every length, through both the 8 byte and the byte at a time
+    //  paths, i.e. with and without trailing bytes after it.
+    //
+    for (int bits = 0; bits <= 64; bits++) {
+        uint64_t v = bits == 64 ? UINT64_MAX : (1ULL << bits) - 1;
+        for (int extra = 0; extra < 8; extra++) {
+            memset(buffer, 0xff, sizeof(buffer));
+            size_t n = CTimeWire::EncodeVarint(buffer, v);
+            assert(n == CTimeWire::VarintSize(v));
+
+            uint64_t decoded = 0;
+            assert(CTimeWire::DecodeVarint(buffer, n + extra, &decoded) == n);
+            assert(decoded == v);
+        }
+    }
+
+    uint64_t state = 0x0ddc0ffeebadf00dULL;
+    for (int i = 0; i < 100000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        uint8_t random[16];
+        for (int j = 0; j < 16; j++)
+            random[j] = (uint8_t)(state >> (j * 4)) | (uint8_t)((state >> j & 1) ? 0x80 : 0);
+        size_t size = (state >> 60) + 1;
+
+        uint64_t a = 1, b = 2;
+        size_t n = CTimeWire::DecodeVarint(random, size, &a);
+        assert(n == ReferenceDecodeVarint(random, size, &b));
+        assert(!n || a == b);
+    }
+
+    //
+    //  Truncated and over long.
+    //
+    uint64_t v;
+    uint8_t truncated[] = {0x80, 0x80};
+    assert(CTimeWire::DecodeVarint(truncated, 2, &v) == 0);
+    uint8_t too_long[12];
+    memset(too_long, 0x80, sizeof(too_long));
+    too_long[11] = 0;
+    assert(CTimeWire::DecodeVarint(too_long, sizeof(too_long), &v) == 0);
+}
+
+
+void TestCompact()
+{
+    uint8_t buffer[TIME_WIRE_MAX];
+    CTimeSpec values[] = {
+        CTimeSpec(0, 0), CTimeSpec(1481213045, 123456789), CTimeSpec(-1, 5),
+        CTimeSpec(LLONG_MIN, 0), CTimeSpec(LLONG_MAX, 999999999)
+    };
+    size_t sizes[] = {2, 9, 2, 11, 15};
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        size_t n = CTimeWire::EncodeCompact(buffer, values[i]);
+        assert(n == sizes[i]);
+        CTimeSpec decoded;
+        assert(CTimeWire::DecodeCompact(buffer, n, &decoded) == n);
+        assert(decoded == values[i]);
+        assert(CTimeWire::DecodeCompact(buffer, n - 1, &decoded) == 0);
+    }
+
+    //  nsec out of range.
+    uint8_t bad[] = {0x00, 0x80, 0x94, 0xeb, 0xdc, 0x03};
+    CTimeSpec decoded;
+    assert(CTimeWire::DecodeCompact(bad, sizeof(bad), &decoded) == 0);
+}
+
+
+/**
+ *  Bytes a protobuf library writes for these messages.
+ */
+void TestProtobuf()
+{
+    uint8_t buffer[TIME_WIRE_MAX];
+    CTimeSpec decoded;
+
+    const uint8_t timestamp[] = {0x08, 0xf5, 0x88, 0xa6, 0xc2, 0x05, 0x10, 0x95, 0x9a, 0xef, 0x3a};
+    assert(CTimeWire::EncodeTimestamp(buffer, CTimeSpec(1481213045, 123456789)) == sizeof(timestamp));
+    assert(memcmp(buffer, timestamp, sizeof(timestamp)) == 0);
+    assert(CTimeWire::DecodeTimestamp(timestamp, sizeof(timestamp), &decoded) == sizeof(timestamp));
+    assert(decoded == CTimeSpec(1481213045, 123456789));
+
+    const uint8_t before_epoch[] = {0x08, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
+                                    0x01, 0x10, 0x05};
+    assert(CTimeWire::EncodeTimestamp(buffer, CTimeSpec(-1, 5)) == sizeof(before_epoch));
+    assert(memcmp(buffer, before_epoch, sizeof(before_epoch)) == 0);
+    assert(CTimeWire::DecodeTimestamp(before_epoch, sizeof(before_epoch), &decoded) != 0);
+    assert(decoded == CTimeSpec(-1, 5));
+
+    //  Defaults are omitted, the empty message is the epoch.
+    assert(CTimeWire::EncodeTimestamp(buffer, CTimeSpec(0, 0)) == 0);
+    decoded = CTimeSpec(7, 7);
+    assert(CTimeWire::DecodeTimestamp(buffer, 0, &decoded) == 0);
+    assert(decoded == CTimeSpec(0, 0));
+
+    const uint8_t half[] = {0x10, 0x80, 0xb6, 0xca, 0x91, 0xfe, 0xff, 0xff, 0xff, 0xff, 0x01};
+    assert(CTimeWire::EncodeDuration(buffer, CTimeSpec(0, -500000000)) == sizeof(half));
+    assert(memcmp(buffer, half, sizeof(half)) == 0);
+    assert(CTimeWire::DecodeDuration(half, sizeof(half), &decoded) == sizeof(half));
+    assert(decoded == CTimeSpec(0, -500000000));
+
+    const uint8_t minus[] = {0x08, 0xa6, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01, 
+                             0x10, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+    assert(sizeof(minus) == TIME_WIRE_MAX);
+    assert(CTimeWire::EncodeDuration(buffer, CTimeSpec(-90, -1)) == sizeof(minus));
+    assert(memcmp(buffer, minus, sizeof(minus)) == 0);
+    assert(CTimeWire::DecodeDuration(minus, sizeof(minus), &decoded) == sizeof(minus));
+    assert(decoded == CTimeSpec(-90, -1));
+
+    //
+    //  Field order, repeats and unknown fields of every wire type.
+    //
+    const uint8_t shuffled[] = {0x10, 0x05, 0x18, 0x01, 0x08, 0x01, 0x21, 1, 2, 3, 4, 5, 6, 7, 8,
+                                0x2a, 0x02, 0xaa, 0xbb, 0x35, 1, 2, 3, 4, 0x08, 0x02};
+    assert(CTimeWire::DecodeTimestamp(shuffled, sizeof(shuffled), &decoded) == sizeof(shuffled));
+    assert(decoded == CTimeSpec(2, 5));
+
+    //
+    //  Malformed: truncated, bad wire types, out of range nanos, 
+    //  mixed signs in a Duration. None touch the output.
+    //
+    decoded = CTimeSpec(7, 7);
+    assert(CTimeWire::DecodeTimestamp(timestamp, sizeof(timestamp) - 1, &decoded) == 0);
+    const uint8_t wrong_type[] = {0x09, 1, 2, 3, 4, 5, 6, 7, 8};
+    assert(CTimeWire::DecodeTimestamp(wrong_type, sizeof(wrong_type), &decoded) == 0);
+    const uint8_t group[] = {0x0b};
+    assert(CTimeWire::DecodeTimestamp(group, sizeof(group), &decoded) == 0);
+    const uint8_t long_length[] = {0x2a, 0x05, 0x00};
+    assert(CTimeWire::DecodeTimestamp(long_length, sizeof(long_length), &decoded) == 0);
+    assert(CTimeWire::DecodeTimestamp(half, sizeof(half), &decoded) == 0);
+    const uint8_t mixed_signs[] = {0x08, 0x01, 0x10, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 
+                                   0xff, 0xff, 0x01};
+    assert(CTimeWire::DecodeDuration(mixed_signs, sizeof(mixed_signs), &decoded) == 0);
+    assert(decoded == CTimeSpec(7, 7));
+}
+
+
+void TestDelta()
+{
+    const CTimeSpec base {1481213045, 0};
+    uint8_t buffer[VARINT_MAX];
+    CTimeSpec decoded;
+
+    assert(CTimeWire::EncodeDelta(buffer, base, base) == 1);
+    assert(CTimeWire::EncodeDelta(buffer, base + CTimeSpec(0, 63), base) == 1);
+    assert(CTimeWire::EncodeDelta(buffer, base + CTimeSpec(1, 0), base) == 5);
+    size_t n = CTimeWire::EncodeDelta(buffer, CTimeSpec(1481213044, 999999999), base);
+    assert(n == 1);
+    assert(CTimeWire::DecodeDelta(buffer, n, base, &decoded) == 1);
+    assert(decoded == CTimeSpec(1481213044, 999999999));
+
+    //  About 292 years is the limit.
+    assert(CTimeWire::EncodeDelta(buffer, base + CTimeSpec(9223372036LL, 0), base) != 0);
+    assert(CTimeWire::EncodeDelta(buffer, base + CTimeSpec(9223372037LL, 0), base) == 0);
+    assert(CTimeWire::EncodeDelta(buffer, base - CTimeSpec(9223372037LL, 0), base) == 0);
+
+    //
+    //  A column, against the one at a time calls.
+    //
+    const size_t count = 5000;
+    std::vector<CTimeSpec> values(count);
+    uint64_t state = 0xabcdef0123456789ULL;
+    for (size_t i = 0; i < count; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        values[i] = base + CTimeSpec(0, (long)(state % 2000000000)) - CTimeSpec(1, 0);
+        if (i % 97 == 0)
+            values[i] = base + CTimeSpec((time_t)(state >> 34), 0);
+    }
+
+    std::vector<uint8_t> column(count * VARINT_MAX);
+    size_t size = CTimeWire::EncodeDeltas(column.data(), values.data(), count, base);
+    assert(size > 0 && size < count * 6);
+
+    std::vector<CTimeSpec> back(count);
+    assert(CTimeWire::DecodeDeltas(column.data(), size, base, back.data(), count) == size);
+    size_t offset = 0;
+    for (size_t i = 0; i < count; i++) {
+        assert(back[i] == values[i]);
+        size_t m = CTimeWire::DecodeDelta(column.data() + offset, size - offset, base, &decoded);
+        assert(m > 0 && decoded == values[i]);
+        offset += m;
+    }
+    assert(offset == size);
+
+    assert(CTimeWire::DecodeDeltas(column.data(), size - 1, base, back.data(), count) == 0);
+    CTimeSpec far[] = {base, CTimeSpec(LLONG_MAX, 0)};
+    assert(CTimeWire::EncodeDeltas(column.data(), far, 2, base) == 0);
+}
+
+
+int main()
+{
+    std::cout << "Unit testing time_wire.hpp" << std::endl;
+
+    TestVarint();
+    TestCompact();
+    TestProtobuf();
+    TestDelta();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ *  @file
+ *
+ *  Unit test code of tsc_clock.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_tsc_clock.cpp -o unit_test_tsc_clock
+ *
+ *  To test:
+ *  ./unit_test_tsc_clock
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+#include <ctime>
+
+#include "time_utilities.hpp"
+#include "tsc_clock.hpp"
+
+
+/**
+ *  Allowed disagreement between the converted counter and 
+ *  CLOCK_MONOTONIC_RAW. Generous, since the test may be 
+ *  descheduled between the two reads.
+ */
+#define TOLERANCE_MS    (5)
+
+
+void TestCalibration()
+{
+    const CTscClock &tsc = CTscClock::Instance();
+
+    std::cout << "counter frequency " << tsc.TicksPerSecond() / 1e6 << " MHz" << std::endl;
+    assert(tsc.TicksPerSecond() > 1e6);
+    assert(tsc.TicksPerSecond() < 1e11);
+}
+
+
+void TestConversionRoundTrip()
+{
+    const CTscClock &tsc = CTscClock::Instance();
+    CTimeSpec durations[] = {
+        CTimeSpec {0, 0}, CTimeSpec {0, 1000}, CTimeSpec {0, 999999999},
+        CTimeSpec {1, 0}, CTimeSpec {3600, 123456789}, CTimeSpec {86400 * 365, 1}
+    };
+
+    for (const CTimeSpec &d : durations) {
+        CTimeSpec back = tsc.TicksToDuration(tsc.DurationToTicks(d));
+        CTimeSpec error = back > d ? back - d : d - back;
+        //
+        //  One tick of rounding each way, plus the fixed point 
+        //  error growing with the size of the value.
+        //
+        struct timespec ts = d.c_timespec();
+        long allowed = 2 + (long)(ts.tv_sec * 2);
+        assert(error <= CTimeSpec(0, allowed));
+    }
+
+    uint64_t ticks = CTscClock::Read();
+    assert(tsc.ToTimeSpec(ticks + 1000) > tsc.ToTimeSpec(ticks));
+    assert(tsc.ToTimeSpec(ticks - 1000) < tsc.ToTimeSpec(ticks));
+}
+
+
+void TestTracksMonotonicRaw()
+{
+    const CTscClock &tsc = CTscClock::Instance();
+    struct timespec pause = CTimeSpec(30).c_timespec();
+
+    for (int i = 0; i < 3; i++) {
+        CTimeSpec raw = CTimeSpec::NowMonotonicRaw();
+        CTimeSpec converted = tsc.Now();
+        CTimeSpec error = raw > converted ? raw - converted : converted - raw;
+        assert(error < CTimeSpec(TOLERANCE_MS));
+        nanosleep(&pause, nullptr);
+    }
+}
+
+
+void TestMonotonic()
+{
+    const CTscClock &tsc = CTscClock::Instance();
+    CTimeSpec previous = tsc.Now();
+
+    for (int i = 0; i < 100000; i++) {
+        CTimeSpec now = tsc.Now();
+        assert(now >= previous);
+        previous = now;
+    }
+}
+
+
+int main()
+{
+    std::cout << "Unit testing tsc_clock.hpp" << std::endl;
+
+    TestCalibration();
+    TestConversionRoundTrip();
+    TestTracksMonotonicRaw();
+    TestMonotonic();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
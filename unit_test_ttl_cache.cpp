@@ -0,0 +1,275 @@
+/**
+ *  @file
+ *
+ *  Unit test code of ttl_cache.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_ttl_cache.cpp -o unit_test_ttl_cache
+ *
+ *  To test:
+ *  ./unit_test_ttl_cache
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <iostream>
+#include <string>
+#include <map>
+#include <cstdlib>
+#include <cassert>
+#include <cstdint>
+
+#include "time_utilities.hpp"
+#include "ttl_cache.hpp"
+
+
+static CTimeSpec Ms(int64_t ms)
+{
+    return CTimeSpec((time_t)(ms / 1000), (long)(ms % 1000) * 1000000L);
+}
+
+
+void TestLazyExpiry()
+{
+    CTtlCache<std::string, int> cache(Ms(10));
+    int value = 0;
+
+    cache.SetSweepBudget(0);
+    cache.Put("a", 1, Ms(100), Ms(1000));
+    cache.Put("b", 2, Ms(200), Ms(1000));
+    assert(cache.Size() == 2);
+
+    assert(cache.Get("a", &value, Ms(1099)) && value == 1);
+    assert(!cache.Get("a", &value, Ms(1100)) && value == 1);
+    assert(cache.Size() == 1);
+    assert(cache.Get("b", &value, Ms(1100)) && value == 2);
+    assert(!cache.Get("c", &value, Ms(1100)));
+
+    //
+    //  Replacing resets the TTL.
+    //
+    cache.Put("b", 3, Ms(200), Ms(1150));
+    assert(cache.Get("b", &value, Ms(1300)) && value == 3);
+    assert(!cache.Get("b", &value, Ms(1350)));
+
+    assert(cache.Stats().hits == 3);
+    assert(cache.Stats().misses == 3);
+    assert(cache.Stats().expired_on_access == 2);
+    assert(cache.Stats().puts == 3);
+
+    cache.Put("d", 4, Ms(10), Ms(2000));
+    assert(cache.Erase("d") && !cache.Erase("d"));
+    cache.ResetStats();
+    assert(cache.Stats().puts == 0);
+}
+
+
+/**
+ *  The queues reclaim entries nobody reads again, a few per 
+ *  operation.
+ */
+void TestQueueSweep()
+{
+    CTtlCache<int, int> cache(Ms(10), 16);
+    int value;
+
+    cache.SetSweepBudget(0);
+    for (int i = 0; i < 100; i++)
+        cache.Put(i, i, Ms(50 + i), Ms(0));
+    assert(cache.Size() == 100 && cache.Queued() == 100);
+
+    //
+    //  Nothing is due before its bucket starts.
+    //
+    assert(cache.Expire(Ms(49), 1000) == 0);
+    assert(cache.Expire(Ms(50), 1000) == 1);
+    assert(cache.Size() == 99);
+
+    //
+    //  Bounded work per call.
+    //
+    size_t expired = cache.Expire(Ms(200), 10);
+    assert(expired > 0 && expired <= 10);
+    assert(cache.SweepLag(Ms(200)) > CTimeSpec(0, 0));
+    while (cache.Expire(Ms(200), 10))
+        ;
+    assert(cache.Size() == 0 && cache.Queued() == 0);
+    assert(cache.Stats().expired_by_sweep == 100);
+    assert(cache.SweepLag(Ms(200)) <= Ms(10));
+
+    //
+    //  Entries past the ring, stale queue copies of replaced and 
+    //  erased keys.
+    //
+    cache.Put(1, 1, Ms(1000), Ms(1000));
+    cache.Put(2, 2, Ms(20), Ms(1000));
+    cache.Put(2, 3, Ms(500), Ms(1000));
+    cache.Put(3, 3, Ms(20), Ms(1000));
+    assert(cache.Erase(3));
+    assert(cache.Queued() == 4);
+
+    assert(cache.Expire(Ms(1400), 1000) == 0);
+    assert(cache.Stats().stale == 2);
+    assert(cache.Stats().requeued >= 1);
+    assert(cache.Get(1, &value, Ms(1400)) && value == 1);
+    assert(cache.Get(2, &value, Ms(1400)) && value == 3);
+
+    cache.Expire(Ms(2000), 1000);
+    assert(cache.Size() == 0 && cache.Queued() == 0);
+}
+
+
+/**
+ *  A one queue ring requeues every entry that outlives a bucket 
+ *  onto the queue being swept; none may be lost on the way.
+ */
+void TestOneQueue()
+{
+    CTtlCache<int, int> cache(Ms(10), 1);
+    int value;
+
+    cache.SetSweepBudget(0);
+    for (int i = 0; i < 50; i++)
+        cache.Put(i, i, Ms(10 * i + 5), Ms(0));
+
+    for (int64_t now = 0; now <= 600; now += 10) {
+        cache.Expire(Ms(now), 1000);
+        for (int i = 0; i < 50; i++) {
+            bool live = 10 * i + 5 > now;
+            assert(cache.Get(i, &value, Ms(now)) == live);
+        }
+        assert(cache.Queued() >= cache.Size());
+    }
+    assert(cache.Size() == 0);
+    assert(cache.Stats().expired_on_access == 0);
+    assert(cache.Stats().expired_by_sweep == 50);
+    assert(cache.Stats().requeued > 0);
+
+    cache.Expire(Ms(1000), 1000);
+    assert(cache.Queued() == 0);
+}
+
+
+/**
+ *  After a long idle period the sweep catches up within one turn 
+ *  of the ring, keeping entries that are still live.
+ */
+void TestIdleCatchUp()
+{
+    CTtlCache<int, int> cache;
+    int value;
+
+    for (int i = 0; i < 100; i++)
+        cache.Put(i, i, Ms(50), Ms(0));
+    cache.Put(1000, 1000, CTimeSpec(7200, 0), Ms(0));
+
+    CTimeSpec now(3600, 0);
+    int ops = 0;
+    while (cache.SweepLag(now) > Ms(10) || cache.Size() > 1) {
+        assert(!cache.Get(-1, &value, now));
+        assert(++ops <= (1024 + 100) / 4 + 2);
+    }
+    assert(cache.Stats().expired_by_sweep == 100);
+    assert(cache.Get(1000, &value, now) && value == 1000);
+
+    //
+    //  The long lived entry is still queued, and swept on time.
+    //
+    while (cache.Expire(CTimeSpec(7200, 0), 1000))
+        ;
+    assert(cache.Size() == 0 && cache.Queued() == 0);
+    assert(cache.Stats().expired_by_sweep == 101);
+}
+
+
+/**
+ *  Ordinary operations drive the sweep, and keep the cache no 
+ *  bigger than what is live plus a bucket or so.
+ */
+void TestAmortizedSweep()
+{
+    CTtlCache<int, int> cache(Ms(1), 64);
+    std::map<int, int64_t> expires;
+    int value;
+
+    for (int64_t now = 0; now < 5000; now++) {
+        for (int j = 0; j < 10; j++) {
+            int key = (int)((now * 10 + j) % 3000);
+            cache.Put(key, key, Ms(20), Ms(now));
+            expires[key] = now + 20;
+        }
+        size_t live = 0;
+        for (const auto &e : expires)
+            live += e.second > now;
+        assert(cache.Size() <= live + 20);
+    }
+
+    for (const auto &e : expires)
+        assert(cache.Get(e.first, &value, Ms(4999)) == (e.second > 4999));
+}
+
+
+void TestSampling()
+{
+    CTtlCache<int, int> cache(Ms(10));
+    cache.SetSweepBudget(0);
+    cache.SetSampleCount(8);
+
+    for (int i = 0; i < 1000; i++)
+        cache.Put(i, i, Ms(10), Ms(0));
+    for (int i = 0; i < 1000; i++)
+        cache.Put(1000 + i, i, Ms(1000), Ms(100));
+    assert(cache.Stats().expired_by_sample > 0);
+    assert(cache.Size() < 2000);
+    assert(cache.Stats().expired_by_sweep == 0);
+}
+
+
+void TestClock()
+{
+    CTtlCache<int, int> cache;
+    int value;
+
+    cache.Put(1, 1, CTimeSpec(60, 0));
+    assert(cache.Get(1, &value) && value == 1);
+    cache.Put(2, 2, CTimeSpec(-1, 0));
+    assert(!cache.Get(2, &value));
+    cache.Clear();
+    assert(cache.Size() == 0 && cache.Queued() == 0);
+}
+
+
+int main()
+{
+    std::cout << "Unit testing ttl_cache.hpp" << std::endl;
+
+    TestLazyExpiry();
+    TestQueueSweep();
+    TestOneQueue();
+    TestIdleCatchUp();
+    TestAmortizedSweep();
+    TestSampling();
+    TestClock();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
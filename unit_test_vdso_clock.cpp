@@ -0,0 +1,126 @@
+/**
+ *  @file
+ *
+ *  Unit test code of vdso_clock.hpp
+ *
+ *  To compile:
+ *  g++ -Wall -std=c++11 unit_test_vdso_clock.cpp -o unit_test_vdso_clock
+ *
+ *  To test:
+ *  ./unit_test_vdso_clock
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#define TIME_UTILITIES_USE_VDSO
+
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+
+#include "time_utilities.hpp"
+#include "vdso_clock.hpp"
+
+
+static int64_t Ns(const struct timespec &ts)
+{
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+void TestLookup()
+{
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+    assert(CVdsoClock::Available());
+    assert(CVdsoClock::Lookup(VDSO_CLOCK_GETTIME_NAME) != NULL);
+#endif
+    assert(CVdsoClock::Lookup("no_such_vdso_symbol") == NULL);
+    assert(CVdsoClock::Lookup("") == NULL);
+}
+
+
+void TestAgreesWithLibc()
+{
+    const clockid_t clocks[] = {CLOCK_MONOTONIC, CLOCK_MONOTONIC_RAW, CLOCK_BOOTTIME};
+    for (clockid_t clock : clocks) {
+        for (int i = 0; i < 1000; i++) {
+            struct timespec a, b, c;
+            assert(clock_gettime(clock, &a) == 0);
+            assert(CVdsoClock::GetTime(clock, &b) == 0);
+            assert(clock_gettime(clock, &c) == 0);
+            assert(b.tv_nsec >= 0 && b.tv_nsec < 1000000000L);
+            assert(Ns(a) <= Ns(b) && Ns(b) <= Ns(c));
+        }
+    }
+
+    //
+    //  Realtime can be stepped, so only ask for closeness.
+    //
+    struct timespec libc, vdso;
+    assert(clock_gettime(CLOCK_REALTIME, &libc) == 0);
+    assert(CVdsoClock::GetTime(CLOCK_REALTIME, &vdso) == 0);
+    assert(llabs(Ns(vdso) - Ns(libc)) < 1000000000LL);
+
+    //
+    //  Clocks the vDSO does not serve fall back to the kernel inside
+    //  the vDSO itself.
+    //
+    assert(CVdsoClock::GetTime(CLOCK_PROCESS_CPUTIME_ID, &vdso) == 0);
+    assert(CVdsoClock::GetTime(CLOCK_THREAD_CPUTIME_ID, &vdso) == 0);
+}
+
+
+void TestErrors()
+{
+    struct timespec ts;
+    errno = 0;
+    assert(CVdsoClock::GetTime((clockid_t)12345, &ts) == -1);
+    assert(errno == EINVAL);
+}
+
+
+void TestRoute()
+{
+    CTimeSpec before = CTimeSpec::NowMonotonic();
+    CTimeSpec now = CTimeSpec::NowForClock(CLOCK_MONOTONIC);
+    CTimeSpec after = CTimeSpec::NowMonotonic();
+    assert(before <= now && now <= after);
+
+    assert(CTimeSpec::NowForClock((clockid_t)12345) == CTimeSpec(0, 0));
+}
+
+
+int main()
+{
+    std::cout << "Unit testing vdso_clock.hpp" << std::endl;
+
+    TestLookup();
+    TestAgreesWithLibc();
+    TestErrors();
+    TestRoute();
+
+    std::cout << "passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,226 @@
+/**
+ *  @file
+ *
+ *  clock_gettime() straight through the kernel's vDSO, without the
+ *  libc wrapper.
+ *
+ *  The vDSO is a small ELF shared object the kernel maps into every 
+ *  process; its clock_gettime reads the clock from shared memory 
+ *  without entering the kernel. libc normally finds and calls it, 
+ *  adding a little bookkeeping per call. CVdsoClock finds it itself,
+ *  the first time it is used, from getauxval(AT_SYSINFO_EHDR): the 
+ *  program headers give the dynamic section, which gives the symbol
+ *  and string tables, which are searched for the entry point. If 
+ *  any of that fails (no vDSO, an architecture whose vDSO calling 
+ *  convention differs from C's) every call goes to the 
+ *  clock_gettime system call instead.
+ *
+ *  Defining TIME_UTILITIES_USE_VDSO before including time_utilities.hpp
+ *  routes CTimeSpec::NowForClock(), and so every Now*() factory, 
+ *  through here.
+ *
+ *  Self contained, since time_utilities.hpp includes it.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2016, Michael Becker (michael.f.becker@gmail.com)
+ *  
+ *  Permission is hereby granted, free of charge, to any person obtaining a 
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ *  and/or sell copies of the Software, and to permit persons to whom the 
+ *  Software is furnished to do so, subject to the following conditions:
+ *  
+ *  The above copyright notice and this permission notice shall be included 
+ *  in all copies or substantial portions of the Software.
+ *  
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ *  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ *  CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT 
+ *  OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR 
+ *  THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef VDSO_CLOCK_HPP__
+#define VDSO_CLOCK_HPP__
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#ifdef __linux__
+#include <elf.h>
+#include <link.h>
+#include <sys/auxv.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ *  Where the vDSO entry point is known and callable as a plain C
+ *  function taking the libc struct timespec.
+ */
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__) || \
+    (defined(__riscv) && __riscv_xlen == 64))
+#define VDSO_CLOCK_SUPPORTED
+#endif
+
+#if defined(__aarch64__)
+#define VDSO_CLOCK_GETTIME_NAME     "__kernel_clock_gettime"
+#else
+#define VDSO_CLOCK_GETTIME_NAME     "__vdso_clock_gettime"
+#endif
+
+
+class CVdsoClock
+{
+    public:
+
+        typedef int (*GetTimeFunction)(clockid_t, struct timespec *);
+
+        /**
+         *  clock_gettime() through the vDSO, or the system call.
+         *  @return 0, or -1 with errno set, as clock_gettime().
+         */
+        static int GetTime(clockid_t clock, struct timespec *ts)
+        {
+            GetTimeFunction function = Function();
+            if (function) {
+                int rc = function(clock, ts);
+                if (rc == 0)
+                    return 0;
+                errno = rc < 0 ? -rc : EINVAL;
+                return -1;
+            }
+#ifdef __linux__
+            return (int)syscall(SYS_clock_gettime, clock, ts);
+#else
+            return clock_gettime(clock, ts);
+#endif
+        }
+
+        /**
+         *  True if calls go through the vDSO rather than the system
+         *  call.
+         */
+        static bool Available()
+        {
+            return Function() != NULL;
+        }
+
+        /**
+         *  Address of a function exported by the vDSO, e.g. 
+         *  "__vdso_time", or NULL.
+         */
+        static void *Lookup(const char *name)
+        {
+#ifdef VDSO_CLOCK_SUPPORTED
+            uintptr_t base = (uintptr_t)getauxval(AT_SYSINFO_EHDR);
+            if (!base)
+                return NULL;
+
+            const ElfW(Ehdr) *header = (const ElfW(Ehdr) *)base;
+            if (memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 || 
+                header->e_ident[EI_CLASS] != (sizeof(void *) == 8 ? ELFCLASS64 : ELFCLASS32))
+                return NULL;
+
+            //
+            //  The load bias is where the first PT_LOAD landed, less 
+            //  the address it was linked at.
+            //
+            const ElfW(Phdr) *program = (const ElfW(Phdr) *)(base + header->e_phoff);
+            uintptr_t bias = 0;
+            bool loaded = false;
+            const ElfW(Dyn) *dynamic = NULL;
+            for (int i = 0; i < header->e_phnum; i++) {
+                if (program[i].p_type == PT_LOAD && !loaded) {
+                    bias = base + program[i].p_offset - program[i].p_vaddr;
+                    loaded = true;
+                } else if (program[i].p_type == PT_DYNAMIC) {
+                    dynamic = (const ElfW(Dyn) *)(base + program[i].p_offset);
+                }
+            }
+            if (!loaded || !dynamic)
+                return NULL;
+
+            const char *strings = NULL;
+            const ElfW(Sym) *symbols = NULL;
+            const uint32_t *hash = NULL;
+            const uint32_t *gnu_hash = NULL;
+            for (const ElfW(Dyn) *d = dynamic; d->d_tag != DT_NULL; d++) {
+                switch (d->d_tag) {
+                    case DT_STRTAB:   strings = (const char *)(bias + d->d_un.d_ptr); break;
+                    case DT_SYMTAB:   symbols = (const ElfW(Sym) *)(bias + d->d_un.d_ptr); break;
+                    case DT_HASH:     hash = (const uint32_t *)(bias + d->d_un.d_ptr); break;
+                    case DT_GNU_HASH: gnu_hash = (const uint32_t *)(bias + d->d_un.d_ptr); break;
+                    default: break;
+                }
+            }
+            if (!strings || !symbols)
+                return NULL;
+
+            uint32_t count = hash ? hash[1] : gnu_hash ? GnuHashSymbolCount(gnu_hash) : 0;
+            for (uint32_t i = 0; i < count; i++) {
+                const ElfW(Sym) &symbol = symbols[i];
+                //
+                //  st_info is bind << 4 | type for both ELF classes.
+                //
+                unsigned type = symbol.st_info & 0xf;
+                unsigned bind = symbol.st_info >> 4;
+                if (type != STT_FUNC || (bind != STB_GLOBAL && bind != STB_WEAK) || 
+                    symbol.st_shndx == SHN_UNDEF)
+                    continue;
+                if (strcmp(strings + symbol.st_name, name) == 0)
+                    return (void *)(bias + symbol.st_value);
+            }
+#else
+            (void)name;
+#endif
+            return NULL;
+        }
+
+    private:
+
+        /**
+         *  Resolved once, on first use.
+         */
+        static GetTimeFunction Function()
+        {
+            static const GetTimeFunction function = 
+                (GetTimeFunction)Lookup(VDSO_CLOCK_GETTIME_NAME);
+            return function;
+        }
+
+#ifdef VDSO_CLOCK_SUPPORTED
+        /**
+         *  A DT_GNU_HASH table has no symbol count: it is one past 
+         *  the last symbol of the highest bucket's chain, whose 
+         *  entry has the low bit set.
+         */
+        static uint32_t GnuHashSymbolCount(const uint32_t *table)
+        {
+            uint32_t buckets = table[0];
+            uint32_t offset = table[1];
+            uint32_t bloom_words = table[2];
+            const uint32_t *bucket = table + 4 + bloom_words * (sizeof(ElfW(Addr)) / 4);
+            const uint32_t *chain = bucket + buckets;
+
+            uint32_t last = 0;
+            for (uint32_t i = 0; i < buckets; i++) {
+                if (bucket[i] > last)
+                    last = bucket[i];
+            }
+            if (last < offset)
+                return offset;
+            while ((chain[last - offset] & 1) == 0)
+                last++;
+            return last + 1;
+        }
+#endif
+};
+
+
+#endif